@@ -35,5 +35,6 @@ END {
     } else {
         print "Hiba: Nem található feldolgozható adat a 'timings.log' fájlban a megadott formátumban.";
         print "Ellenőrizd, hogy a log sorai tartalmazzák-e a 'Total: ...ms' és 'Threads: ...' részeket.";
+        print "A lépésenkénti sorokat a program csak a --step-log kapcsolóval írja ki.";
     }
 }
@@ -0,0 +1,118 @@
+#!/bin/sh
+# Makro benchmark: a bench_scenarios.txt forgatókönyveit futtatja, az eredményeket JSON tömbként
+# a bench_results.json-ba írja, majd összeveti őket az alapvonallal (bench_baseline.json).
+#
+# Használat: ./bench.sh [--update-baseline]
+# Környezeti változók:
+#   BENCH_TOLERANCE  megengedett relatív romlás (alapértelmezés: 0.20, azaz 20%)
+#   BENCH_FILTER     csak az ezt a részszót tartalmazó nevű forgatókönyvek futnak
+#   BENCH_BINARY     a szimulátor (alapértelmezés: ./ecosystem_simulator)
+#
+# Regresszió: steps_per_sec vagy entity_updates_per_sec az alapvonal (1 - tolerancia)-szorosa alá
+# esik, vagy peak_rss_kb az (1 + tolerancia)-szorosa fölé nő. Ilyenkor a kilépési kód 1.
+# Túlélés: ha egy forgatókönyv végére minden faj kihal, a mérés egy üres világot mérne; ez is hiba.
+
+BINARY=${BENCH_BINARY:-./ecosystem_simulator}
+SCENARIOS=bench_scenarios.txt
+RESULTS=bench_results.json
+BASELINE=bench_baseline.json
+TOLERANCE=${BENCH_TOLERANCE:-0.20}
+SEED=42
+
+if [ ! -x "$BINARY" ]; then
+    echo "Hiba: a szimulátor nem található: $BINARY" >&2
+    exit 1
+fi
+
+lines=$(mktemp)
+trap 'rm -f "$lines"' EXIT
+
+# Forgatókönyvek futtatása; minden futás egy JSON sort ír a stdout-ra
+grep -v '^[[:space:]]*\(#\|$\)' "$SCENARIOS" | while read -r name args; do
+    case "$name" in
+    *"${BENCH_FILTER:-}"*) ;;
+    *) continue ;;
+    esac
+    echo "== $name" >&2
+    # shellcheck disable=SC2086 # az argumentumokat szándékosan szavakra bontjuk
+    if ! "$BINARY" --headless --seed "$SEED" $args --bench-json "$name" 2>/dev/null >>"$lines"; then
+        echo "Hiba: a(z) $name forgatókönyv sikertelen" >&2
+        exit 1
+    fi
+    tail -n 1 "$lines" >&2
+    survivors=$(tail -n 1 "$lines" | awk '{
+        total = 0
+        for (i = 1; i < NF; i++)
+            if ($i ~ /^"final_(plants|herbivores|carnivores)":$/)
+                total += $(i + 1) + 0
+        print total
+    }')
+    if [ "$survivors" -eq 0 ]; then
+        echo "Hiba: a(z) $name forgatókönyv végére minden faj kihalt; hangold az egyedszámot vagy a lépésszámot" >&2
+        exit 1
+    fi
+done || exit 1
+
+# JSON tömb összeállítása (soronként egy objektum)
+awk 'BEGIN { print "[" } { printf "%s  %s", (NR > 1 ? ",\n" : ""), $0 } END { print "\n]" }' "$lines" >"$RESULTS"
+echo "Eredmények: $RESULTS" >&2
+
+if [ "${1:-}" = "--update-baseline" ]; then
+    cp "$RESULTS" "$BASELINE"
+    echo "Alapvonal frissítve: $BASELINE" >&2
+    exit 0
+fi
+if [ ! -f "$BASELINE" ]; then
+    echo "Nincs alapvonal ($BASELINE); a 'make bench-baseline' hozza létre." >&2
+    exit 0
+fi
+
+# Összevetés: mindkét fájl soronként egy lapos objektumot tartalmaz, a mezőket névvel keressük
+awk -v tolerance="$TOLERANCE" '
+function field(line, key,    pattern, value) {
+    pattern = "\"" key "\": "
+    if (!index(line, pattern))
+        return ""
+    value = substr(line, index(line, pattern) + length(pattern))
+    sub(/[,}].*/, "", value)
+    gsub(/"/, "", value)
+    return value
+}
+function change(value, base) {
+    return base > 0 ? 100 * (value / base - 1) : 0
+}
+FNR == 1 { file++ }
+/"scenario"/ {
+    name = field($0, "scenario")
+    if (file == 1) {
+        base_sps[name] = field($0, "steps_per_sec") + 0
+        base_eps[name] = field($0, "entity_updates_per_sec") + 0
+        base_rss[name] = field($0, "peak_rss_kb") + 0
+        base_threads[name] = field($0, "threads")
+        next
+    }
+    if (!(name in base_sps)) {
+        printf "%-26s nincs alapvonal\n", name
+        next
+    }
+    sps = field($0, "steps_per_sec") + 0
+    eps = field($0, "entity_updates_per_sec") + 0
+    rss = field($0, "peak_rss_kb") + 0
+    status = "OK"
+    if (sps < base_sps[name] * (1 - tolerance) || eps < base_eps[name] * (1 - tolerance) ||
+        rss > base_rss[name] * (1 + tolerance)) {
+        status = "REGRESSZIÓ"
+        failed = 1
+    }
+    printf "%-26s steps/s %10.2f (%+6.1f%%)  updates/s %12.0f (%+6.1f%%)  RSS %8d KB (%+6.1f%%)  %s%s\n",
+           name, sps, change(sps, base_sps[name]), eps, change(eps, base_eps[name]),
+           rss, change(rss, base_rss[name]), status,
+           (field($0, "threads") != base_threads[name] ? " (eltérő szálszám: " base_threads[name] " -> " field($0, "threads") ")" : "")
+}
+END {
+    if (failed) {
+        printf "HIBA: teljesítményregresszió (tolerancia: %.0f%%)\n", 100 * tolerance
+        exit 1
+    }
+    printf "OK: nincs regresszió (tolerancia: %.0f%%)\n", 100 * tolerance
+}' "$BASELINE" "$RESULTS"
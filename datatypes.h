@@ -11,6 +11,15 @@ typedef enum
     CARNIVORE
 } EntityType;
 
+// Üres próbafajok száma a fajtábla végén (make species-check): így ellenőrizhető, hogy a
+// típusonkénti táblák és kernelek 8-nál több típussal is fordulnak és ugyanazt számolják.
+// A próbafajok sosem népesülnek be, a szimuláció eredménye tehát nem változik.
+#ifndef ECOSIM_EXTRA_SPECIES
+#define ECOSIM_EXTRA_SPECIES 0
+#endif
+
+#define ENTITY_TYPE_COUNT (4 + ECOSIM_EXTRA_SPECIES) // EMPTY, PLANT, HERBIVORE, CARNIVORE (és a próbafajok)
+
 typedef struct
 {
     int x;
@@ -18,6 +27,21 @@ typedef struct
 } Coordinates;
 
 typedef struct Entity Entity;
+typedef struct DeterministicScratch DeterministicScratch;
+typedef struct LifecycleBuffers LifecycleBuffers;
+typedef struct PlantLayer PlantLayer;
+typedef struct PopulationStats PopulationStats;
+typedef struct MetricsExporter MetricsExporter;
+typedef struct LatencyRecorder LatencyRecorder;
+typedef struct WorldArena WorldArena;
+typedef struct FreeCellIndex FreeCellIndex;
+typedef struct Perception Perception;
+typedef struct TaskGraph TaskGraph;
+typedef struct ShmPublisher ShmPublisher;
+typedef struct Topology Topology;
+typedef struct EventLog EventLog;
+typedef struct PhaseTuner PhaseTuner;
+typedef struct ChunkDirectory ChunkDirectory;
 
 typedef struct
 {
@@ -39,6 +63,26 @@ typedef struct
     int next_entity_capacity; // A 'next_entities' tömb kapacitása
 
     int next_entity_id; // Következő kiosztandó egyedi ID
+
+    int population_cap[ENTITY_TYPE_COUNT]; // Létszámplafon típusonként (alapból a fajtábla max_population-je)
+
+    bool deterministic;                 // Determinisztikus mód: az eredmény független a szálak számától
+    unsigned long long seed;            // Determinisztikus módban a véletlen folyamok alapja
+    DeterministicScratch *det_scratch;  // Determinisztikus mód segédpufferei (NULL, ha nincs bekapcsolva)
+    LifecycleBuffers *lifecycle;        // A lépés eleji vektorizált életciklus-menet eredménye
+    PlantLayer *plants;                 // Sűrű növényréteg (NULL: a növények Entity-ként élnek)
+    PopulationStats *stats;             // Lépésenkénti populációs statisztika (NULL: kikapcsolva)
+    MetricsExporter *metrics;           // Metrika-exportáló (nem a világ birtokolja; NULL: kikapcsolva)
+    LatencyRecorder *latency;           // Lépésidő-hisztogramok (nem a világ birtokolja; NULL: nincs mérés)
+    WorldArena *arena;                  // A világ puffereit tartalmazó egyetlen leképezés
+    FreeCellIndex *free_cells;          // Szabad cellák indexe a véletlen üres cella választáshoz
+    Perception *perception;             // Állatonkénti érzékelés az aktuális fázisra (entities indexe szerint)
+    TaskGraph *task_graph;              // Sávos feladatgráf a fázisok átlapolásához (NULL: fázisonként sorban)
+    ShmPublisher *publisher;            // Osztott memóriás állapotpublikáló (nem a világ birtokolja; NULL: kikapcsolva)
+    Topology *topology;                 // Peremes vagy tórusz topológia: szomszéd- és körbefutási táblák
+    EventLog *events;                   // Bináris eseménynapló (nem a világ birtokolja; NULL: kikapcsolva)
+    PhaseTuner *tuner;                  // Fázisonkénti soros/párhuzamos döntés (NULL: mindig a teljes csapat)
+    ChunkDirectory *chunks;             // Ritka (darabolt) rácstárolás könyvtára (NULL: sűrű rács; lásd world_chunks.h)
 } World;
 
 struct Entity
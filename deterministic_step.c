@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <omp.h>
+
+#include "deterministic_step.h"
+#include "entity_actions.h"
+#include "species.h"
+#include "simulation_constants.h"
+#include "world_utils.h"
+#include "sim_random.h"
+#include "lifecycle_kernel.h"
+#include "population_stats.h"
+#include "metrics_exporter.h"
+#include "plant_layer.h"
+#include "memory_accounting.h"
+#include "event_log.h"
+#include "world_chunks.h"
+
+#define OUTPUTS_PER_ENTITY 2 // Önmaga + legfeljebb egy utód lépésenként
+
+// Entitásonkénti állapot egy fázison belül
+enum
+{
+    DET_IDLE,    // Nem ebben a fázisban dolgozzuk fel
+    DET_PENDING, // Még nincs végleges eredménye (első kör, vagy elvesztett egy foglalást)
+    DET_DONE     // Végleges eredmény a kimeneti helyein
+};
+
+struct DeterministicScratch
+{
+    int capacity;                 // Az entitásonkénti tömbök mérete
+    int *claims;                  // Célpont index -> a legkisebb foglaló entitás indexe (INT_MAX, ha nincs)
+    int *cell_claims;             // Növényréteg cellánkénti foglalásai (csak növényréteg esetén)
+    int cell_count;
+    int *reserved;                // Entitás index -> az általa foglalt célpont indexe (-1, ha nincs);
+                                  // capacity feletti érték a növényréteg (érték - capacity) cellája
+    unsigned char *status;        // DET_IDLE / DET_PENDING / DET_DONE
+    unsigned char *output_counts; // Entitásonként kibocsátott állapotok száma
+    Entity *outputs;              // OUTPUTS_PER_ENTITY hely entitásonként
+
+    int thread_capacity; // A szálankénti prefix-összeg tömbök mérete
+    int *thread_outputs;
+    int *thread_births;
+};
+
+// Az éppen feldolgozott entitás kimeneti helyei, szálanként
+typedef struct
+{
+    World *world;
+    Entity *outputs;
+    unsigned char *output_count;
+    int self_index;
+    int reserved_target;
+} EmitCursor;
+
+static EmitCursor thread_cursor = {NULL, NULL, NULL, -1, -1};
+#pragma omp threadprivate(thread_cursor)
+
+static void free_scratch(DeterministicScratch *scratch)
+{
+    if (!scratch)
+        return;
+    memory_free(MEMORY_DETERMINISTIC, scratch->claims);
+    memory_free(MEMORY_DETERMINISTIC, scratch->cell_claims);
+    memory_free(MEMORY_DETERMINISTIC, scratch->reserved);
+    memory_free(MEMORY_DETERMINISTIC, scratch->status);
+    memory_free(MEMORY_DETERMINISTIC, scratch->output_counts);
+    memory_free(MEMORY_DETERMINISTIC, scratch->outputs);
+    memory_free(MEMORY_DETERMINISTIC, scratch->thread_outputs);
+    memory_free(MEMORY_DETERMINISTIC, scratch->thread_births);
+    memory_free(MEMORY_DETERMINISTIC, scratch);
+}
+
+static bool ensure_thread_capacity(DeterministicScratch *scratch, int threads)
+{
+    if (threads <= scratch->thread_capacity)
+        return true;
+
+    int *outputs = (int *)memory_realloc(MEMORY_DETERMINISTIC, scratch->thread_outputs, (threads + 1) * sizeof(int));
+    if (!outputs)
+        return false;
+    scratch->thread_outputs = outputs;
+
+    int *births = (int *)memory_realloc(MEMORY_DETERMINISTIC, scratch->thread_births, (threads + 1) * sizeof(int));
+    if (!births)
+        return false;
+    scratch->thread_births = births;
+
+    scratch->thread_capacity = threads;
+    return true;
+}
+
+bool deterministic_mode_enable(World *world, unsigned long long seed)
+{
+    if (!world)
+        return false;
+
+    if (!world->det_scratch)
+    {
+        DeterministicScratch *scratch = (DeterministicScratch *)memory_calloc(MEMORY_DETERMINISTIC, 1, sizeof(DeterministicScratch));
+        if (!scratch)
+        {
+            perror("Hiba a determinisztikus mód segédpuffereinek foglalásakor");
+            return false;
+        }
+        int capacity = world->entity_capacity > world->next_entity_capacity ? world->entity_capacity : world->next_entity_capacity;
+        scratch->capacity = capacity;
+        scratch->claims = (int *)memory_malloc(MEMORY_DETERMINISTIC, capacity * sizeof(int));
+        scratch->reserved = (int *)memory_malloc(MEMORY_DETERMINISTIC, capacity * sizeof(int));
+        scratch->status = (unsigned char *)memory_malloc(MEMORY_DETERMINISTIC, capacity * sizeof(unsigned char));
+        scratch->output_counts = (unsigned char *)memory_malloc(MEMORY_DETERMINISTIC, capacity * sizeof(unsigned char));
+        scratch->outputs = (Entity *)memory_malloc(MEMORY_DETERMINISTIC, (size_t)capacity * OUTPUTS_PER_ENTITY * sizeof(Entity));
+        if (!scratch->claims || !scratch->reserved || !scratch->status || !scratch->output_counts || !scratch->outputs ||
+            !ensure_thread_capacity(scratch, omp_get_max_threads()))
+        {
+            perror("Hiba a determinisztikus mód segédpuffereinek foglalásakor");
+            free_scratch(scratch);
+            return false;
+        }
+        world->det_scratch = scratch;
+    }
+
+    world->seed = seed;
+    world->deterministic = true;
+    return true;
+}
+
+void deterministic_mode_disable(World *world)
+{
+    if (!world)
+        return;
+    free_scratch(world->det_scratch);
+    world->det_scratch = NULL;
+    world->deterministic = false;
+}
+
+// Foglalás a célpontra: atomikus minimum a foglaló indexével.
+// Spekulatívan sikert jelez; a fázis feloldó lépése dönti el, hogy tényleg ez az entitás nyert-e.
+bool deterministic_reserve_target(World *world, Entity *target)
+{
+    // Lépésenként legfeljebb egy evés lehet sikeres, a már megevett célpont pedig nem foglalható.
+    if (target->energy <= 0 || thread_cursor.reserved_target >= 0 || thread_cursor.world != world)
+        return false;
+
+    int target_index = (int)(target - world->entities);
+    int self_index = thread_cursor.self_index;
+    int *claim = &world->det_scratch->claims[target_index];
+
+    int seen = __atomic_load_n(claim, __ATOMIC_RELAXED);
+    while (self_index < seen &&
+           !__atomic_compare_exchange_n(claim, &seen, self_index, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        // A seen értékét a sikertelen CAS frissítette, újrapróbáljuk
+    }
+
+    thread_cursor.reserved_target = target_index;
+    return true;
+}
+
+// Foglalás a növényréteg egy cellájára (legelés), ugyanazzal a minimum-index szabállyal.
+bool deterministic_reserve_cell(World *world, int cell_index)
+{
+    PlantLayer *layer = world->plants;
+    if (!layer || thread_cursor.reserved_target >= 0 || thread_cursor.world != world ||
+        !plant_layer_occupied(layer, cell_index % world->width, cell_index / world->width))
+        return false;
+
+    DeterministicScratch *scratch = world->det_scratch;
+    int self_index = thread_cursor.self_index;
+    int *claim = &scratch->cell_claims[cell_index];
+
+    int seen = __atomic_load_n(claim, __ATOMIC_RELAXED);
+    while (self_index < seen &&
+           !__atomic_compare_exchange_n(claim, &seen, self_index, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    thread_cursor.reserved_target = scratch->capacity + cell_index;
+    return true;
+}
+
+// A _commit_entity_to_next_state determinisztikus megfelelője: az aktuális entitás kimeneti helyére ír.
+void deterministic_emit_entity(const Entity *entity_data)
+{
+    if (!thread_cursor.outputs || *thread_cursor.output_count >= OUTPUTS_PER_ENTITY)
+        return;
+    thread_cursor.outputs[(*thread_cursor.output_count)++] = *entity_data;
+}
+
+// Egy entitás teljes (spekulatív) feldolgozása: könyvelés, akciók, kibocsátás a saját kimeneti helyeire.
+// Mivel a véletlen folyam az entitáshoz kötött, az újrafuttatás ugyanazokat a döntéseket hozza,
+// kivéve ahol a közben megevett célpontok miatt a világ állapota megváltozott.
+static void run_entity(World *world, int current_step_number, DeterministicScratch *scratch, int index)
+{
+    Entity *current = &world->entities[index];
+    Entity next_entity_prototype = *current;
+
+    scratch->output_counts[index] = 0;
+    scratch->reserved[index] = -1;
+
+    // Csak túlélők futnak ide (lásd lifecycle_prepass), a könyvelés eredményét átvesszük
+    lifecycle_apply(world->lifecycle, index, &next_entity_prototype);
+
+    thread_cursor.world = world;
+    thread_cursor.outputs = &scratch->outputs[(size_t)index * OUTPUTS_PER_ENTITY];
+    thread_cursor.output_count = &scratch->output_counts[index];
+    thread_cursor.self_index = index;
+    thread_cursor.reserved_target = -1;
+    sim_random_begin_stream(world->seed, current_step_number, (int)current->type, current->id);
+
+    process_species_actions(world, current_step_number, current, &next_entity_prototype,
+                            species_is_autotroph(current->type) ? NULL : &world->perception[index]);
+
+    if (next_entity_prototype.energy > 0)
+    {
+        deterministic_emit_entity(&next_entity_prototype);
+    }
+
+    sim_random_end_stream();
+    scratch->reserved[index] = thread_cursor.reserved_target;
+    thread_cursor.outputs = NULL;
+    thread_cursor.output_count = NULL;
+    thread_cursor.world = NULL;
+}
+
+// A kimeneti helyek tömörítése a next_entities tömb végére, forrásindex szerinti sorrendben.
+// Szálanként összefüggő tartományokat számolunk meg, prefix összeggel kapjuk az írási
+// pozíciókat és az utódok ID-jait, így az eredmény független a szálak számától.
+static void compact_outputs(World *world, DeterministicScratch *scratch, int count, int current_step_number)
+{
+    int base_index = world->next_entity_count;
+    int base_id = world->next_entity_id;
+    int capacity = world->next_entity_capacity;
+    int total_outputs = 0;
+    int total_births = 0;
+
+#pragma omp parallel shared(total_outputs, total_births)
+    {
+        int thread_id = omp_get_thread_num();
+        int thread_count = omp_get_num_threads();
+        int begin = (int)((long long)count * thread_id / thread_count);
+        int end = (int)((long long)count * (thread_id + 1) / thread_count);
+
+        int outputs = 0;
+        int births = 0;
+        for (int i = begin; i < end; i++)
+        {
+            for (int k = 0; k < scratch->output_counts[i]; k++)
+            {
+                outputs++;
+                if (scratch->outputs[(size_t)i * OUTPUTS_PER_ENTITY + k].id < 0)
+                    births++;
+            }
+        }
+        scratch->thread_outputs[thread_id] = outputs;
+        scratch->thread_births[thread_id] = births;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            // Exkluzív prefix összeg a szálak sorrendjében
+            for (int t = 0; t < thread_count; t++)
+            {
+                int thread_outputs = scratch->thread_outputs[t];
+                int thread_births = scratch->thread_births[t];
+                scratch->thread_outputs[t] = total_outputs;
+                scratch->thread_births[t] = total_births;
+                total_outputs += thread_outputs;
+                total_births += thread_births;
+            }
+        } // implicit barrier
+
+        int write_index = base_index + scratch->thread_outputs[thread_id];
+        int next_id = base_id + scratch->thread_births[thread_id];
+        for (int i = begin; i < end; i++)
+        {
+            for (int k = 0; k < scratch->output_counts[i]; k++)
+            {
+                Entity entity_data = scratch->outputs[(size_t)i * OUTPUTS_PER_ENTITY + k];
+                bool newborn = entity_data.id < 0;
+                if (newborn)
+                    entity_data.id = next_id++;
+                if (write_index < capacity) // A kapacitáson felüli rész (a sorrend végén) elvész
+                {
+                    world->next_entities[write_index] = entity_data;
+                    if (newborn && world->events)
+                        event_log_record(world->events, EVENT_BIRTH, current_step_number, &world->entities[i],
+                                         entity_data.id, entity_data.type, entity_data.position);
+                    if (world->stats)
+                        population_stats_record_entity(world->stats, &entity_data);
+                }
+                else if (world->metrics)
+                {
+                    metrics_exporter_note_commit_drop(world->metrics);
+                }
+                write_index++;
+            }
+        }
+    }
+
+    world->next_entity_count = base_index + total_outputs < capacity ? base_index + total_outputs : capacity;
+    world->next_entity_id = base_id + total_births;
+}
+
+void deterministic_process_phase(World *world, int current_step_number, EntityType phase_type)
+{
+    if (!world || !world->det_scratch)
+        return;
+
+    DeterministicScratch *scratch = world->det_scratch;
+    int count = world->entity_count;
+    if (!ensure_thread_capacity(scratch, omp_get_max_threads()))
+    {
+        fprintf(stderr, "Hiba: a determinisztikus mód szálankénti puffereinek bővítése sikertelen.\n");
+        return;
+    }
+
+    // Növényréteg esetén cellánkénti foglalási tömb is kell (a réteg a mód bekapcsolása után is létrejöhet)
+    if (world->plants)
+    {
+        int cells = world->width * world->height;
+        if (!scratch->cell_claims)
+        {
+            scratch->cell_claims = (int *)memory_malloc(MEMORY_DETERMINISTIC, (size_t)cells * sizeof(int));
+            if (!scratch->cell_claims)
+            {
+                perror("Hiba a növényréteg foglalási tömbjének foglalásakor");
+                return;
+            }
+            scratch->cell_count = cells;
+        }
+#pragma omp parallel for schedule(static)
+        for (int c = 0; c < cells; c++)
+            scratch->cell_claims[c] = INT_MAX;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < count; i++)
+    {
+        scratch->claims[i] = INT_MAX;
+        scratch->output_counts[i] = 0;
+        scratch->status[i] = DET_IDLE;
+    }
+
+    // Csak a lépés eleji életciklus-menet túlélői dolgoznak; a korábbi fázisban megevett
+    // entitások (EATEN_ENERGY_MARKER) kimaradnak
+    const int *survivors = world->lifecycle->survivors[phase_type];
+    int survivor_count = world->lifecycle->survivor_count[phase_type];
+#pragma omp parallel for schedule(static)
+    for (int k = 0; k < survivor_count; k++)
+    {
+        int i = survivors[k];
+        if (world->entities[i].energy != EATEN_ENERGY_MARKER)
+            scratch->status[i] = DET_PENDING;
+    }
+
+    int any_pending;
+    do
+    {
+        // 0. Érzékelés a függő állatokra. Körönként újra, mert az előző kör nyertesei
+        //    által megevett célpontok már nem látszanak.
+        if (!species_is_autotroph(phase_type))
+        {
+#pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < count; i++)
+            {
+                if (scratch->status[i] == DET_PENDING)
+                    perceive_animal(world, &world->entities[i], &world->perception[i]);
+            }
+        }
+
+        // 1. Spekulatív futás minden függő entitásra. A kimenet entitásonkénti helyekre kerül,
+        //    ezért az ütemezés (dynamic) nem befolyásolja az eredményt.
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < count; i++)
+        {
+            if (scratch->status[i] == DET_PENDING)
+                run_entity(world, current_step_number, scratch, i);
+        }
+
+        // 2. Feloldás: minden foglalt célpontot a legkisebb indexű foglaló kap meg.
+        //    A nyertesek véglegesek, a vesztesek a következő körben újrafutnak.
+        any_pending = 0;
+#pragma omp parallel for schedule(static) reduction(| : any_pending)
+        for (int i = 0; i < count; i++)
+        {
+            if (scratch->status[i] != DET_PENDING)
+                continue;
+
+            int target_index = scratch->reserved[i];
+            if (target_index < 0)
+            {
+                scratch->status[i] = DET_DONE;
+            }
+            else if (target_index >= scratch->capacity)
+            {
+                int cell_index = target_index - scratch->capacity;
+                if (scratch->cell_claims[cell_index] == i)
+                {
+                    // Egyedüli nyertes; a bittérkép szavát más cellák nyertesei is írhatják, ezért atomikus
+                    plant_layer_try_graze(world->plants, cell_index % world->width, cell_index / world->width);
+                    if (world->events)
+                        event_log_record(world->events, EVENT_GRAZE, current_step_number, &world->entities[i], -1, PLANT,
+                                         (Coordinates){cell_index % world->width, cell_index / world->width});
+                    scratch->status[i] = DET_DONE;
+                }
+                else
+                {
+                    scratch->output_counts[i] = 0;
+                    any_pending = 1;
+                }
+            }
+            else if (scratch->claims[target_index] == i)
+            {
+                const Entity *prey = &world->entities[target_index];
+                if (world->events)
+                    event_log_record(world->events, prey->type == PLANT ? EVENT_GRAZE : EVENT_PREDATION,
+                                     current_step_number, &world->entities[i], prey->id, prey->type, prey->position);
+                world->entities[target_index].energy = EATEN_ENERGY_MARKER; // Egyedüli író: a nyertes
+                scratch->status[i] = DET_DONE;
+            }
+            else
+            {
+                scratch->output_counts[i] = 0;
+                any_pending = 1;
+            }
+        }
+    } while (any_pending);
+
+    compact_outputs(world, scratch, count, current_step_number);
+}
+
+void deterministic_build_next_grid(World *world)
+{
+    if (!world)
+        return;
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < world->next_entity_count; i++)
+    {
+        Entity *entity = &world->next_entities[i];
+        if (!is_valid_pos(world, entity->position.x, entity->position.y))
+            continue;
+
+        // A cellát a legkisebb indexű (legkisebb című) entitás kapja, a szálak sorrendjétől függetlenül
+        Entity **cell_entity = &world->next_grid[entity->position.y][entity->position.x].entity;
+        world_chunks_note_write(world, WORLD_CHUNKS_NEXT, entity->position.x, entity->position.y);
+        Entity *seen = __atomic_load_n(cell_entity, __ATOMIC_RELAXED);
+        while ((seen == NULL || entity < seen) &&
+               !__atomic_compare_exchange_n(cell_entity, &seen, entity, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef DETERMINISTIC_STEP_H
+#define DETERMINISTIC_STEP_H
+
+#include <stdbool.h>
+
+#include "datatypes.h" // Szükséges a World, Entity, EntityType típusokhoz
+
+// Determinisztikus (szálszámtól független) végrehajtási mód.
+// - Evési konfliktusok: foglalás + sorrendezett feloldás (a legkisebb indexű foglaló nyer),
+//   a vesztesek a következő körben újrafutnak a frissített állapoton.
+// - Kimenet: entitásonkénti kimeneti helyek, majd prefix összeggel stabil sorrendű tömörítés.
+// - ID-k: az utódok ID-ját a szülők sorrendjéből (prefix összeg) osztjuk ki.
+// - Rács: a next_grid celláját mindig a legkisebb indexű entitás kapja.
+
+// Bekapcsolja a determinisztikus módot (lefoglalja a segédpuffereket). Hiba esetén hamis.
+bool deterministic_mode_enable(World *world, unsigned long long seed);
+// Kikapcsolja a módot és felszabadítja a segédpuffereket.
+void deterministic_mode_disable(World *world);
+
+// Egy fázis (adott típusú entitások) feldolgozása determinisztikusan.
+void deterministic_process_phase(World *world, int current_step_number, EntityType phase_type);
+// A next_grid felépítése a next_entities tömbből, sorrendfüggetlen (minimum-index) szabállyal.
+void deterministic_build_next_grid(World *world);
+
+// Az akciófüggvényekből hívott hookok (csak determinisztikus módban).
+bool deterministic_reserve_target(World *world, Entity *target);
+bool deterministic_reserve_cell(World *world, int cell_index);
+void deterministic_emit_entity(const Entity *entity_data);
+
+#endif // DETERMINISTIC_STEP_H
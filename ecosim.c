@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <omp.h>
+
+#include "ecosim.h"
+#include "simulation_constants.h"
+#include "simulation_utils.h"
+#include "world_utils.h"
+#include "deterministic_step.h"
+#include "plant_layer.h"
+#include "task_graph.h"
+#include "species.h"
+#include "topology.h"
+#include "memory_accounting.h"
+#include "phase_tuner.h"
+#include "world_chunks.h"
+
+struct EcosimEngine
+{
+    World *world;
+    int step; // A következő lépés sorszáma
+    double populate_seconds;
+    EcosimStepCallback callback;
+    void *callback_data;
+    PopulationRecord record; // A visszahívásnak átadott statisztika munkaterülete
+};
+
+void ecosim_config_default(EcosimConfig *config)
+{
+    config->width = DEFAULT_WIDTH;
+    config->height = DEFAULT_HEIGHT;
+    config->seed = 42;
+    config->initial_counts[EMPTY] = 0;
+    config->initial_counts[PLANT] = INITIAL_PLANTS;
+    config->initial_counts[HERBIVORE] = INITIAL_HERBIVORES;
+    config->initial_counts[CARNIVORE] = INITIAL_CARNIVORES;
+    config->entity_capacity = 0;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        config->population_caps[type] = 0;
+    config->deterministic = false;
+    config->task_graph = false;
+    config->plant_layer = false;
+    config->stats = false;
+    config->bulk_init = false;
+    config->huge_pages = false;
+    config->toroidal = false;
+    config->auto_threads = false;
+    config->chunked = false;
+    config->memory_budget = 0;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        config->density[type] = NULL;
+}
+
+EcosimEngine *ecosim_create(const EcosimConfig *config)
+{
+    if (!config || config->width <= 0 || config->height <= 0)
+    {
+        fprintf(stderr, "Hiba: érvénytelen világméret.\n");
+        return NULL;
+    }
+    EcosimEngine *engine = (EcosimEngine *)calloc(1, sizeof(EcosimEngine));
+    if (!engine)
+    {
+        perror("Hiba a motor foglalásakor");
+        return NULL;
+    }
+
+    long long requested = 0;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        requested += config->initial_counts[type] > 0 ? config->initial_counts[type] : 0;
+    if (requested > INT_MAX)
+    {
+        fprintf(stderr, "Hiba: túl sok kezdeti entitás (%lld).\n", requested);
+        free(engine);
+        return NULL;
+    }
+    // Alapértelmezett kapacitás: a MAX_TOTAL_ENTITIES, de legfeljebb a cellák száma (egy cellában
+    // egy entitás), illetve legalább a kezdeti létszámok összege
+    int capacity = config->entity_capacity;
+    if (capacity <= 0)
+    {
+        long long cells = (long long)config->width * config->height;
+        capacity = cells < MAX_TOTAL_ENTITIES ? (int)cells : MAX_TOTAL_ENTITIES;
+        if (requested > capacity)
+            capacity = (int)requested;
+    }
+    if (requested > capacity)
+    {
+        fprintf(stderr, "Hiba: a kezdeti létszámok összege (%lld) meghaladja a kapacitást (%d).\n", requested, capacity);
+        free(engine);
+        return NULL;
+    }
+
+    memory_set_budget(config->memory_budget);
+    World *world = create_world_with_capacity(config->width, config->height, capacity, config->huge_pages, config->chunked);
+    if (!world)
+    {
+        fprintf(stderr, "Hiba a világ létrehozásakor!\n");
+        free(engine);
+        return NULL;
+    }
+    engine->world = world;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+    {
+        if (config->population_caps[type] > 0)
+            world->population_cap[type] = config->population_caps[type];
+    }
+    topology_set_toroidal(world, config->toroidal);
+    if (config->deterministic && !deterministic_mode_enable(world, config->seed))
+    {
+        ecosim_destroy(engine);
+        return NULL;
+    }
+    if (config->task_graph)
+    {
+        if (config->deterministic)
+            fprintf(stderr, "Figyelem: a feladatgráf determinisztikus módban hatástalan.\n");
+        else if (!task_graph_enable(world))
+        {
+            ecosim_destroy(engine);
+            return NULL;
+        }
+    }
+
+    // A create_world időalapú seed-et állít be; a kezdeti elhelyezés is a megadott seed-ből induljon.
+    world->seed = config->seed;
+    srand((unsigned int)config->seed);
+    double populate_begin = omp_get_wtime();
+    if (config->bulk_init)
+    {
+        if (!generate_world_bulk(world, config->initial_counts, config->density, config->seed))
+        {
+            ecosim_destroy(engine);
+            return NULL;
+        }
+    }
+    else
+    {
+        initialize_world(world, config->initial_counts[PLANT], config->initial_counts[HERBIVORE],
+                         config->initial_counts[CARNIVORE]);
+    }
+    engine->populate_seconds = omp_get_wtime() - populate_begin;
+
+    if ((config->plant_layer && !plant_layer_enable(world)) ||
+        (config->stats && !population_stats_enable(world)) ||
+        (config->auto_threads && !phase_tuner_enable(world)))
+    {
+        ecosim_destroy(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+void ecosim_destroy(EcosimEngine *engine)
+{
+    if (!engine)
+        return;
+    free_world(engine->world);
+    free(engine);
+}
+
+// Típusonkénti létszámok egyetlen menetben (a visszahíváshoz)
+static void count_by_type(const World *world, int counts[ENTITY_TYPE_COUNT])
+{
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        counts[type] = 0;
+    for (int i = 0; i < world->entity_count; i++)
+    {
+        const Entity *entity = &world->entities[i];
+        if (entity->id >= 0 && entity->energy > 0 && entity->type > EMPTY && entity->type < ENTITY_TYPE_COUNT)
+            counts[entity->type]++;
+    }
+    if (world->plants)
+        counts[PLANT] += plant_layer_count(world->plants);
+}
+
+int ecosim_step(EcosimEngine *engine, int steps)
+{
+    if (!engine)
+        return 0;
+    for (int i = 0; i < steps; i++)
+    {
+        double step_begin = omp_get_wtime();
+        simulate_step(engine->world, engine->step);
+        double step_seconds = omp_get_wtime() - step_begin;
+        if (engine->callback)
+        {
+            EcosimStepInfo info;
+            info.step = engine->step;
+            count_by_type(engine->world, info.counts);
+            info.seconds = step_seconds;
+            info.stats = ecosim_read_stats(engine, &engine->record) ? &engine->record : NULL;
+            engine->callback(&info, engine->callback_data);
+        }
+        engine->step++;
+    }
+    return engine->step;
+}
+
+int ecosim_current_step(const EcosimEngine *engine)
+{
+    return engine ? engine->step : 0;
+}
+
+int ecosim_spawn(EcosimEngine *engine, EntityType type, int count)
+{
+    return ecosim_spawn_at(engine, type, NULL, count);
+}
+
+int ecosim_spawn_at(EcosimEngine *engine, EntityType type, const Coordinates *positions, int count)
+{
+    if (!engine || type <= EMPTY || type >= ENTITY_TYPE_COUNT || count <= 0)
+        return 0;
+    // A létszámplafont egyszer ellenőrizzük, nem egyedenként (a számlálás O(n))
+    int room = engine->world->population_cap[type] - count_entities_by_type(engine->world, type);
+    int placed = 0;
+    for (int i = 0; i < count && placed < room; i++)
+    {
+        if (place_entity(engine->world, type, positions ? &positions[i] : NULL, engine->step))
+            placed++;
+        else if (!positions)
+            break; // Nincs több szabad cella vagy hely
+    }
+    return placed;
+}
+
+EcosimEntityView ecosim_entities(const EcosimEngine *engine)
+{
+    EcosimEntityView view = {NULL, 0};
+    if (engine)
+    {
+        view.entities = engine->world->entities;
+        view.count = engine->world->entity_count;
+    }
+    return view;
+}
+
+EcosimGridView ecosim_grid(const EcosimEngine *engine)
+{
+    EcosimGridView view = {NULL, NULL, NULL, NULL, 0, 0, 0};
+    if (engine)
+    {
+        const World *world = engine->world;
+        view.rows = (const Cell *const *)world->grid;
+        view.cells = world->grid[0];
+        view.entities = world->entities;
+        view.plant_energy = world->plants ? world->plants->energy : NULL;
+        view.width = world->width;
+        view.height = world->height;
+        view.stride = world->chunks ? world->chunks->stride : world->width;
+    }
+    return view;
+}
+
+int ecosim_count(const EcosimEngine *engine, EntityType type)
+{
+    return engine ? count_entities_by_type(engine->world, type) : 0;
+}
+
+unsigned long long ecosim_state_hash(const EcosimEngine *engine)
+{
+    return engine ? world_state_hash(engine->world) : 0;
+}
+
+void ecosim_set_step_callback(EcosimEngine *engine, EcosimStepCallback callback, void *user_data)
+{
+    if (!engine)
+        return;
+    engine->callback = callback;
+    engine->callback_data = user_data;
+}
+
+bool ecosim_read_stats(const EcosimEngine *engine, PopulationRecord *out)
+{
+    return engine && engine->world->stats && population_stats_read(engine->world->stats, out);
+}
+
+int ecosim_entity_type_count(void)
+{
+    return ENTITY_TYPE_COUNT;
+}
+
+size_t ecosim_entity_size(void)
+{
+    return sizeof(Entity);
+}
+
+size_t ecosim_config_size(void)
+{
+    return sizeof(EcosimConfig);
+}
+
+size_t ecosim_grid_view_size(void)
+{
+    return sizeof(EcosimGridView);
+}
+
+double ecosim_populate_seconds(const EcosimEngine *engine)
+{
+    return engine ? engine->populate_seconds : 0.0;
+}
+
+World *ecosim_world(EcosimEngine *engine)
+{
+    return engine ? engine->world : NULL;
+}
@@ -0,0 +1,121 @@
+#ifndef ECOSIM_H
+#define ECOSIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "datatypes.h"        // World, Entity, Cell, Coordinates, EntityType
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+#include "population_stats.h" // PopulationRecord
+#include "world_generator.h"  // DensityMap
+
+// libecosim: a szimulációs motor beágyazható C felülete, ncurses nélkül. Létrehozás és
+// felszabadítás, léptetés, tömeges spawnolás, csak olvasható nézetek a motor saját entitás- és
+// rácstömbjeire (másolás nélkül), valamint lépésenkénti visszahívás a statisztikához.
+//
+// A nézetek a következő ecosim_step/ecosim_spawn hívásig érvényesek (a lépés a dupla
+// pufferek cseréjével új tömböket tesz aktuálissá). A motor OpenMP-vel párhuzamosít, és a
+// nem determinisztikus mód a folyamat rand() állapotát is használja, ezért egyszerre egy
+// szálról egy motort léptessünk.
+//
+// A memóriaelszámolás (memory_accounting.h: alrendszerenkénti aktuális és csúcs bájtszám,
+// memory_report) szintén a könyvtár része; a keretet az EcosimConfig.memory_budget állítja.
+
+typedef struct EcosimEngine EcosimEngine;
+
+typedef struct
+{
+    int width;
+    int height;
+    unsigned long long seed;
+    int initial_counts[ENTITY_TYPE_COUNT]; // Kezdeti létszámok típusonként (az EMPTY elem nem számít)
+    int entity_capacity;                   // 0: a MAX_TOTAL_ENTITIES és a kezdeti létszámok összegének nagyobbika
+    int population_caps[ENTITY_TYPE_COUNT]; // Létszámplafonok típusonként (0: a fajtábla max_population-je)
+    bool deterministic;                    // Szálszámtól független eredmény
+    bool task_graph;                       // Sávos feladatgráf (determinisztikus módban hatástalan)
+    bool plant_layer;                      // Sűrű növényréteg
+    bool stats;                            // Lépésenkénti populációs statisztika (ecosim_read_stats, visszahívás)
+    bool bulk_init;                        // Párhuzamos, csempés kezdeti benépesítés
+    bool huge_pages;                       // Az aréna nagy lapokon
+    bool toroidal;                         // Tórusz világ: a szélek körbefutnak (lásd topology.h)
+    bool auto_threads;                     // Fázisonkénti soros/párhuzamos döntés mérés alapján (lásd phase_tuner.h)
+    bool chunked;                          // Ritka (darabolt) rácstárolás nagy, üres világokhoz (lásd world_chunks.h)
+    size_t memory_budget;                  // Kemény memóriakeret bájtban, a folyamat egészére (0: nincs; lásd memory_accounting.h)
+    const DensityMap *density[ENTITY_TYPE_COUNT]; // Sűrűségtérképek a tömeges benépesítéshez (NULL: egyenletes)
+} EcosimConfig;
+
+// Csak olvasható nézet az aktuális entitásokra
+typedef struct
+{
+    const Entity *entities;
+    int count;
+} EcosimEntityView;
+
+// Csak olvasható nézet az aktuális rácsra: rows[y][x].entity az entities tömb egy elemére mutat
+// (az index: cell.entity - entities), vagy NULL. A cellák sorfolytonosak: rows[y] == &cells[y * stride]
+// (sűrű rácsnál stride == width; ritka tárolásnál a sorvégi tartalék cellák üresek).
+// Növényréteg esetén a növények energiája a plant_energy[y * width + x] bájtban van (0: nincs
+// növény), egyébként plant_energy NULL.
+typedef struct
+{
+    const Cell *const *rows;
+    const Cell *cells;
+    const Entity *entities;
+    const unsigned char *plant_energy;
+    int width;
+    int height;
+    int stride;
+} EcosimGridView;
+
+// A lépés után a visszahívásnak átadott összegzés. A stats csak bekapcsolt statisztikánál nem NULL.
+typedef struct
+{
+    int step;
+    int counts[ENTITY_TYPE_COUNT]; // Élő egyedek típusonként (a növényréteg növényeivel együtt)
+    double seconds;                // A lépés futásideje
+    const PopulationRecord *stats;
+} EcosimStepInfo;
+
+typedef void (*EcosimStepCallback)(const EcosimStepInfo *info, void *user_data);
+
+// Alapértelmezett beállítások (DEFAULT_WIDTH x DEFAULT_HEIGHT, a simulation_constants.h kezdeti létszámai)
+void ecosim_config_default(EcosimConfig *config);
+
+// A motor létrehozása és benépesítése. Hiba esetén NULL (az ok az stderr-en).
+EcosimEngine *ecosim_create(const EcosimConfig *config);
+void ecosim_destroy(EcosimEngine *engine);
+
+// steps lépés futtatása; a visszatérési érték a motor lépésszámlálója utána.
+int ecosim_step(EcosimEngine *engine, int steps);
+int ecosim_current_step(const EcosimEngine *engine);
+
+// count darab type típusú egyed véletlen üres cellákra; a ténylegesen elhelyezettek száma.
+int ecosim_spawn(EcosimEngine *engine, EntityType type, int count);
+// Egyedek a megadott cellákra (a foglalt vagy érvénytelen cellákat kihagyja); az elhelyezettek száma.
+int ecosim_spawn_at(EcosimEngine *engine, EntityType type, const Coordinates *positions, int count);
+
+EcosimEntityView ecosim_entities(const EcosimEngine *engine);
+EcosimGridView ecosim_grid(const EcosimEngine *engine);
+// Élő egyedek száma egy típusból (a növényréteg növényeivel együtt)
+int ecosim_count(const EcosimEngine *engine, EntityType type);
+// Az állapot 64 bites lenyomata (lásd world_state_hash)
+unsigned long long ecosim_state_hash(const EcosimEngine *engine);
+
+// Lépésenkénti visszahívás (NULL: kikapcsolva); a léptető szálról hívódik, minden lépés után.
+void ecosim_set_step_callback(EcosimEngine *engine, EcosimStepCallback callback, void *user_data);
+// Az utolsó lépés populációs statisztikája. Hamis, ha a statisztika nincs bekapcsolva.
+bool ecosim_read_stats(const EcosimEngine *engine, PopulationRecord *out);
+
+// A nyilvános struktúrák mérete a fordításkor; a nem C kötések (ecosim.py) ezzel ellenőrzik,
+// hogy a saját elrendezésük egyezik-e a könyvtáréval.
+int ecosim_entity_type_count(void); // Az ENTITY_TYPE_COUNT (a típusonkénti tömbök hossza)
+size_t ecosim_entity_size(void);
+size_t ecosim_config_size(void);
+size_t ecosim_grid_view_size(void);
+
+// A benépesítés ideje a létrehozáskor (másodperc)
+double ecosim_populate_seconds(const EcosimEngine *engine);
+// A belső világ a front endnek (metrikák, publikálás, megjelenítés); beágyazóknak nem szükséges.
+World *ecosim_world(EcosimEngine *engine);
+
+#endif // ECOSIM_H
@@ -0,0 +1,272 @@
+"""Python kötés a libecosim motorhoz (ctypes + NumPy).
+
+Az entitások és a rács NumPy tömbként, másolás nélkül érhetők el: a tömbök a motor saját,
+dupla pufferelt tömbjeire mutatnak (puffer protokoll), ezért a következő step()/spawn()
+hívásig érvényesek, utána újra le kell kérni őket. A step(n) a teljes n lépést a C oldalon
+futtatja, a lépések között nem tér vissza a Pythonba (a ctypes a hívás idejére elengedi a GIL-t).
+
+    import ecosim
+    with ecosim.Engine(width=400, height=200, seed=3, deterministic=True) as engine:
+        engine.step(1000)
+        entities = engine.entities()          # strukturált tömb: id, type, position.x, energy, ...
+        alive = entities[entities["energy"] > 0]
+        grid = engine.cell_index()            # (height, width), az entities indexe vagy -1
+
+A könyvtárat a modul melletti libecosim.so-ból tölti (make lib), vagy az ECOSIM_LIB
+környezeti változóban megadott útvonalról.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+
+def _open_library():
+    path = os.environ.get("ECOSIM_LIB") or os.path.join(os.path.dirname(os.path.abspath(__file__)), "libecosim.so")
+    return ctypes.CDLL(path)
+
+
+_lib = _open_library()
+
+EMPTY, PLANT, HERBIVORE, CARNIVORE = range(4)
+# A típusonkénti tömbök hossza a könyvtár fordításából (a próbafajokkal több is lehet, lásd lifecycle_kernel.h)
+_lib.ecosim_entity_type_count.restype = ctypes.c_int
+_lib.ecosim_entity_type_count.argtypes = []
+ENTITY_TYPE_COUNT = _lib.ecosim_entity_type_count()
+
+
+class Coordinates(ctypes.Structure):
+    _fields_ = [("x", ctypes.c_int), ("y", ctypes.c_int)]
+
+
+# A datatypes.h Entity struktúrájának tükre; a mérete betöltéskor ellenőrizve
+class Entity(ctypes.Structure):
+    _fields_ = [
+        ("id", ctypes.c_int),
+        ("type", ctypes.c_int),
+        ("position", Coordinates),
+        ("energy", ctypes.c_int),
+        ("age", ctypes.c_int),
+        ("sight_range", ctypes.c_int),
+        ("last_reproduction_step", ctypes.c_int),
+        ("last_eating_step", ctypes.c_int),
+        ("just_spawned_by_keypress", ctypes.c_bool),
+    ]
+
+
+class EcosimConfig(ctypes.Structure):
+    _fields_ = [
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("seed", ctypes.c_ulonglong),
+        ("initial_counts", ctypes.c_int * ENTITY_TYPE_COUNT),
+        ("entity_capacity", ctypes.c_int),
+        ("population_caps", ctypes.c_int * ENTITY_TYPE_COUNT),
+        ("deterministic", ctypes.c_bool),
+        ("task_graph", ctypes.c_bool),
+        ("plant_layer", ctypes.c_bool),
+        ("stats", ctypes.c_bool),
+        ("bulk_init", ctypes.c_bool),
+        ("huge_pages", ctypes.c_bool),
+        ("toroidal", ctypes.c_bool),
+        ("auto_threads", ctypes.c_bool),
+        ("chunked", ctypes.c_bool),
+        ("memory_budget", ctypes.c_size_t),
+        ("density", ctypes.c_void_p * ENTITY_TYPE_COUNT),
+    ]
+
+
+class EcosimEntityView(ctypes.Structure):
+    _fields_ = [("entities", ctypes.POINTER(Entity)), ("count", ctypes.c_int)]
+
+
+class EcosimGridView(ctypes.Structure):
+    _fields_ = [
+        ("rows", ctypes.c_void_p),
+        ("cells", ctypes.POINTER(ctypes.c_void_p)),  # Cell == egyetlen Entity* mező
+        ("entities", ctypes.c_void_p),
+        ("plant_energy", ctypes.POINTER(ctypes.c_ubyte)),
+        ("width", ctypes.c_int),
+        ("height", ctypes.c_int),
+        ("stride", ctypes.c_int),
+    ]
+
+
+class MemoryUsage(ctypes.Structure):
+    _fields_ = [("current", ctypes.c_size_t), ("peak", ctypes.c_size_t)]
+
+
+# Az entitások NumPy rekordtípusa (a beágyazott position mezővel együtt)
+ENTITY_DTYPE = np.dtype(Entity)
+
+
+def _bind_library(lib):
+    engine_p = ctypes.c_void_p
+    signatures = {
+        "ecosim_config_default": (None, [ctypes.POINTER(EcosimConfig)]),
+        "ecosim_create": (engine_p, [ctypes.POINTER(EcosimConfig)]),
+        "ecosim_destroy": (None, [engine_p]),
+        "ecosim_step": (ctypes.c_int, [engine_p, ctypes.c_int]),
+        "ecosim_current_step": (ctypes.c_int, [engine_p]),
+        "ecosim_spawn": (ctypes.c_int, [engine_p, ctypes.c_int, ctypes.c_int]),
+        "ecosim_spawn_at": (ctypes.c_int, [engine_p, ctypes.c_int, ctypes.POINTER(Coordinates), ctypes.c_int]),
+        "ecosim_entities": (EcosimEntityView, [engine_p]),
+        "ecosim_grid": (EcosimGridView, [engine_p]),
+        "ecosim_count": (ctypes.c_int, [engine_p, ctypes.c_int]),
+        "ecosim_state_hash": (ctypes.c_ulonglong, [engine_p]),
+        "ecosim_entity_size": (ctypes.c_size_t, []),
+        "ecosim_config_size": (ctypes.c_size_t, []),
+        "ecosim_grid_view_size": (ctypes.c_size_t, []),
+        "memory_usage": (MemoryUsage, [ctypes.c_int]),
+        "memory_total_usage": (MemoryUsage, []),
+        "memory_subsystem_name": (ctypes.c_char_p, [ctypes.c_int]),
+        "memory_peak_rss_kb": (ctypes.c_long, []),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        function = getattr(lib, name)
+        function.restype = restype
+        function.argtypes = argtypes
+
+    # Eltérő elrendezés (más fordítás, módosított struktúra) csendes memóriahibát okozna
+    for structure, size_function in ((Entity, lib.ecosim_entity_size), (EcosimConfig, lib.ecosim_config_size),
+                                     (EcosimGridView, lib.ecosim_grid_view_size)):
+        if ctypes.sizeof(structure) != size_function():
+            raise ImportError("libecosim: a(z) %s mérete eltér (%d != %d)"
+                              % (structure.__name__, ctypes.sizeof(structure), size_function()))
+
+
+_bind_library(_lib)
+
+
+def _view(address, dtype, shape):
+    """Csak olvasható NumPy tömb a megadott címen lévő memóriára (másolás nélkül).
+    A ctypes struktúrák PEP 3118 leírása a kitöltő bájtokat nem jelöli, ezért bájtpufferen át."""
+    dtype = np.dtype(dtype)
+    buffer = (ctypes.c_char * (dtype.itemsize * int(np.prod(shape)))).from_address(address)
+    array = np.frombuffer(buffer, dtype=dtype).reshape(shape)
+    array.flags.writeable = False
+    return array
+
+
+def memory_usage():
+    """A motor memóriaelszámolása: {alrendszer: (aktuális, csúcs)} bájtban, a "total" kulccsal
+    az összesen, a "peak_rss_kb" kulccsal a folyamat csúcs RSS-e (KiB). A számlálók a folyamat
+    összes motorjára közösek."""
+    usage = {}
+    subsystem = 0
+    while True:
+        name = _lib.memory_subsystem_name(subsystem).decode()
+        if name == "?":
+            break
+        value = _lib.memory_usage(subsystem)
+        usage[name] = (value.current, value.peak)
+        subsystem += 1
+    total = _lib.memory_total_usage()
+    usage["total"] = (total.current, total.peak)
+    usage["peak_rss_kb"] = _lib.memory_peak_rss_kb()
+    return usage
+
+
+class Engine:
+    """Egy szimulációs motor. A kulcsszavas argumentumok az EcosimConfig mezői; a counts
+    a kezdeti létszámok, a caps a létszámplafonok {PLANT: n, HERBIVORE: n, CARNIVORE: n} alakban
+    (a caps-ből kihagyott típusé a fajtábláé)."""
+
+    def __init__(self, counts=None, caps=None, **options):
+        self._engine = None
+        config = EcosimConfig()
+        _lib.ecosim_config_default(ctypes.byref(config))
+        for name, value in options.items():
+            if name not in dict(EcosimConfig._fields_) or name in ("initial_counts", "population_caps", "density"):
+                raise TypeError("ismeretlen beállítás: %s" % name)
+            setattr(config, name, value)
+        for entity_type, count in (counts or {}).items():
+            config.initial_counts[entity_type] = count
+        for entity_type, cap in (caps or {}).items():
+            config.population_caps[entity_type] = cap
+        self._engine = _lib.ecosim_create(ctypes.byref(config))
+        if not self._engine:
+            raise RuntimeError("ecosim_create sikertelen (az ok az stderr-en)")
+
+    def close(self):
+        if self._engine:
+            _lib.ecosim_destroy(self._engine)
+            self._engine = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def _handle(self):
+        if not self._engine:
+            raise ValueError("a motor már le van zárva")
+        return self._engine
+
+    def step(self, n=1):
+        """n lépés egyetlen C hívásban; a visszatérési érték a lépésszámláló."""
+        return _lib.ecosim_step(self._handle(), n)
+
+    @property
+    def current_step(self):
+        return _lib.ecosim_current_step(self._handle())
+
+    def spawn(self, entity_type, count):
+        """count egyed véletlen üres cellákra; a ténylegesen elhelyezettek száma."""
+        return _lib.ecosim_spawn(self._handle(), entity_type, count)
+
+    def spawn_at(self, entity_type, xs, ys):
+        """Egyedek az (xs[i], ys[i]) cellákra; a foglalt vagy érvénytelen cellák kimaradnak."""
+        xs = np.asarray(xs, dtype=np.intc)
+        ys = np.asarray(ys, dtype=np.intc)
+        positions = np.empty(len(xs), dtype=np.dtype(Coordinates))
+        positions["x"] = xs
+        positions["y"] = ys
+        pointer = positions.ctypes.data_as(ctypes.POINTER(Coordinates))
+        return _lib.ecosim_spawn_at(self._handle(), entity_type, pointer, len(positions))
+
+    def entities(self):
+        """Az aktuális entitások csak olvasható rekordtömbje (ENTITY_DTYPE), másolás nélkül.
+        A halott (energy <= 0) egyedek a következő lépésig a tömbben maradhatnak."""
+        view = _lib.ecosim_entities(self._handle())
+        if view.count == 0:
+            return np.empty(0, dtype=ENTITY_DTYPE)
+        return _view(ctypes.addressof(view.entities.contents), ENTITY_DTYPE, (view.count,))
+
+    def grid_pointers(self):
+        """A rács (height, width) alakú, csak olvasható nézete másolás nélkül: cellánként az
+        entitás címe (0: üres cella). Indexszé a cell_index() alakítja."""
+        view = _lib.ecosim_grid(self._handle())
+        # A sorok távolsága ritka tárolásnál a szélességnél nagyobb lehet
+        rows = _view(ctypes.addressof(view.cells.contents), np.uintp, (view.height, view.stride))
+        return rows[:, :view.width]
+
+    def cell_index(self):
+        """Cellánként az entities() tömb indexe, üres cellára -1 (vektorizált számítás, új tömb)."""
+        view = _lib.ecosim_grid(self._handle())
+        pointers = self.grid_pointers().astype(np.int64)  # Az új tömb már a másolat
+        index = (pointers - view.entities) // ENTITY_DTYPE.itemsize
+        index[pointers == 0] = -1
+        return index.astype(np.int32)
+
+    def plant_energy(self):
+        """Növényréteg esetén a növények energiája (height, width) uint8 tömbként, másolás
+        nélkül (0: nincs növény); növényréteg nélkül None."""
+        view = _lib.ecosim_grid(self._handle())
+        if not view.plant_energy:
+            return None
+        return _view(ctypes.addressof(view.plant_energy.contents), np.uint8, (view.height, view.width))
+
+    def count(self, entity_type):
+        return _lib.ecosim_count(self._handle(), entity_type)
+
+    def counts(self):
+        return {entity_type: self.count(entity_type) for entity_type in (PLANT, HERBIVORE, CARNIVORE)}
+
+    def state_hash(self):
+        return _lib.ecosim_state_hash(self._handle())
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <omp.h>
+
+#include "ecosim_fork.h"
+
+struct EcosimBranch
+{
+    pid_t pid;
+    int result_fd; // A cső olvasó vége
+};
+
+// A folyamat eddigi kisebb laphibái. A gyermekben egy laphiba egy lap copy-on-write másolása vagy
+// egy új lap első érintése, így a fork utáni növekmény az ág által lemásolt memória. (A smaps
+// Private_Dirty értéke erre nem jó: a fork előtt piszkított lapokat, és azokat is tartalmazza,
+// amelyeket a szülő saját írása tett a gyermekben priváttá.)
+static long minor_faults(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_minflt;
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const char *bytes = (const char *)data;
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static size_t read_all(int fd, void *data, size_t size)
+{
+    char *bytes = (char *)data;
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t got = read(fd, bytes + total, size - total);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            break;
+        total += (size_t)got;
+    }
+    return total;
+}
+
+// A gyermekfolyamat törzse; nem tér vissza
+static void run_branch(EcosimEngine *engine, EcosimBranchFn run, void *user_data, int fd)
+{
+    // A szülő szálai (OpenMP készlet, exportáló, publikáló, napló író) nem léteznek a gyermekben.
+    // A fázishangoló num_threads záradéka felülírná az egy szálat, ezért az ág nélküle fut
+    // (a hangolót a szülő birtokolja; a gyermek memóriája a kilépéssel szűnik meg).
+    omp_set_num_threads(1);
+    long faults_at_fork = minor_faults();
+    World *world = ecosim_world(engine);
+    world->tuner = NULL;
+    world->metrics = NULL;
+    world->publisher = NULL;
+    world->events = NULL;
+    world->latency = NULL;
+
+    EcosimBranchResult result;
+    memset(&result, 0, sizeof(result));
+    double begin = omp_get_wtime();
+    bool ok = run(engine, &result, user_data);
+    result.seconds = omp_get_wtime() - begin;
+    result.step = ecosim_current_step(engine);
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        result.counts[type] = ecosim_count(engine, type);
+    result.hash = ecosim_state_hash(engine);
+    long faults = minor_faults();
+    result.copied_kb = faults >= 0 && faults_at_fork >= 0 ? (faults - faults_at_fork) * (sysconf(_SC_PAGESIZE) / 1024) : -1;
+    if (result.payload_size < 0 || result.payload_size > ECOSIM_BRANCH_PAYLOAD)
+        result.payload_size = 0;
+
+    fflush(stdout);
+    fflush(stderr);
+    if (ok && !write_all(fd, &result, sizeof(result)))
+        ok = false;
+    close(fd);
+    // A szülőtől örökölt erőforrásokat (aréna, fájlok) a folyamat vége felszabadítja; a kilépési
+    // kezelők és a szülő stdio-pufferei nem futhatnak le még egyszer
+    _exit(ok ? 0 : 1);
+}
+
+EcosimBranch *ecosim_fork(EcosimEngine *engine, EcosimBranchFn run, void *user_data)
+{
+    if (!engine || !run)
+        return NULL;
+    EcosimBranch *branch = (EcosimBranch *)malloc(sizeof(EcosimBranch));
+    if (!branch)
+    {
+        perror("Hiba az ág leírójának foglalásakor");
+        return NULL;
+    }
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("Hiba az ág eredménycsövének létrehozásakor");
+        free(branch);
+        return NULL;
+    }
+    // A pufferelt kimenet ne kerüljön kétszer a kimenetre (a gyermek is kiírná)
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("Hiba az ág indításakor (fork)");
+        close(fds[0]);
+        close(fds[1]);
+        free(branch);
+        return NULL;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        run_branch(engine, run, user_data, fds[1]);
+    }
+    close(fds[1]);
+    branch->pid = pid;
+    branch->result_fd = fds[0];
+    return branch;
+}
+
+bool ecosim_branch_wait(EcosimBranch *branch, EcosimBranchResult *out)
+{
+    if (!branch)
+        return false;
+    EcosimBranchResult result;
+    bool complete = read_all(branch->result_fd, &result, sizeof(result)) == sizeof(result);
+    close(branch->result_fd);
+
+    int status = 0;
+    pid_t waited;
+    do
+        waited = waitpid(branch->pid, &status, 0);
+    while (waited < 0 && errno == EINTR);
+    free(branch);
+
+    if (waited < 0)
+    {
+        perror("Hiba az ág bevárásakor");
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !complete)
+    {
+        if (WIFSIGNALED(status))
+            fprintf(stderr, "Hiba: az ág a(z) %d. jelzéssel állt le.\n", WTERMSIG(status));
+        else
+            fprintf(stderr, "Hiba: az ág sikertelenül zárult.\n");
+        return false;
+    }
+    if (out)
+        *out = result;
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef ECOSIM_FORK_H
+#define ECOSIM_FORK_H
+
+#include <stdbool.h>
+
+#include "ecosim.h"
+
+// "Mi lett volna, ha" ágak: egy futó motor elágaztatása fork()-kal. A gyermekfolyamat a szülő
+// teljes címterét (az arénát és a kiegészítő rétegeket) copy-on-write örökli, így az ág csak
+// azokért a lapokért fizet, amelyeket ténylegesen átír; a szülő közben zavartalanul fut tovább.
+// Az ág a visszahívásban módosítja és lépteti a saját motorpéldányát (pl. ecosim_spawn, ecosim_step),
+// az eredményt egy csövön, rögzített méretű EcosimBranchResult-ként kapja vissza a szülő.
+//
+// Megkötések a gyermekben:
+// - Az OpenMP szálkészlete nem öröklődik (a libgomp a fork után a régi készletre várna), ezért az ág
+//   egy szálon fut; több ág egymással párhuzamosan fut, külön folyamatként. Determinisztikus módban
+//   az ág eredménye így is azonos azzal, amit a szülő ugyanazokkal a lépésekkel kapna.
+// - A szülő háttérszálas kiegészítői (metrika-exportáló, osztott memóriás publikáló, eseménynapló,
+//   lépésidő-mérés) az ágban le vannak választva a világról.
+// - Az ág stdout/stderr kimenete a visszahívás után kiíródik, de a sorrendje a szülőéhez képest
+//   nem meghatározott; a mért eredményt a payload-ban érdemes visszaadni.
+
+#define ECOSIM_BRANCH_PAYLOAD 256 // A visszahívás saját eredményének helye bájtban
+
+typedef struct
+{
+    int step;                      // A motor lépésszámlálója az ág végén
+    int counts[ENTITY_TYPE_COUNT]; // Élő egyedek típusonként (a növényréteg növényeivel együtt)
+    unsigned long long hash;       // ecosim_state_hash az ág végén
+    double seconds;                // Az ág futásideje (a visszahívás)
+    long copied_kb;                // Az ág által a fork után lemásolt vagy először írt lapok KiB-ban (laphibákból); -1: ismeretlen
+    int payload_size;              // A payload kitöltött része (a visszahívás állítja)
+    unsigned char payload[ECOSIM_BRANCH_PAYLOAD];
+} EcosimBranchResult;
+
+// Az ág törzse a gyermekfolyamatban; hamis visszatérés esetén az ág hibával zárul.
+typedef bool (*EcosimBranchFn)(EcosimEngine *engine, EcosimBranchResult *result, void *user_data);
+
+typedef struct EcosimBranch EcosimBranch;
+
+// Ág indítása a motor jelenlegi állapotából. Hiba esetén NULL (az ok az stderr-en).
+EcosimBranch *ecosim_fork(EcosimEngine *engine, EcosimBranchFn run, void *user_data);
+// Az ág bevárása és az eredmény átvétele; a leírót mindenképp felszabadítja.
+// Hamis, ha az ág hibával zárult vagy nem küldött teljes eredményt.
+bool ecosim_branch_wait(EcosimBranch *branch, EcosimBranchResult *out);
+
+#endif // ECOSIM_FORK_H
@@ -2,362 +2,343 @@
 #include <stdlib.h> // rand()
 #include <omp.h>
 #include <stdbool.h>
-#include <math.h> // abs() miatt
 
 #include "entity_actions.h"
 #include "simulation_constants.h" // Paraméterekhez
 #include "world_utils.h"          // Pl. get_random_adjacent_empty_cell, is_valid_pos
 #include "simulation_utils.h"
-
-// 8 irányú szomszédságot ellenőriz.
-static bool are_positions_adjacent(Coordinates pos1, Coordinates pos2)
+#include "sim_random.h"
+#include "deterministic_step.h"
+#include "plant_layer.h"
+#include "species.h"
+#include "lifecycle_kernel.h"
+#include "topology.h"
+#include "sync_telemetry.h"
+#include "event_log.h"
+
+// 8 irányú szomszédságot ellenőriz (tóruszon a szélen át is).
+static bool are_positions_adjacent(const World *world, Coordinates pos1, Coordinates pos2)
 {
-    int dx = abs(pos1.x - pos2.x);
-    int dy = abs(pos1.y - pos2.y);
+    int dx = topology_axis_distance(pos1.x, pos2.x, world->topology->span_x);
+    int dy = topology_axis_distance(pos1.y, pos2.y, world->topology->span_y);
     // Szomszédosak, ha (dx <= 1 ÉS dy <= 1) ÉS (nem ugyanaz a pont, azaz dx != 0 VAGY dy != 0).
     // Ez lefedi a 8 lehetséges szomszédos mezőt.
     return (dx <= 1 && dy <= 1) && (dx != 0 || dy != 0);
 }
 
-// Növények akcióinak feldolgozása
-// A növények elsősorban szaporodnak, ha elegendő energiájuk van, letelt a szaporodási cooldown,
-// és a valószínűségi feltétel is teljesül.
-// Paraméterek:
-//  - world: A szimulációs világ pointere.
-//  - current_step_number: Az aktuális szimulációs lépés sorszáma.
-//  - current_plant_state: Pointer az eredeti növény állapotára a `world->entities` tömbben (csak olvasásra).
-//  - next_plant_state_prototype: Pointer a növény következő állapotának prototípusára, amit ez a függvény módosíthat.
-void process_plant_actions_parallel(World *world, int current_step_number, const Entity *current_plant_state, Entity *next_plant_state_prototype)
+// Táplálék célpont: vagy egy entitás, vagy (növényréteg esetén) egy növényt tartalmazó cella.
+typedef struct
+{
+    bool found;
+    Coordinates position;
+    Entity *entity; // NULL, ha a célpont a növényréteg egy cellája
+} FoodTarget;
+
+// A find_target_in_range egyetlen menete, amely (ha kérjük) a PERCEPTION_NEAR_RADIUS-on belüli
+// célpontokat is feljegyzi tömbsorrendben, hogy a mozgás utáni evéshez ne kelljen újra keresni.
+static void scan_targets(World *world, Coordinates center, int range, EntityType target_type, bool record_near, Perception *out)
 {
-    // Szaporodási feltételek ellenőrzése
-    if (next_plant_state_prototype->energy >= PLANT_INITIAL_ENERGY &&                                         // Elegendő energia a szaporodáshoz
-        (current_step_number - current_plant_state->last_reproduction_step) >= PLANT_REPRODUCTION_COOLDOWN && // Szaporodási cooldown letelt
-        ((double)rand() / RAND_MAX) < PLANT_REPRODUCTION_PROBABILITY)                                         // Véletlenszerű esély a szaporodásra
+    Entity *closest_target = NULL;
+    int min_manhattan_dist = range + 1;
+    int near_count = 0;
+    int span_x = world->topology->span_x;
+    int span_y = world->topology->span_y;
+
+    for (int i = 0; i < world->entity_count; ++i)
     {
-        // Üres szomszédos cella keresése az aktuális rácsállapot alapján
-        Coordinates empty_cell = get_random_adjacent_empty_cell(world, current_plant_state->position);
+        Entity *potential_target = &world->entities[i];
+        if (potential_target->type != target_type ||
+            potential_target->energy <= 0 || potential_target->energy == EATEN_ENERGY_MARKER)
+            continue;
 
-        // Ellenőrizzük, hogy a kapott cella érvényes-e és nem az eredeti pozíció
-        if (is_valid_pos(world, empty_cell.x, empty_cell.y) &&
-            (empty_cell.x != current_plant_state->position.x || empty_cell.y != current_plant_state->position.y))
+        int manhattan_dist = topology_axis_distance(potential_target->position.x, center.x, span_x) +
+                             topology_axis_distance(potential_target->position.y, center.y, span_y);
+        if (record_near && manhattan_dist <= PERCEPTION_NEAR_RADIUS && near_count >= 0)
         {
-            // Új növény csak akkor jön létre, ha a növények száma nem érte el a maximumot
-            if (count_entities_by_type(world, PLANT) < MAX_PLANTS)
-            {
-                Entity new_plant_candidate; // Új növény jelölt
-
-                // Új, egyedi ID generálása atomikusan a globális számlálóból
-                int new_id;
-#pragma omp atomic capture
-                new_id = world->next_entity_id++;
-                new_plant_candidate.id = new_id;
-
-                new_plant_candidate.type = PLANT;
-                new_plant_candidate.position = empty_cell;
-                new_plant_candidate.energy = PLANT_INITIAL_ENERGY; // Kezdeti energia az új növénynek
-                new_plant_candidate.age = 0;
-                new_plant_candidate.sight_range = 0;                              // Növénynek nincs látótávolsága
-                new_plant_candidate.last_reproduction_step = current_step_number; // Az új növény most "született", ez a legutóbbi szaporodása
-                new_plant_candidate.last_eating_step = -1;                        // Növény nem eszik
-                new_plant_candidate.just_spawned_by_keypress = false;
-
-                _commit_entity_to_next_state(world, new_plant_candidate);
-
-                // Az eredeti (szülő) növény utolsó szaporodási idejének frissítése a következő állapotban
-                next_plant_state_prototype->last_reproduction_step = current_step_number;
-            }
+            if (near_count < PERCEPTION_NEAR_CAPACITY)
+                out->near[near_count++] = i;
+            else
+                near_count = -1;
+        }
+        if (manhattan_dist <= range && manhattan_dist < min_manhattan_dist)
+        {
+            min_manhattan_dist = manhattan_dist;
+            closest_target = potential_target;
         }
     }
+
+    out->near_count = (signed char)near_count;
+    if (closest_target)
+    {
+        out->found = true;
+        out->target = closest_target;
+        out->target_position = closest_target->position;
+    }
 }
 
-// Növényevők akcióinak feldolgozása
-// Az akciók sorrendje és prioritása a következő:
-// 0. Kritikus evés: Ha az energia kritikusan alacsony, megpróbál enni egy szomszédos növényt
-// 1. Mozgás: Ha nem volt kritikus evés, megpróbál elmozdulni (növény felé vagy véletlenszerűen)
-// 2. Normál evés: Mozgás után (vagy ha nem mozgott és nem volt kritikus evés) megpróbál enni egy szomszédos növényt az új pozícióján
-// 3. Szaporodás: Ha nem evett (sem kritikusan, sem normálisan) és a feltételek adottak, megpróbál szaporodni
-// Az `action_taken_this_step` változó tárolja, hogy melyik fő akció történt meg
-// Paraméterek:
-//  - world
-//  - current_step_number: Az aktuális szimulációs lépés sorszáma.
-//  - current_herbivore_state_in_entities_array: Pointer az eredeti növényevő állapotára a `world->entities` tömbben; eredeti pozíció lekérdezése
-//  - next_herbivore_state_prototype: Pointer a növényevő következő állapotának prototípusára, amit ez a függvény módosít
-void process_herbivore_actions_parallel(World *world, int current_step_number, Entity *current_herbivore_state_in_entities_array, Entity *next_herbivore_state_prototype)
+void perceive_animal(World *world, const Entity *animal, Perception *out)
 {
-    int action_taken_this_step = 0; // 0: semmi, 1: kritikus evés, 2: mozgás, 3: normál evés, 4: szaporodás
-
-    // 0. Elsődleges ellenőrzés: Kritikus energia szintű evés
-    if (next_herbivore_state_prototype->energy < HERBIVORE_CRITICAL_ENERGY_THRESHOLD)
+    const SpeciesInfo *species = species_info(animal->type);
+    out->origin = animal->position;
+    out->target_position = animal->position;
+    out->target = NULL;
+    out->distance = 0;
+    out->found = false;
+    out->adjacent = false;
+    out->near_count = 0;
+    out->free_neighbours = free_neighbour_mask(world, animal->position);
+
+    if (animal->sight_range >= 0 && species->food != EMPTY)
     {
-        // Célpont keresése a látótávolságon belül.
-        Entity *target_plant = find_target_in_range(world, current_herbivore_state_in_entities_array->position, next_herbivore_state_prototype->sight_range, PLANT);
-        // Evés csak akkor, ha a célpont közvetlenül szomszédos.
-        if (target_plant && are_positions_adjacent(current_herbivore_state_in_entities_array->position, target_plant->position))
-        {
-            bool successfully_ate = false;
-            // Kritikus szakasz a célpont energiájának módosításához, megelőzve a versenyhelyzeteket,
-            // ha több növényevő is ugyanazt a növényt próbálná megenni egyszerre.
-            // Az `EATEN_ENERGY_MARKER` jelzi, hogy ezt a növényt már megették ebben a lépésben.
-#pragma omp critical // mivel több növényevő is ugyanazt a növényt probalhatja megenni
-            {
-                if (target_plant->energy > 0) // Ellenőrizzük, hogy a növény még ehető-e (van energiája).
-                {
-                    target_plant->energy = EATEN_ENERGY_MARKER; // Jelöljük megevettként.
-                    successfully_ate = true;
-                }
-            }
-            if (successfully_ate)
-            {
-                // next_herbivore_state_prototype->position = target_plant->position; // Ide lép az evés után
-                next_herbivore_state_prototype->position = current_herbivore_state_in_entities_array->position;
-                next_herbivore_state_prototype->energy += HERBIVORE_ENERGY_FROM_PLANT;
-                if (next_herbivore_state_prototype->energy > HERBIVORE_MAX_ENERGY)
-                {
-                    next_herbivore_state_prototype->energy = HERBIVORE_MAX_ENERGY;
-                }
-                next_herbivore_state_prototype->last_eating_step = current_step_number;
-                action_taken_this_step = 1; // Kritikus evés
-            }
-        }
+        if (species->food == PLANT && world->plants)
+            out->found = plant_layer_find_nearest(world->plants, world->topology, animal->position, animal->sight_range, &out->target_position);
+        else
+            scan_targets(world, animal->position, animal->sight_range, species->food, species->eats_after_move, out);
     }
-
-    // 1. Mozgás (ha nem történt kritikus evés)
-    if (!action_taken_this_step &&
-        next_herbivore_state_prototype->energy > HERBIVORE_MOVE_COST)
+    if (out->found)
     {
-        Coordinates old_pos = current_herbivore_state_in_entities_array->position;
-        Coordinates new_pos = old_pos;
+        out->distance = topology_distance(world->topology, out->target_position, out->origin);
+        out->adjacent = are_positions_adjacent(world, out->origin, out->target_position);
+    }
+}
 
-        Entity *target_plant_for_move = find_target_in_range(world, old_pos, next_herbivore_state_prototype->sight_range, PLANT);
+// A mozgás utáni pozíció körüli legközelebbi célpont a feljegyzett közeli célpontokból.
+// A szomszédos célpont legfeljebb 2 távolságra van az új, így legfeljebb 4-re a régi helytől, ezért
+// a near[] lista minden jelöltet tartalmaz; azonos távolságnál a tömbsorrend dönt, mint a teljes
+// keresésben. Ha a lista túlcsordult, teljes keresés.
+static Entity *nearest_target_after_move(World *world, const Perception *perception, Coordinates center, int range, EntityType target_type)
+{
+    if (perception->near_count < 0)
+        return find_target_in_range(world, center, range, target_type);
 
-        if (target_plant_for_move)
-        {
-            new_pos = get_step_towards_target(world, old_pos, target_plant_for_move->position);
-        }
-        else
+    Entity *closest_target = NULL;
+    int min_manhattan_dist = range + 1;
+    for (int k = 0; k < perception->near_count; k++)
+    {
+        Entity *potential_target = &world->entities[perception->near[k]];
+        if (potential_target->energy <= 0 || potential_target->energy == EATEN_ENERGY_MARKER)
+            continue;
+        int manhattan_dist = topology_distance(world->topology, potential_target->position, center);
+        if (manhattan_dist <= range && manhattan_dist < min_manhattan_dist)
         {
-            new_pos = get_random_adjacent_empty_cell(world, old_pos);
+            min_manhattan_dist = manhattan_dist;
+            closest_target = potential_target;
         }
+    }
+    return closest_target;
+}
 
-        if (is_valid_pos(world, new_pos.x, new_pos.y) && (new_pos.x != old_pos.x || new_pos.y != old_pos.y))
-        {
-            next_herbivore_state_prototype->position = new_pos;
-            next_herbivore_state_prototype->energy -= HERBIVORE_MOVE_COST;
-            action_taken_this_step = 2; // Speciális érték, hogy tudjuk, mozgás történt
-        }
+// Szabad szomszéd a pozíció körül: az érzékelés helyén a tárolt maszkból, máshol újraszámolva.
+static Coordinates random_free_neighbour(World *world, const Perception *perception, Coordinates pos)
+{
+    if (pos.x == perception->origin.x && pos.y == perception->origin.y)
+        return pick_random_free_neighbour(world, pos, perception->free_neighbours);
+    return get_random_adjacent_empty_cell(world, pos);
+}
+
+// Megpróbálja "megenni" a célpontot, azaz EATEN_ENERGY_MARKER-rel jelölni.
+// Normál módban kritikus szakasz dönti el, melyik szál ér oda először.
+// Determinisztikus módban csak foglalás történik; a lépés végén a legkisebb indexű
+// foglaló nyer (lásd deterministic_step.c), a vesztesek újrafutnak.
+static bool try_eat_target(World *world, Entity *target)
+{
+    if (world->deterministic)
+    {
+        return deterministic_reserve_target(world, target);
     }
 
-    // 2. Táplálkozás (normál), ha nem történt kritikus evés
-    if (action_taken_this_step != 1 && action_taken_this_step != 2) // Ha nem volt kritikus evés és nem volt mozgás
+    bool successfully_ate = false;
+    SYNC_PROBE_BEGIN(probe);
+#pragma omp critical // mivel több entitás is ugyanazt a célpontot probalhatja megenni
     {
-        // Célpont keresése az aktuális (next_herbivore_state_prototype->position) pozíció körül.
-        Entity *target_plant_for_eat = find_target_in_range(world, next_herbivore_state_prototype->position, next_herbivore_state_prototype->sight_range, PLANT);
-        if (target_plant_for_eat && are_positions_adjacent(next_herbivore_state_prototype->position, target_plant_for_eat->position))
+        SYNC_PROBE_END(probe, SYNC_EAT_CRITICAL);
+        if (target->energy > 0) // Ellenőrizzük, hogy a célpont még ehető-e (van energiája).
         {
-            bool successfully_ate = false;
-            // Kritikus szakasz a célpont energiájának módosításához.
-#pragma omp critical
-            {
-                // Fontos ellenőrizni, hogy a célpont (target_plant_for_eat) még mindig létezik és ehető-e.
-                // A find_target_in_range a world->entities alapján keres, de a target_plant_for_eat->energy értéke
-                // frissülhetett más szálak által (ezért a kritikus szakasz).
-                if (target_plant_for_eat->energy > 0)
-                {
-                    target_plant_for_eat->energy = EATEN_ENERGY_MARKER;
-                    successfully_ate = true;
-                }
-            }
-            if (successfully_ate)
-            {
-                // next_herbivore_state_prototype->position = target_plant_for_eat->position; // Ide lép az evés után
-                next_herbivore_state_prototype->position = current_herbivore_state_in_entities_array->position;
-                next_herbivore_state_prototype->energy += HERBIVORE_ENERGY_FROM_PLANT;
-                if (next_herbivore_state_prototype->energy > HERBIVORE_MAX_ENERGY)
-                {
-                    next_herbivore_state_prototype->energy = HERBIVORE_MAX_ENERGY;
-                }
-                next_herbivore_state_prototype->last_eating_step = current_step_number;
-                action_taken_this_step = 3; // Akció megtörtént (normál evés)
-            }
+            target->energy = EATEN_ENERGY_MARKER; // Jelöljük megevettként.
+            successfully_ate = true;
         }
     }
+    return successfully_ate;
+}
 
-    // 3. Szaporodás megpróbálása (ha nem történt kritikus evés, és nem történt normál evés)
-    // Csak akkor szaporodik, ha van elég energiája, letelt a cooldown, és marad elég energia a túléléshez.
-    if (action_taken_this_step != 1 && action_taken_this_step != 3 &&
-        next_herbivore_state_prototype->energy >= HERBIVORE_REPRODUCTION_THRESHOLD &&
-        (current_step_number - current_herbivore_state_in_entities_array->last_reproduction_step) >= HERBIVORE_REPRODUCTION_COOLDOWN &&
-        (next_herbivore_state_prototype->energy - HERBIVORE_REPRODUCTION_COST) > HERBIVORE_MOVE_COST) // Maradjon elég energia
+// Növény legelése: a növényréteg celláját közvetlenül olvassuk és ürítjük, az entitásokat try_eat_target-tel.
+static bool try_eat_plant(World *world, const FoodTarget *food)
+{
+    if (food->entity)
     {
-        Coordinates empty_cell = get_random_adjacent_empty_cell(world, next_herbivore_state_prototype->position);
-        if (is_valid_pos(world, empty_cell.x, empty_cell.y) &&
-            (empty_cell.x != next_herbivore_state_prototype->position.x || empty_cell.y != next_herbivore_state_prototype->position.y))
-        {
-            // Új növényevő csak akkor jön létre, ha a növényevők száma nem érte el a maximumot.
-            if (count_entities_by_type(world, HERBIVORE) < MAX_HERBIVORES)
-            {
-                next_herbivore_state_prototype->energy -= HERBIVORE_REPRODUCTION_COST;
-                next_herbivore_state_prototype->last_reproduction_step = current_step_number;
+        return try_eat_target(world, food->entity);
+    }
+    if (world->deterministic)
+    {
+        return deterministic_reserve_cell(world, food->position.y * world->width + food->position.x);
+    }
+    return plant_layer_try_graze(world->plants, food->position.x, food->position.y);
+}
+
+// Új, egyedi ID kiosztása atomikusan a globális számlálóból.
+// Determinisztikus módban az ID-t a fázis végi tömörítés osztja ki a szülők sorrendjében,
+// ezért itt csak egy ideiglenes (-1) jelölőt adunk vissza.
+static int allocate_entity_id(World *world)
+{
+    if (world->deterministic)
+    {
+        return -1;
+    }
 
-                Entity new_herbivore_candidate;
-                int new_id;
+    int new_id;
+    SYNC_PROBE_BEGIN(probe);
 #pragma omp atomic capture
-                new_id = world->next_entity_id++;
-                new_herbivore_candidate.id = new_id;
-                new_herbivore_candidate.type = HERBIVORE;
-                new_herbivore_candidate.position = empty_cell;
-                new_herbivore_candidate.energy = HERBIVORE_INITIAL_ENERGY;
-                new_herbivore_candidate.age = 0;
-                new_herbivore_candidate.sight_range = HERBIVORE_SIGHT_RANGE;
-                new_herbivore_candidate.last_reproduction_step = current_step_number; // Újszülött most szaporodott "először"
-                new_herbivore_candidate.last_eating_step = -1;
-                new_herbivore_candidate.just_spawned_by_keypress = false;
-                _commit_entity_to_next_state(world, new_herbivore_candidate);
-
-                action_taken_this_step = 4; // Akció megtörtént (szaporodás)
-            }
-        }
+    new_id = world->next_entity_id++;
+    SYNC_PROBE_END(probe, SYNC_ENTITY_ID);
+    return new_id;
+}
+
+// Evés: a célpont megjelölése/foglalása, és siker esetén az energia jóváírása a faj szerint.
+static bool eat_food(World *world, const SpeciesInfo *species, int current_step_number, const FoodTarget *food, Entity *next_state)
+{
+    // A célpont energiájának módosítása versenyhelyzet-mentesen, ha több állat is ugyanazt
+    // a célpontot próbálná megenni egyszerre (lásd try_eat_target).
+    if (!try_eat_plant(world, food))
+        return false;
+    // Determinisztikus módban a foglalás csak spekulatív; a naplóba a feloldás nyertese kerül
+    if (world->events && !world->deterministic)
+    {
+        EntityType food_type = food->entity ? food->entity->type : PLANT;
+        event_log_record(world->events, food_type == PLANT ? EVENT_GRAZE : EVENT_PREDATION, current_step_number,
+                         next_state, food->entity ? food->entity->id : -1, food_type, food->position);
+    }
+    next_state->energy += species->energy_from_food;
+    if (next_state->energy > species->max_energy)
+    {
+        next_state->energy = species->max_energy;
     }
+    next_state->last_eating_step = current_step_number;
+    return true;
+}
+
+// Igaz, ha az érzékelt célpont még ehető. Az érzékelés a fázis elején fut, a fázisban korábban
+// sorra kerülő állatok azóta megehették (nem determinisztikus módban azonnal jelölnek).
+static bool perceived_target_alive(const World *world, const Perception *perception)
+{
+    if (!perception->found)
+        return true;
+    if (perception->target)
+        return perception->target->energy > 0 && perception->target->energy != EATEN_ENERGY_MARKER;
+    return !world->plants || plant_layer_occupied(world->plants, perception->target_position.x, perception->target_position.y);
 }
 
-// Ragadozók akcióinak feldolgozása
-// Az akciók sorrendje és prioritása hasonló a növényevőkéhez:
-// 0. Kritikus evés: Ha az energia kritikusan alacsony, megpróbál enni egy szomszédos növényevőt
-// 1. Mozgás: Ha nem volt kritikus evés, megpróbál elmozdulni (növényevő felé vagy véletlenszerűen)
-// 2. Normál evés: Mozgás után (vagy ha nem mozgott és nem volt kritikus evés) megpróbál enni egy szomszédos növényevőt
-// 3. Szaporodás: Ha nem evett és a feltételek adottak, megpróbál szaporodni
+// Egy entitás akcióinak feldolgozása a fajtábla alapján, bármely fajra.
+// Az akciók sorrendje és prioritása a következő:
+// 0. Kritikus evés: Ha az energia a faj kritikus szintje alatt van, megpróbál enni egy szomszédos zsákmányt
+// 1. Mozgás: Ha nem volt kritikus evés, megpróbál elmozdulni (zsákmány felé vagy véletlenszerűen)
+// 2. Normál evés: Ha nem volt kritikus evés, és nem mozgott (vagy a faj mozgás után is eszik)
+// 3. Szaporodás: Ha nem evett, és a feltételek (energia, cooldown, esély, létszámplafon) adottak
+// Az autotróf fajok (növények) csak a 3. pontot futtatják.
+// Az `action_taken_this_step` változó tárolja, hogy melyik fő akció történt meg
 // Paraméterek:
 //  - world
 //  - current_step_number: Az aktuális szimulációs lépés sorszáma.
-//  - current_carnivore_state_in_entities_array: Pointer az eredeti ragadozó állapotára a world->entities tömbben
-//  - next_carnivore_state_prototype: Pointer a ragadozó következő állapotának prototípusára
-void process_carnivore_actions_parallel(World *world, int current_step_number, Entity *current_carnivore_state_in_entities_array, Entity *next_carnivore_state_prototype)
+//  - current_state: Pointer az eredeti állapotra (csak olvasásra); eredeti pozíció lekérdezése
+//  - next_state_prototype: Pointer a következő állapot prototípusára, amit ez a függvény módosít
+//  - perception: Az állat ebben a lépésben előre kiszámolt érzékelése (perceive_animal); autotrófoknál NULL
+void process_species_actions(World *world, int current_step_number, const Entity *current_state, Entity *next_state_prototype, const Perception *perception)
 {
+    const SpeciesInfo *species = species_info(current_state->type);
     int action_taken_this_step = 0; // 0: semmi, 1: kritikus evés, 2: mozgás, 3: normál evés, 4: szaporodás
+    Perception refreshed;           // Újraérzékelés eredménye; a szaporodás szabad-szomszéd keresése is ezt olvassa
 
-    // 0. Elsődleges ellenőrzés: Kritikus energia szintű evés
-    if (next_carnivore_state_prototype->energy < CARNIVORE_CRITICAL_ENERGY_THRESHOLD)
+    if (!species_is_autotroph(current_state->type))
     {
-        // Célpont (növényevő) keresése a látótávolságon belül, az eredeti pozíció alapján
-        Entity *target_herbivore = find_target_in_range(world, current_carnivore_state_in_entities_array->position, next_carnivore_state_prototype->sight_range, HERBIVORE);
-        // Evés csak akkor, ha a célpont közvetlenül szomszédos
-        if (target_herbivore && are_positions_adjacent(current_carnivore_state_in_entities_array->position, target_herbivore->position))
+        // Elfogyott célpont: újraérzékelés, hogy ne a halott célpont felé lépjen
+        if (!perceived_target_alive(world, perception))
         {
-            bool successfully_ate_herbivore = false;
-            // Kritikus szakasz a célpont (növényevő) energiájának módosítására
-#pragma omp critical
-            {
-                if (target_herbivore->energy > 0) // Ellenőrizzük, hogy a növényevő még ehető-e
-                {
-                    target_herbivore->energy = EATEN_ENERGY_MARKER; // Jelöljük megevettként
-                    successfully_ate_herbivore = true;
-                }
-            }
-            if (successfully_ate_herbivore)
-            {
-                // next_carnivore_state_prototype->position = target_herbivore->position;
-                next_carnivore_state_prototype->position = current_carnivore_state_in_entities_array->position;
-                next_carnivore_state_prototype->energy += CARNIVORE_ENERGY_FROM_HERBIVORE;
-                if (next_carnivore_state_prototype->energy > CARNIVORE_MAX_ENERGY)
-                {
-                    next_carnivore_state_prototype->energy = CARNIVORE_MAX_ENERGY;
-                }
-                next_carnivore_state_prototype->last_eating_step = current_step_number;
-                action_taken_this_step = 1; // Kritikus evés
-            }
+            perceive_animal(world, current_state, &refreshed);
+            perception = &refreshed;
         }
-    }
 
-    // 1. Mozgás (ha nem történt kritikus evés)
-    // Célpont (növényevő) keresése a látótávolságon belül, és afelé lépés
-    // Ha nincs célpont, véletlenszerű mozgás
-    if (!action_taken_this_step &&
-        next_carnivore_state_prototype->energy > CARNIVORE_MOVE_COST)
-    {
-        Coordinates old_pos = current_carnivore_state_in_entities_array->position;
-        Coordinates new_pos = old_pos;
-
-        Entity *target_herb_for_move = find_target_in_range(world, old_pos, next_carnivore_state_prototype->sight_range, HERBIVORE);
+        // A legközelebbi zsákmány a lépés eleji pozícióból
+        FoodTarget food = {perception->found, perception->target_position, perception->target};
 
-        if (target_herb_for_move)
-        {
-            new_pos = get_step_towards_target(world, old_pos, target_herb_for_move->position);
-        }
-        else
+        // 0. Elsődleges ellenőrzés: Kritikus energia szintű evés, csak közvetlenül szomszédos célpontra
+        if (next_state_prototype->energy < species->critical_energy && perception->found && perception->adjacent &&
+            eat_food(world, species, current_step_number, &food, next_state_prototype))
         {
-            new_pos = get_random_adjacent_empty_cell(world, old_pos);
+            next_state_prototype->position = current_state->position;
+            action_taken_this_step = 1; // Kritikus evés
         }
 
-        if (is_valid_pos(world, new_pos.x, new_pos.y) && (new_pos.x != old_pos.x || new_pos.y != old_pos.y))
+        // 1. Mozgás (ha nem történt kritikus evés)
+        if (!action_taken_this_step && next_state_prototype->energy > species->move_cost)
         {
-            next_carnivore_state_prototype->position = new_pos;
-            next_carnivore_state_prototype->energy -= CARNIVORE_MOVE_COST;
-            action_taken_this_step = 2; // Mozgás történt
+            Coordinates old_pos = current_state->position;
+            Coordinates new_pos = perception->found
+                                      ? step_towards_target_masked(world, old_pos, perception->target_position, perception->free_neighbours)
+                                      : pick_random_free_neighbour(world, old_pos, perception->free_neighbours);
+
+            if (is_valid_pos(world, new_pos.x, new_pos.y) && (new_pos.x != old_pos.x || new_pos.y != old_pos.y))
+            {
+                next_state_prototype->position = new_pos;
+                next_state_prototype->energy -= species->move_cost;
+                action_taken_this_step = 2; // Mozgás történt
+            }
         }
-    }
 
-    // 2. Táplálkozás (normál), ha nem történt kritikus evés
-    if (action_taken_this_step != 1)
-    {
-        // Célpont keresése az aktuális (next_carnivore_state_prototype->position) pozíció körül
-        Entity *target_herbivore_for_eat = find_target_in_range(world, next_carnivore_state_prototype->position, next_carnivore_state_prototype->sight_range, HERBIVORE);
-        if (target_herbivore_for_eat && are_positions_adjacent(next_carnivore_state_prototype->position, target_herbivore_for_eat->position))
+        // 2. Táplálkozás (normál): helyben maradva az érzékelés eredménye, mozgás után a feljegyzett
+        //    közeli célpontok közül (csak a mozgás után is evő fajoknál)
+        if (action_taken_this_step == 0 || (action_taken_this_step == 2 && species->eats_after_move))
         {
-            bool successfully_ate_herbivore = false;
-            // Kritikus szakasz a célpont energiájának módosításához.
-#pragma omp critical
+            Coordinates eat_pos = next_state_prototype->position;
+            if (eat_pos.x != perception->origin.x || eat_pos.y != perception->origin.y)
             {
-                if (target_herbivore_for_eat->energy > 0)
-                {
-                    target_herbivore_for_eat->energy = EATEN_ENERGY_MARKER;
-                    successfully_ate_herbivore = true;
-                }
+                Entity *moved_target = nearest_target_after_move(world, perception, eat_pos, current_state->sight_range, species->food);
+                food.found = moved_target != NULL;
+                food.entity = moved_target;
+                food.position = moved_target ? moved_target->position : eat_pos;
             }
-            if (successfully_ate_herbivore)
+            if (food.found && are_positions_adjacent(world, eat_pos, food.position) &&
+                eat_food(world, species, current_step_number, &food, next_state_prototype))
             {
-                next_carnivore_state_prototype->position = target_herbivore_for_eat->position; // Ide lép az evés után
-                // next_carnivore_state_prototype->position = current_carnivore_state_in_entities_array->position;
-                next_carnivore_state_prototype->energy += CARNIVORE_ENERGY_FROM_HERBIVORE;
-                if (next_carnivore_state_prototype->energy > CARNIVORE_MAX_ENERGY)
-                {
-                    next_carnivore_state_prototype->energy = CARNIVORE_MAX_ENERGY;
-                }
-                next_carnivore_state_prototype->last_eating_step = current_step_number;
+                next_state_prototype->position = species->moves_onto_food ? food.position : current_state->position;
                 action_taken_this_step = 3; // Normál evés
             }
         }
     }
 
     // 3. Szaporodás megpróbálása (ha nem történt sem kritikus, sem normál evés)
+    // Csak akkor szaporodik, ha van elég energiája, letelt a cooldown, marad elég energia a mozgáshoz,
+    // és a valószínűségi feltétel is teljesül.
     if (action_taken_this_step != 1 && action_taken_this_step != 3 &&
-        next_carnivore_state_prototype->energy >= CARNIVORE_REPRODUCTION_THRESHOLD &&
-        (current_step_number - current_carnivore_state_in_entities_array->last_reproduction_step) >= CARNIVORE_REPRODUCTION_COOLDOWN &&
-        (next_carnivore_state_prototype->energy - CARNIVORE_REPRODUCTION_COST) > CARNIVORE_MOVE_COST) // Maradjon elég energia
+        next_state_prototype->energy >= species->reproduction_threshold &&
+        (current_step_number - current_state->last_reproduction_step) >= species->reproduction_cooldown &&
+        (next_state_prototype->energy - species->reproduction_cost) > species->move_cost &&
+        (species->reproduction_probability >= 1.0 || ((double)sim_rand() / SIM_RAND_MAX) < species->reproduction_probability))
     {
-        Coordinates empty_cell = get_random_adjacent_empty_cell(world, next_carnivore_state_prototype->position);
-        if (is_valid_pos(world, empty_cell.x, empty_cell.y) &&
-            (empty_cell.x != next_carnivore_state_prototype->position.x || empty_cell.y != next_carnivore_state_prototype->position.y))
+        Coordinates parent_pos = next_state_prototype->position;
+        Coordinates empty_cell = perception ? random_free_neighbour(world, perception, parent_pos)
+                                            : get_random_adjacent_empty_cell(world, parent_pos);
+        if (is_valid_pos(world, empty_cell.x, empty_cell.y) && (empty_cell.x != parent_pos.x || empty_cell.y != parent_pos.y))
         {
-            // Új ragadozó csak akkor jön létre, ha a ragadozók száma nem érte el a maximumot
-            if (count_entities_by_type(world, CARNIVORE) < MAX_CARNIVORES)
+            // Új egyed csak akkor jön létre, ha a faj létszáma nem érte el a maximumot.
+            if (count_entities_by_type(world, current_state->type) < world->population_cap[current_state->type])
             {
-                next_carnivore_state_prototype->energy -= CARNIVORE_REPRODUCTION_COST;
-                next_carnivore_state_prototype->last_reproduction_step = current_step_number;
-
-                Entity new_carnivore_candidate;
-                int new_id;
-#pragma omp atomic capture
-                new_id = world->next_entity_id++;
-                new_carnivore_candidate.id = new_id;
-                new_carnivore_candidate.type = CARNIVORE;
-                new_carnivore_candidate.position = empty_cell;
-                new_carnivore_candidate.energy = CARNIVORE_INITIAL_ENERGY;
-                new_carnivore_candidate.age = 0;
-                new_carnivore_candidate.sight_range = CARNIVORE_SIGHT_RANGE;
-                new_carnivore_candidate.last_reproduction_step = current_step_number;
-                new_carnivore_candidate.last_eating_step = -1;
-                new_carnivore_candidate.just_spawned_by_keypress = false;
-                _commit_entity_to_next_state(world, new_carnivore_candidate);
+                next_state_prototype->energy -= species->reproduction_cost;
+                next_state_prototype->last_reproduction_step = current_step_number;
+
+                Entity newborn;
+                newborn.id = allocate_entity_id(world);
+                newborn.type = current_state->type;
+                newborn.position = empty_cell;
+                newborn.energy = species->initial_energy;
+                newborn.age = 0;
+                newborn.sight_range = species->sight_range;
+                newborn.last_reproduction_step = current_step_number; // Újszülött most szaporodott "először"
+                newborn.last_eating_step = -1;
+                newborn.just_spawned_by_keypress = false;
+                // Csak a ténylegesen véglegesített születés kerül a naplóba (a megtelt next_entities eldobja)
+                bool committed = _commit_entity_to_next_state(world, newborn);
+                if (committed && world->events && !world->deterministic) // Determinisztikus módban az ID a tömörítéskor születik
+                    event_log_record(world->events, EVENT_BIRTH, current_step_number, current_state, newborn.id,
+                                     newborn.type, empty_cell);
 
                 action_taken_this_step = 4; // Szaporodás
             }
@@ -365,13 +346,36 @@ void process_carnivore_actions_parallel(World *world, int current_step_number, E
     }
 }
 
+void process_species_entity(World *world, int current_step_number, int index)
+{
+    int initial_shared_energy;
+#pragma omp atomic read
+    initial_shared_energy = world->entities[index].energy;
+
+    if (initial_shared_energy == EATEN_ENERGY_MARKER) // Lehet, hogy egy korábbi fázisban megették
+    {
+        return;
+    }
+
+    Entity next_entity_prototype = world->entities[index];
+    lifecycle_apply(world->lifecycle, index, &next_entity_prototype);
+
+    process_species_actions(world, current_step_number, &world->entities[index], &next_entity_prototype,
+                            species_is_autotroph(next_entity_prototype.type) ? NULL : &world->perception[index]);
+
+    if (next_entity_prototype.energy > 0)
+    {
+        _commit_entity_to_next_state(world, next_entity_prototype);
+    }
+}
+
 // Segédfüggvény, amely megkeresi a legközelebbi, adott típusú célpontot a megadott center pozíció körüli range látótávolságon belül
 // Csak élő (pozitív energiájú) és még nem megevett entitásokat vesz figyelembe
 // A keresés a world->entities tömbön (azaz a szimulációs lépés eleji állapoton) történik
 // Végigiterál az összes entitáson, és kiválasztja azt, amelyik:
 //  1. Megfelel a target_type-nak
 //  2. Élő és nem EATEN_ENERGY_MARKER
-//  3. A center-től számított Manhattan-távolsága kisebb vagy egyenlő, mint range
+//  3. A center-től számított Manhattan-távolsága (tóruszon a rövidebb irány szerint) kisebb vagy egyenlő, mint range
 //  4. Az összes ilyen közül a legkisebb Manhattan-távolsággal rendelkezik
 // Ha több entitás is azonos minimális távolságra van, az iteráció során először megtaláltat adja vissza
 // Visszaadja a legközelebbi célpontra mutató pointert, vagy NULL-t, ha nincs ilyen
@@ -382,6 +386,8 @@ Entity *find_target_in_range(World *world, Coordinates center, int range, Entity
 
     Entity *closest_target = NULL;
     int min_manhattan_dist = range + 1; // Kezdeti minimális távolság, aminél nagyobbat nem fogadunk el.
+    int span_x = world->topology->span_x;
+    int span_y = world->topology->span_y;
 
     for (int i = 0; i < world->entity_count; ++i)
     {
@@ -390,8 +396,8 @@ Entity *find_target_in_range(World *world, Coordinates center, int range, Entity
         if (potential_target->type == target_type &&
             potential_target->energy > 0 && potential_target->energy != EATEN_ENERGY_MARKER)
         {
-            int dx = abs(potential_target->position.x - center.x);
-            int dy = abs(potential_target->position.y - center.y);
+            int dx = topology_axis_distance(potential_target->position.x, center.x, span_x);
+            int dy = topology_axis_distance(potential_target->position.y, center.y, span_y);
             int manhattan_dist = dx + dy;
 
             if (manhattan_dist <= range) // Hatótávon belül van.
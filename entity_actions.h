@@ -3,9 +3,36 @@
 
 #include "datatypes.h" // Szükséges a World, Entity, EntityType, Coordinates típusokhoz
 
-void process_plant_actions_parallel(World *world, int current_step_number, const Entity *current_plant_state, Entity *next_plant_state_prototype);
-void process_herbivore_actions_parallel(World *world, int current_step_number, Entity *current_herbivore_state_in_entities_array, Entity *next_herbivore_state_prototype);
-void process_carnivore_actions_parallel(World *world, int current_step_number, Entity *current_carnivore_state_in_entities_array, Entity *next_carnivore_state_prototype);
+#define PERCEPTION_NEAR_RADIUS 4   // Ennyi Manhattan-távolságon belüli célpontokat jegyzünk fel a mozgás utáni evéshez
+#define PERCEPTION_NEAR_CAPACITY 8 // Ha több van, a mozgás utáni evés teljes keresésre esik vissza
+
+// Egy állat lépésenkénti érzékelése: a legközelebbi táplálék a látótávolságon belül (egyetlen
+// lekérdezés), és a szabad szomszédos cellák maszkja. A döntési lánc (kritikus evés, mozgás,
+// evés, szaporodás) csak ebből olvas, így az érzékelés egy külön, kötegelhető menet.
+struct Perception
+{
+    Coordinates origin;          // Az érzékelés helye (az állat lépés eleji pozíciója)
+    Coordinates target_position; // A legközelebbi táplálék helye (ha found)
+    Entity *target;              // NULL, ha nincs célpont vagy a célpont a növényréteg egy cellája
+    int distance;                // Manhattan-távolság (legfeljebb a látótávolság)
+    bool found;
+    bool adjacent;               // A célpont közvetlenül szomszédos (8 irány)
+    unsigned char free_neighbours; // Bit i: a 8 irány közül az i. szabad (lásd free_neighbour_mask)
+    signed char near_count;      // A near[] elemszáma; -1, ha túlcsordult
+    int near[PERCEPTION_NEAR_CAPACITY]; // PERCEPTION_NEAR_RADIUS-on belüli célpontok indexei, tömbsorrendben
+};
+
+// Az érzékelési menet: egy állat (nem autotróf faj) érzékelésének kitöltése.
+void perceive_animal(World *world, const Entity *animal, Perception *out);
+
+// Az általános viselkedési kernel: egy entitás akciói a fajtábla (species.h) alapján.
+// A perception az állat érzékelése; autotróf fajoknál (növények) NULL.
+void process_species_actions(World *world, int current_step_number, const Entity *current_state, Entity *next_state_prototype, const Perception *perception);
+
+// Egy entitás normál (nem determinisztikus) lépése a fázisában: kimarad, ha egy korábbi fázisban
+// megették; különben az elő-menet eredménye, a kernel, és a túlélő véglegesítése. Állatoknál az
+// érzékelésnek (world->perception[index]) már késznek kell lennie.
+void process_species_entity(World *world, int current_step_number, int index);
 
 // Segédfüggvény célpont kereséséhez
 Entity *find_target_in_range(World *world, Coordinates center, int range, EntityType target_type);
@@ -0,0 +1,111 @@
+// Dekódoló a szimulátor bináris eseménynaplójához (--event-log; formátum: event_log_format.h).
+// A rekordokat CSV-ként írja a stdout-ra, egy sor eseményenként, a naplóbeli sorrendben.
+//
+// Használat: ecosim_event_decode FILE|- [--filter LIST]
+//   --filter LIST  csak a felsorolt fajták (pl. birth,death vagy predation,graze)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "event_log_format.h"
+
+#define READ_CHUNK 4096 // Rekord olvasásonként
+
+static const char *type_names[] = {"empty", "plant", "herbivore", "carnivore"};
+
+static const char *type_name(uint8_t type)
+{
+    return type < sizeof(type_names) / sizeof(type_names[0]) ? type_names[type] : "?";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Használat: %s FILE|- [--filter LIST]\n", argv[0]);
+        return 1;
+    }
+    uint32_t filter = EVENT_FILTER_ALL;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            if (!event_filter_parse(argv[++i], &filter))
+            {
+                fprintf(stderr, "Hibás eseményszűrő: %s (birth, age_death, starvation, death, predation, graze, all)\n", argv[i]);
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Ismeretlen kapcsoló: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FILE *in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror("Hiba az eseménynapló megnyitásakor");
+        return 1;
+    }
+
+    EventLogHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1)
+    {
+        fprintf(stderr, "Hiba: a napló túl rövid vagy nem olvasható.\n");
+        if (in != stdin)
+            fclose(in);
+        return 1;
+    }
+    if (header.magic != EVENT_LOG_MAGIC || header.version != EVENT_LOG_VERSION ||
+        header.header_size < sizeof(header) || header.record_size != sizeof(EventRecord))
+    {
+        fprintf(stderr, "Hiba: ismeretlen napló formátum (magic %08x, verzió %u, rekord %u bájt).\n", header.magic,
+                header.version, header.record_size);
+        if (in != stdin)
+            fclose(in);
+        return 1;
+    }
+    // Egy későbbi, hosszabb fejléc ismeretlen részének átugrása
+    for (uint32_t skipped = sizeof(header); skipped < header.header_size; skipped++)
+    {
+        if (fgetc(in) == EOF)
+        {
+            fprintf(stderr, "Hiba: a napló fejléce csonka.\n");
+            if (in != stdin)
+                fclose(in);
+            return 1;
+        }
+    }
+
+    static EventRecord records[READ_CHUNK];
+    unsigned long long total = 0;
+    unsigned long long printed = 0;
+    size_t count;
+    printf("step,event,actor_id,actor_type,target_id,target_type,x,y\n");
+    while ((count = fread(records, sizeof(EventRecord), READ_CHUNK, in)) > 0)
+    {
+        for (size_t k = 0; k < count; k++)
+        {
+            const EventRecord *record = &records[k];
+            total++;
+            if (record->kind >= EVENT_KIND_COUNT || !(filter & (1u << record->kind)))
+                continue;
+            printf("%d,%s,%d,%s,%d,%s,%d,%d\n", record->step, event_kind_names[record->kind], record->actor_id,
+                   type_name(record->actor_type), record->target_id,
+                   record->target_id < 0 && record->target_type == 0 ? "" : type_name(record->target_type),
+                   record->x, record->y);
+            printed++;
+        }
+    }
+    bool failed = ferror(in) != 0;
+    if (failed)
+        perror("Hiba az eseménynapló olvasásakor");
+    if (in != stdin)
+        fclose(in);
+    fprintf(stderr, "%llu rekord, %llu kiírva (a naplóban rögzített fajták: %#x)\n", total, printed, header.filter);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <omp.h>
+
+#include "event_log.h"
+#include "lifecycle_kernel.h"
+#include "memory_accounting.h"
+
+#define EVENT_BUFFER_INITIAL 256 // Rekord szálanként az első bővítéskor
+
+// Egy szál gyűjtőpuffere; cache-sorhoz igazítva, hogy a szálak számlálói ne osszanak sort
+typedef struct
+{
+    EventRecord *records;
+    size_t count;
+    size_t capacity;
+} __attribute__((aligned(64))) EventBuffer;
+
+struct EventLog
+{
+    FILE *file;
+    uint32_t filter;
+    int thread_capacity;
+    EventBuffer *active;  // A szimuláció szálai írják (szálindex szerint)
+    EventBuffer *pending; // Az író szál üríti, amíg batch_ready igaz
+
+    EventRecord *merged; // Az író szál összefésülő munkaterülete
+    size_t merged_capacity;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool batch_ready; // A pending készlet az íróé
+    bool stopping;
+    bool write_failed;
+
+    unsigned long long written;
+    unsigned long long dropped; // Foglalási hiba vagy túl nagy szálindex miatt elveszett rekordok
+};
+
+static int compare_records(const void *a, const void *b)
+{
+    const EventRecord *x = (const EventRecord *)a;
+    const EventRecord *y = (const EventRecord *)b;
+    if (x->step != y->step)
+        return x->step < y->step ? -1 : 1;
+    if (x->kind != y->kind)
+        return x->kind < y->kind ? -1 : 1;
+    if (x->actor_id != y->actor_id)
+        return x->actor_id < y->actor_id ? -1 : 1;
+    if (x->target_id != y->target_id)
+        return x->target_id < y->target_id ? -1 : 1;
+    if (x->y != y->y)
+        return x->y < y->y ? -1 : 1;
+    return (x->x > y->x) - (x->x < y->x);
+}
+
+// Egy átadott készlet összefésülése, rendezése és kiírása (az író szálon, zár nélkül)
+static void write_batch(EventLog *log)
+{
+    size_t total = 0;
+    for (int t = 0; t < log->thread_capacity; t++)
+        total += log->pending[t].count;
+    if (total == 0)
+        return;
+
+    if (total > log->merged_capacity)
+    {
+        EventRecord *merged = memory_realloc(MEMORY_EVENT_LOG, log->merged, total * sizeof(EventRecord));
+        if (!merged)
+        {
+            __atomic_add_fetch(&log->dropped, total, __ATOMIC_RELAXED);
+            for (int t = 0; t < log->thread_capacity; t++)
+                log->pending[t].count = 0;
+            return;
+        }
+        log->merged = merged;
+        log->merged_capacity = total;
+    }
+    size_t offset = 0;
+    for (int t = 0; t < log->thread_capacity; t++)
+    {
+        memcpy(log->merged + offset, log->pending[t].records, log->pending[t].count * sizeof(EventRecord));
+        offset += log->pending[t].count;
+        log->pending[t].count = 0;
+    }
+    qsort(log->merged, total, sizeof(EventRecord), compare_records);
+    if (!log->write_failed && fwrite(log->merged, sizeof(EventRecord), total, log->file) != total)
+    {
+        perror("Hiba az eseménynapló írásakor");
+        log->write_failed = true;
+    }
+    if (!log->write_failed)
+        log->written += total;
+}
+
+static void *writer_main(void *arg)
+{
+    EventLog *log = (EventLog *)arg;
+    pthread_mutex_lock(&log->lock);
+    for (;;)
+    {
+        while (!log->batch_ready && !log->stopping)
+            pthread_cond_wait(&log->cond, &log->lock);
+        if (!log->batch_ready)
+            break; // Leállítás, nincs több készlet
+        pthread_mutex_unlock(&log->lock);
+
+        write_batch(log);
+
+        pthread_mutex_lock(&log->lock);
+        log->batch_ready = false;
+        pthread_cond_broadcast(&log->cond);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+// Mindkét készlet bővítése a szálszámhoz (csak amikor az író tétlen)
+static bool ensure_thread_capacity(EventLog *log, int threads)
+{
+    if (threads <= log->thread_capacity)
+        return true;
+    EventBuffer *sets[2] = {log->active, log->pending};
+    for (int s = 0; s < 2; s++)
+    {
+        void *ptr = NULL;
+        if (memory_posix_memalign(MEMORY_EVENT_LOG, &ptr, 64, (size_t)threads * sizeof(EventBuffer)) != 0)
+            return false;
+        EventBuffer *buffers = (EventBuffer *)ptr;
+        memset(buffers, 0, (size_t)threads * sizeof(EventBuffer));
+        if (sets[s])
+            memcpy(buffers, sets[s], (size_t)log->thread_capacity * sizeof(EventBuffer));
+        memory_free(MEMORY_EVENT_LOG, sets[s]);
+        sets[s] = buffers;
+        if (s == 0)
+            log->active = buffers;
+        else
+            log->pending = buffers;
+    }
+    log->thread_capacity = threads;
+    return true;
+}
+
+static void free_buffers(EventLog *log)
+{
+    for (int t = 0; t < log->thread_capacity; t++)
+    {
+        if (log->active)
+            memory_free(MEMORY_EVENT_LOG, log->active[t].records);
+        if (log->pending)
+            memory_free(MEMORY_EVENT_LOG, log->pending[t].records);
+    }
+    memory_free(MEMORY_EVENT_LOG, log->active);
+    memory_free(MEMORY_EVENT_LOG, log->pending);
+    memory_free(MEMORY_EVENT_LOG, log->merged);
+}
+
+EventLog *event_log_open(const char *path, uint32_t filter)
+{
+    EventLog *log = (EventLog *)memory_calloc(MEMORY_EVENT_LOG, 1, sizeof(EventLog));
+    if (!log)
+    {
+        perror("Hiba az eseménynapló foglalásakor");
+        return NULL;
+    }
+    log->filter = filter & EVENT_FILTER_ALL;
+    if (!ensure_thread_capacity(log, omp_get_max_threads()))
+    {
+        perror("Hiba az eseménynapló puffereinek foglalásakor");
+        free_buffers(log);
+        memory_free(MEMORY_EVENT_LOG, log);
+        return NULL;
+    }
+    log->file = fopen(path, "wb");
+    if (!log->file)
+    {
+        perror("Hiba az eseménynapló megnyitásakor");
+        free_buffers(log);
+        memory_free(MEMORY_EVENT_LOG, log);
+        return NULL;
+    }
+    EventLogHeader header = {EVENT_LOG_MAGIC, EVENT_LOG_VERSION, sizeof(EventLogHeader), sizeof(EventRecord), log->filter, 0};
+    if (fwrite(&header, sizeof(header), 1, log->file) != 1)
+    {
+        perror("Hiba az eseménynapló írásakor");
+        fclose(log->file);
+        free_buffers(log);
+        memory_free(MEMORY_EVENT_LOG, log);
+        return NULL;
+    }
+
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->cond, NULL);
+    if (pthread_create(&log->writer, NULL, writer_main, log) != 0)
+    {
+        fprintf(stderr, "Hiba: az eseménynapló író szála nem indult el.\n");
+        pthread_mutex_destroy(&log->lock);
+        pthread_cond_destroy(&log->cond);
+        fclose(log->file);
+        free_buffers(log);
+        memory_free(MEMORY_EVENT_LOG, log);
+        return NULL;
+    }
+    return log;
+}
+
+void event_log_flush(EventLog *log)
+{
+    if (!log)
+        return;
+    event_log_end_step(log); // A legutóbbi event_log_end_step óta gyűjtött rekordok is kikerülnek
+    pthread_mutex_lock(&log->lock);
+    while (log->batch_ready)
+        pthread_cond_wait(&log->cond, &log->lock);
+    pthread_mutex_unlock(&log->lock);
+    fflush(log->file);
+}
+
+void event_log_close(EventLog *log)
+{
+    if (!log)
+        return;
+    event_log_flush(log);
+
+    pthread_mutex_lock(&log->lock);
+    log->stopping = true;
+    pthread_cond_broadcast(&log->cond);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->writer, NULL);
+
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->cond);
+    if (fclose(log->file) != 0)
+        perror("Hiba az eseménynapló lezárásakor");
+    free_buffers(log);
+    memory_free(MEMORY_EVENT_LOG, log);
+}
+
+void event_log_attach(EventLog *log, World *world)
+{
+    if (world)
+        world->events = log;
+}
+
+bool event_log_wants(const EventLog *log, EventKind kind)
+{
+    return log && (log->filter & (1u << kind));
+}
+
+void event_log_record(EventLog *log, EventKind kind, int step, const Entity *actor, int target_id,
+                      EntityType target_type, Coordinates position)
+{
+    if (!(log->filter & (1u << kind)))
+        return;
+    int thread = omp_get_thread_num();
+    if (thread >= log->thread_capacity)
+    {
+        __atomic_add_fetch(&log->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    EventBuffer *buffer = &log->active[thread];
+    if (buffer->count == buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : EVENT_BUFFER_INITIAL;
+        EventRecord *records = memory_realloc(MEMORY_EVENT_LOG, buffer->records, capacity * sizeof(EventRecord));
+        if (!records)
+        {
+            __atomic_add_fetch(&log->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        buffer->records = records;
+        buffer->capacity = capacity;
+    }
+    EventRecord *record = &buffer->records[buffer->count++];
+    record->step = step;
+    record->kind = (uint8_t)kind;
+    record->actor_type = (uint8_t)actor->type;
+    record->target_type = (uint8_t)target_type;
+    record->reserved = 0;
+    record->actor_id = actor->id;
+    record->target_id = target_id;
+    record->x = position.x;
+    record->y = position.y;
+}
+
+void event_log_record_deaths(EventLog *log, const World *world, int step)
+{
+    if (!event_log_wants(log, EVENT_DEATH_AGE) && !event_log_wants(log, EVENT_DEATH_STARVATION))
+        return;
+    const LifecycleBuffers *lifecycle = world->lifecycle;
+    int count = world->entity_count;
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < count; i++)
+    {
+        // Ugyanaz a feltétel, mint a lifecycle_kernel.c is_alive_scalar-ja
+        int type = lifecycle->type[i];
+        if (type <= EMPTY || type >= ENTITY_TYPE_COUNT ||
+            (lifecycle->energy[i] > 0 && lifecycle->age[i] <= lifecycle->max_age[type]))
+            continue;
+        const Entity *entity = &world->entities[i];
+        bool aged = lifecycle->age[i] > lifecycle->max_age[type];
+        event_log_record(log, aged ? EVENT_DEATH_AGE : EVENT_DEATH_STARVATION, step, entity, -1, EMPTY, entity->position);
+    }
+}
+
+void event_log_end_step(EventLog *log)
+{
+    if (!log)
+        return;
+    pthread_mutex_lock(&log->lock);
+    while (log->batch_ready)
+        pthread_cond_wait(&log->cond, &log->lock); // Az író még az előző lépéssel dolgozik
+    if (!ensure_thread_capacity(log, omp_get_max_threads()))
+        fprintf(stderr, "Hiba: az eseménynapló szálankénti puffereinek bővítése sikertelen.\n");
+    EventBuffer *full = log->active;
+    log->active = log->pending;
+    log->pending = full;
+    log->batch_ready = true;
+    pthread_cond_broadcast(&log->cond);
+    pthread_mutex_unlock(&log->lock);
+}
+
+void event_log_report(const EventLog *log, FILE *out)
+{
+    if (!log)
+        return;
+    fprintf(out, "Eseménynapló: %llu rekord kiírva, %llu eldobva%s\n", log->written,
+            __atomic_load_n(&log->dropped, __ATOMIC_RELAXED), log->write_failed ? " (írási hiba)" : "");
+}
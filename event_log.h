@@ -0,0 +1,44 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "datatypes.h"        // Szükséges a World, Entity, Coordinates típusokhoz
+#include "event_log_format.h" // EventKind, EventRecord, a fájlformátum
+
+// Bináris eseménynapló (születés, halál, ragadozás, legelés) a populációdinamika utólagos
+// vizsgálatához. A lépés közben minden szál a saját pufferébe fűz rögzített méretű rekordokat,
+// zár és atomi művelet nélkül. A lépés végén (a simulate_step soros részéből) a pufferkészlet
+// egy háttérszálhoz kerül, amely összefésüli, lépésen belül rendezi és a fájlba írja, miközben a
+// szimuláció a másik készletbe gyűjt tovább. Ha az író még az előző lépéssel dolgozik, a lépés
+// vége megvárja (legfeljebb két lépésnyi rekord van a memóriában).
+//
+// A növényréteg növényeinek születése és halála nem kerül a naplóba (ezeknek nincs azonosítója),
+// a legelésük igen (target_id = -1). A dekódoló: ecosim_event_decode (event_decoder.c).
+
+// A napló megnyitása; filter: a rögzítendő fajták bitmaszkja (1 << EventKind, lásd event_filter_parse).
+// Hiba esetén NULL.
+EventLog *event_log_open(const char *path, uint32_t filter);
+// A gyűjtött rekordok kiírása és megvárása (utána az event_log_report pontos).
+void event_log_flush(EventLog *log);
+// A maradék rekordok kiírása, az író szál leállítása és a fájl lezárása.
+void event_log_close(EventLog *log);
+// A napló hozzárendelése egy világhoz (a világ nem birtokolja).
+void event_log_attach(EventLog *log, World *world);
+
+// Igaz, ha a fajta szerepel a szűrőben.
+bool event_log_wants(const EventLog *log, EventKind kind);
+// Egy rekord a hívó szál pufferébe (párhuzamos régióból is). target_id: -1, ha nincs.
+void event_log_record(EventLog *log, EventKind kind, int step, const Entity *actor, int target_id,
+                      EntityType target_type, Coordinates position);
+// A lépés eleji életciklus-menetben (lifecycle_prepass) elhunytak rögzítése; utána kell hívni.
+void event_log_record_deaths(EventLog *log, const World *world, int step);
+// A lépés lezárása: a pufferkészlet átadása az író szálnak.
+void event_log_end_step(EventLog *log);
+
+// Összegzés: kiírt és (foglalási hiba miatt) eldobott rekordok (event_log_flush után pontos).
+void event_log_report(const EventLog *log, FILE *out);
+
+#endif // EVENT_LOG_H
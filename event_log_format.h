@@ -0,0 +1,92 @@
+#ifndef EVENT_LOG_FORMAT_H
+#define EVENT_LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Az eseménynapló (event_log.c) bináris fájlformátuma; a szimulátor és a dekódoló
+// (event_decoder.c) közös szerződése. Csak rögzített szélességű típusok, natív bájtsorrendben.
+//
+// A fájl: EventLogHeader, majd rögzített méretű (record_size bájtos) EventRecord rekordok.
+// A rekordok lépésenként kerülnek a fájlba, a lépésen belül (kind, actor_id, target_id, x, y)
+// szerint rendezve, így determinisztikus módban a napló a szálszámtól független.
+
+#define EVENT_LOG_MAGIC 0x474c5645u // "EVLG" (little endian)
+#define EVENT_LOG_VERSION 1
+
+typedef enum
+{
+    EVENT_BIRTH,            // actor: a szülő, target: az utód (azonos típus), pozíció: az utód cellája
+    EVENT_DEATH_AGE,        // actor: az elhunyt, target: -1, pozíció: az utolsó cellája
+    EVENT_DEATH_STARVATION, // Mint az EVENT_DEATH_AGE, de az energia fogyott el
+    EVENT_PREDATION,        // actor: a ragadozó, target: a zsákmány (állat), pozíció: a zsákmány cellája
+    EVENT_GRAZE,            // actor: a legelő, target: a növény (növényrétegen -1), pozíció: a növény cellája
+    EVENT_KIND_COUNT
+} EventKind;
+
+#define EVENT_FILTER_ALL ((1u << EVENT_KIND_COUNT) - 1)
+
+typedef struct
+{
+    uint32_t magic;       // EVENT_LOG_MAGIC
+    uint32_t version;     // EVENT_LOG_VERSION
+    uint32_t header_size; // sizeof(EventLogHeader), az első rekord eltolása
+    uint32_t record_size; // sizeof(EventRecord)
+    uint32_t filter;      // A rögzített eseményfajták bitmaszkja (1 << EventKind)
+    uint32_t reserved;
+} EventLogHeader;
+
+typedef struct
+{
+    int32_t step;
+    uint8_t kind;        // EventKind
+    uint8_t actor_type;  // EntityType: 1 növény, 2 növényevő, 3 ragadozó
+    uint8_t target_type; // EntityType, 0: nincs célpont
+    uint8_t reserved;
+    int32_t actor_id;
+    int32_t target_id; // -1: nincs (halál) vagy növényréteg-cella (legelés)
+    int32_t x;
+    int32_t y;
+} EventRecord;
+
+static const char *const event_kind_names[EVENT_KIND_COUNT] = {"birth", "age_death", "starvation", "predation", "graze"};
+
+// Vesszővel elválasztott eseményfajták bitmaszkká: a fenti nevek, valamint "death" (mindkét
+// halálfajta) és "all". Hamis ismeretlen névnél.
+static inline bool event_filter_parse(const char *text, uint32_t *out)
+{
+    uint32_t mask = 0;
+    while (*text)
+    {
+        size_t length = strcspn(text, ",");
+        bool known = false;
+        if (length == 3 && strncmp(text, "all", 3) == 0)
+        {
+            mask |= EVENT_FILTER_ALL;
+            known = true;
+        }
+        else if (length == 5 && strncmp(text, "death", 5) == 0)
+        {
+            mask |= (1u << EVENT_DEATH_AGE) | (1u << EVENT_DEATH_STARVATION);
+            known = true;
+        }
+        for (int kind = 0; kind < EVENT_KIND_COUNT && !known; kind++)
+        {
+            if (strlen(event_kind_names[kind]) == length && strncmp(text, event_kind_names[kind], length) == 0)
+            {
+                mask |= 1u << kind;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+        text += length;
+        if (*text == ',')
+            text++;
+    }
+    *out = mask;
+    return mask != 0;
+}
+
+#endif // EVENT_LOG_FORMAT_H
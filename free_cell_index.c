@@ -0,0 +1,185 @@
+#include <string.h>
+
+#include "free_cell_index.h"
+#include "plant_layer.h"
+
+static size_t align64(size_t bytes)
+{
+    return (bytes + 63) & ~(size_t)63;
+}
+
+size_t free_cell_index_storage_size(int width, int height, bool rows_only)
+{
+    int words_per_row = rows_only ? 0 : (width + 63) / 64;
+    return align64(sizeof(FreeCellIndex)) +
+           align64((size_t)words_per_row * height * sizeof(unsigned long long)) +
+           align64((size_t)height * sizeof(int)) +
+           align64((size_t)(height + 1) * sizeof(long long));
+}
+
+FreeCellIndex *free_cell_index_create_in(int width, int height, bool rows_only, void *storage)
+{
+    unsigned char *cursor = (unsigned char *)storage;
+    FreeCellIndex *index = (FreeCellIndex *)cursor;
+    memset(index, 0, sizeof(*index));
+    cursor += align64(sizeof(FreeCellIndex));
+
+    index->width = width;
+    index->height = height;
+    index->words_per_row = rows_only ? 0 : (width + 63) / 64;
+    index->occupied = rows_only ? NULL : (unsigned long long *)cursor;
+    cursor += align64((size_t)index->words_per_row * height * sizeof(unsigned long long));
+    index->row_free = (int *)cursor;
+    cursor += align64((size_t)height * sizeof(int));
+    index->fenwick = (long long *)cursor;
+    index->valid = false;
+    return index;
+}
+
+static void fenwick_add(FreeCellIndex *index, int row, int delta)
+{
+    for (int i = row + 1; i <= index->height; i += i & -i)
+        index->fenwick[i] += delta;
+}
+
+// Fenwick-fa lineáris idejű felépítése a row_free tömbből
+static void fenwick_build(FreeCellIndex *index)
+{
+    index->fenwick[0] = 0;
+    for (int i = 1; i <= index->height; i++)
+        index->fenwick[i] = index->row_free[i - 1];
+    for (int i = 1; i <= index->height; i++)
+    {
+        int parent = i + (i & -i);
+        if (parent <= index->height)
+            index->fenwick[parent] += index->fenwick[i];
+    }
+}
+
+void free_cell_index_rebuild(FreeCellIndex *index, const World *world)
+{
+    if (!index->occupied)
+    {
+        // Csak sorok: az entitások sora (a cellák különbözők; növényréteg ritka tárolásnál nincs)
+        for (int y = 0; y < index->height; y++)
+            index->row_free[y] = index->width;
+        for (int i = 0; i < world->entity_count; i++)
+        {
+            Coordinates pos = world->entities[i].position;
+            if (pos.x >= 0 && pos.x < index->width && pos.y >= 0 && pos.y < index->height)
+                index->row_free[pos.y]--;
+        }
+        index->free_total = 0;
+        for (int y = 0; y < index->height; y++)
+            index->free_total += index->row_free[y];
+        fenwick_build(index);
+        index->valid = true;
+        return;
+    }
+
+    size_t words = (size_t)index->words_per_row * index->height;
+    if (world->plants)
+        memcpy(index->occupied, world->plants->occupancy, words * sizeof(unsigned long long));
+    else
+        memset(index->occupied, 0, words * sizeof(unsigned long long));
+
+    for (int i = 0; i < world->entity_count; i++)
+    {
+        Coordinates pos = world->entities[i].position;
+        if (pos.x >= 0 && pos.x < index->width && pos.y >= 0 && pos.y < index->height)
+            index->occupied[(size_t)pos.y * index->words_per_row + (pos.x >> 6)] |= 1ULL << (pos.x & 63);
+    }
+
+    index->free_total = 0;
+    for (int y = 0; y < index->height; y++)
+    {
+        int occupied = 0;
+        for (int w = 0; w < index->words_per_row; w++)
+            occupied += __builtin_popcountll(index->occupied[(size_t)y * index->words_per_row + w]);
+        index->row_free[y] = index->width - occupied;
+        index->free_total += index->row_free[y];
+    }
+    fenwick_build(index);
+    index->valid = true;
+}
+
+void free_cell_index_mark_occupied(FreeCellIndex *index, int x, int y)
+{
+    if (index->occupied)
+    {
+        unsigned long long *word = &index->occupied[(size_t)y * index->words_per_row + (x >> 6)];
+        unsigned long long bit = 1ULL << (x & 63);
+        if (*word & bit)
+            return;
+        *word |= bit;
+    }
+    index->row_free[y]--;
+    index->free_total--;
+    fenwick_add(index, y, -1);
+}
+
+void free_cell_index_mark_free(FreeCellIndex *index, int x, int y)
+{
+    if (index->occupied)
+    {
+        unsigned long long *word = &index->occupied[(size_t)y * index->words_per_row + (x >> 6)];
+        unsigned long long bit = 1ULL << (x & 63);
+        if (!(*word & bit))
+            return;
+        *word &= ~bit;
+    }
+    index->row_free[y]++;
+    index->free_total++;
+    fenwick_add(index, y, 1);
+}
+
+bool free_cell_index_select_row(const FreeCellIndex *index, long long k, int *out_row, int *out_rank)
+{
+    if (k < 0 || k >= index->free_total)
+        return false;
+
+    // Sor keresése: a legkisebb y, amelyre a 0..y sorok szabad celláinak összege > k
+    int row = 0;
+    long long remaining = k;
+    int step = 1;
+    while (step * 2 <= index->height)
+        step *= 2;
+    for (; step > 0; step >>= 1)
+    {
+        if (row + step <= index->height && index->fenwick[row + step] <= remaining)
+        {
+            row += step;
+            remaining -= index->fenwick[row];
+        }
+    }
+    *out_row = row;
+    *out_rank = (int)remaining;
+    return true;
+}
+
+bool free_cell_index_select(const FreeCellIndex *index, long long k, Coordinates *out_pos)
+{
+    int row, remaining;
+    if (!index->occupied || !free_cell_index_select_row(index, k, &row, &remaining))
+        return false;
+
+    // Soron belül: a remaining. szabad bit megkeresése popcount-tal
+    const unsigned long long *words = &index->occupied[(size_t)row * index->words_per_row];
+    for (int w = 0; w < index->words_per_row; w++)
+    {
+        int bits_in_word = index->width - w * 64 < 64 ? index->width - w * 64 : 64;
+        unsigned long long valid_mask = bits_in_word == 64 ? ~0ULL : ((1ULL << bits_in_word) - 1);
+        unsigned long long free_bits = ~words[w] & valid_mask;
+        int count = __builtin_popcountll(free_bits);
+        if (remaining < count)
+        {
+            for (; remaining > 0; remaining--)
+                free_bits &= free_bits - 1; // A legalsó szabad bitek eldobása
+            out_pos->x = w * 64 + __builtin_ctzll(free_bits);
+            out_pos->y = row;
+            return true;
+        }
+        remaining -= count;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef FREE_CELL_INDEX_H
+#define FREE_CELL_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "datatypes.h" // Szükséges a World, Coordinates típusokhoz
+
+// Szabad cellák indexe: soronkénti foglaltsági bittérkép, a sorok szabad-cella számai fölött
+// Fenwick-fával. Egy egyenletes eloszlású üres cella kiválasztása rang/szelekció művelet:
+// O(log H) a sor megkeresése, majd O(W/64) popcount a soron belül. A "világ megtelt" eset
+// azonnal kiderül (a szabad cellák száma 0), nem kell kimeríteni a próbálkozási keretet.
+//
+// Az index a lépések között nem követi a rácsot (az minden lépésben újraépül); a simulate_step
+// érvényteleníti, és az első lekérdezés újraépíti az aktuális entitáslistából O(N + W*H/64) idő alatt.
+//
+// Ritka (darabolt) tárolásnál csak a soronkénti számok és a Fenwick-fa létezik (O(H) tár, O(N + H)
+// újraépítés), a cellabittérkép nem: a soron belüli keresést a darabkönyvtár végzi (lásd
+// world_chunks_select_free_cell). A kiválasztott cella így mindkét tárolásnál ugyanaz.
+struct FreeCellIndex
+{
+    int width;
+    int height;
+    int words_per_row;
+    unsigned long long *occupied; // 1 bit / cella, 1: foglalt (entitás vagy növényréteg); NULL: csak sorok
+    int *row_free;                // Soronkénti szabad cellák száma
+    long long *fenwick;           // Fenwick-fa a row_free fölött (1-től indexelve; ritka világban W*H > INT_MAX)
+    long long free_total;
+    bool valid; // Hamis, ha a rács azóta megváltozott (újraépítés szükséges)
+};
+
+// A világ arénájában elhelyezett index mérete és létrehozása (64 bájtra igazított tárolóban).
+// rows_only: cellabittérkép nélkül (ritka tárolás).
+size_t free_cell_index_storage_size(int width, int height, bool rows_only);
+FreeCellIndex *free_cell_index_create_in(int width, int height, bool rows_only, void *storage);
+
+// Újraépítés az aktuális entitáslistából és a növényrétegből.
+void free_cell_index_rebuild(FreeCellIndex *index, const World *world);
+static inline void free_cell_index_invalidate(FreeCellIndex *index)
+{
+    index->valid = false;
+}
+
+// Egy cella foglaltra/szabadra állítása (ha az állapota változik; bittérkép nélkül a hívó garantálja,
+// hogy változik).
+void free_cell_index_mark_occupied(FreeCellIndex *index, int x, int y);
+void free_cell_index_mark_free(FreeCellIndex *index, int x, int y);
+
+// A k. (0-tól számozott) szabad cella sora, és hányadik szabad cella a soron belül.
+// Hamis, ha k >= free_total.
+bool free_cell_index_select_row(const FreeCellIndex *index, long long k, int *out_row, int *out_rank);
+
+// A k. (0-tól számozott) szabad cella sorfolytonos sorrendben. Hamis, ha k >= free_total
+// (vagy ha az indexnek nincs cellabittérképe).
+bool free_cell_index_select(const FreeCellIndex *index, long long k, Coordinates *out_pos);
+
+#endif // FREE_CELL_INDEX_H
@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_histogram.h"
+
+static const char *phase_names[LATENCY_PHASE_COUNT] = {"Total", "Carnivores", "Herbivores", "Plants"};
+static const double report_percentiles[] = {50.0, 90.0, 99.0, 99.9};
+#define REPORT_PERCENTILE_COUNT ((int)(sizeof(report_percentiles) / sizeof(report_percentiles[0])))
+
+static inline int bucket_index(unsigned long long value)
+{
+    if (value < LATENCY_SUB_BUCKETS)
+        return (int)value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > LATENCY_MAX_EXPONENT)
+        return LATENCY_BUCKET_COUNT - 1;
+    int sub = (int)((value >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+    return (exponent - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// A rekeszbe eső legnagyobb érték
+static inline unsigned long long bucket_upper_bound(int index)
+{
+    if (index < LATENCY_SUB_BUCKETS)
+        return (unsigned long long)index;
+    int exponent = index / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+    int sub = index % LATENCY_SUB_BUCKETS;
+    int shift = exponent - LATENCY_SUB_BUCKET_BITS;
+    return (((unsigned long long)(LATENCY_SUB_BUCKETS + sub + 1)) << shift) - 1;
+}
+
+void latency_histogram_reset(LatencyHistogram *histogram)
+{
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void latency_histogram_record(LatencyHistogram *histogram, unsigned long long value_ns)
+{
+    histogram->counts[bucket_index(value_ns)]++;
+    if (histogram->total_count == 0 || value_ns < histogram->min_ns)
+        histogram->min_ns = value_ns;
+    if (value_ns > histogram->max_ns)
+        histogram->max_ns = value_ns;
+    histogram->total_count++;
+    histogram->sum_ns += (double)value_ns;
+}
+
+double latency_histogram_mean(const LatencyHistogram *histogram)
+{
+    return histogram->total_count ? histogram->sum_ns / histogram->total_count : 0.0;
+}
+
+unsigned long long latency_histogram_percentile(const LatencyHistogram *histogram, double percentile)
+{
+    if (histogram->total_count == 0)
+        return 0;
+    double exact_rank = percentile / 100.0 * (double)histogram->total_count;
+    unsigned long long rank = (unsigned long long)exact_rank;
+    if ((double)rank < exact_rank)
+        rank++; // Felfelé kerekítés
+    if (rank < 1)
+        rank = 1;
+    unsigned long long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++)
+    {
+        seen += histogram->counts[i];
+        if (seen >= rank)
+        {
+            unsigned long long value = bucket_upper_bound(i);
+            return value < histogram->max_ns ? value : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+LatencyRecorder *latency_recorder_create(int window_steps, bool log_each_step)
+{
+    LatencyRecorder *recorder = (LatencyRecorder *)calloc(1, sizeof(LatencyRecorder));
+    if (!recorder)
+    {
+        perror("Hiba a késleltetés-hisztogramok foglalásakor");
+        return NULL;
+    }
+    recorder->window_steps = window_steps > 0 ? window_steps : 0;
+    recorder->window_first_step = -1;
+    recorder->log_each_step = log_each_step;
+    return recorder;
+}
+
+void latency_recorder_free(LatencyRecorder *recorder)
+{
+    free(recorder);
+}
+
+// Egy hisztogram-készlet összegző sorai, milliszekundumban
+static void print_histograms(const LatencyHistogram histograms[LATENCY_PHASE_COUNT], FILE *out)
+{
+    for (int phase = 0; phase < LATENCY_PHASE_COUNT; phase++)
+    {
+        const LatencyHistogram *h = &histograms[phase];
+        fprintf(out, "  %-10s", phase_names[phase]);
+        for (int p = 0; p < REPORT_PERCENTILE_COUNT; p++)
+            fprintf(out, " p%g=%.4fms", report_percentiles[p], latency_histogram_percentile(h, report_percentiles[p]) / 1e6);
+        fprintf(out, " max=%.4fms mean=%.4fms\n", h->max_ns / 1e6, latency_histogram_mean(h) / 1e6);
+    }
+}
+
+void latency_recorder_record_step(LatencyRecorder *recorder, int current_step_number,
+                                  const double phase_seconds[LATENCY_PHASE_COUNT], int threads)
+{
+    if (recorder->window_first_step < 0)
+        recorder->window_first_step = current_step_number;
+
+    for (int phase = 0; phase < LATENCY_PHASE_COUNT; phase++)
+    {
+        double ns = phase_seconds[phase] * 1e9;
+        unsigned long long value = ns > 0.0 ? (unsigned long long)ns : 0ULL;
+        latency_histogram_record(&recorder->overall[phase], value);
+        if (recorder->window_steps)
+            latency_histogram_record(&recorder->window[phase], value);
+    }
+
+    if (recorder->log_each_step)
+    {
+        // A korábbi lépésenkénti sor (az analyze_timings.awk ezt dolgozza fel)
+        fprintf(stderr, "Step %d timings: Total: %.4fms, Carnivores: %.4fms, Herbivores: %.4fms, Plants: %.4fms | Threads: %d\n",
+                current_step_number,
+                phase_seconds[LATENCY_PHASE_TOTAL] * 1000.0,
+                phase_seconds[LATENCY_PHASE_CARNIVORE] * 1000.0,
+                phase_seconds[LATENCY_PHASE_HERBIVORE] * 1000.0,
+                phase_seconds[LATENCY_PHASE_PLANT] * 1000.0,
+                threads);
+    }
+
+    // Ablakösszegzés: hosszú futásoknál a farok-késleltetés időbeli alakulása is látszik
+    if (recorder->window_steps && recorder->window[LATENCY_PHASE_TOTAL].total_count >= (unsigned long long)recorder->window_steps)
+    {
+        fprintf(stderr, "Késleltetés, %d-%d. lépés (%d szál):\n", recorder->window_first_step, current_step_number, threads);
+        print_histograms(recorder->window, stderr);
+        for (int phase = 0; phase < LATENCY_PHASE_COUNT; phase++)
+            latency_histogram_reset(&recorder->window[phase]);
+        recorder->window_first_step = -1;
+    }
+}
+
+void latency_recorder_report(const LatencyRecorder *recorder, FILE *out)
+{
+    unsigned long long steps = recorder->overall[LATENCY_PHASE_TOTAL].total_count;
+    if (steps == 0)
+        return;
+    fprintf(out, "Lépésidő összegzés (%llu lépés):\n", steps);
+    print_histograms(recorder->overall, out);
+}
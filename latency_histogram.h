@@ -0,0 +1,63 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "datatypes.h" // LatencyRecorder előzetes deklarációja
+
+// HDR-stílusú log-lineáris hisztogram nanoszekundumos értékekre: minden kettőhatvány-tartomány
+// LATENCY_SUB_BUCKETS egyenlő részre oszlik, így a relatív hiba ~3%, a memória pedig állandó
+// (~9 KB), függetlenül a lépések számától.
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_EXPONENT 40 // 2^40 ns (~18 perc) felett az utolsó rekeszbe kerül
+#define LATENCY_BUCKET_COUNT ((LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+typedef struct
+{
+    unsigned long long counts[LATENCY_BUCKET_COUNT];
+    unsigned long long total_count;
+    unsigned long long min_ns;
+    unsigned long long max_ns;
+    double sum_ns;
+} LatencyHistogram;
+
+void latency_histogram_reset(LatencyHistogram *histogram);
+void latency_histogram_record(LatencyHistogram *histogram, unsigned long long value_ns);
+// Átlag nanoszekundumban (0, ha üres).
+double latency_histogram_mean(const LatencyHistogram *histogram);
+// A p (0..100) percentilis becsült értéke nanoszekundumban (a rekesz felső határa, legfeljebb a maximum).
+unsigned long long latency_histogram_percentile(const LatencyHistogram *histogram, double percentile);
+
+// A lépés fázisai, amelyekre külön hisztogramot vezetünk
+typedef enum
+{
+    LATENCY_PHASE_TOTAL,
+    LATENCY_PHASE_CARNIVORE,
+    LATENCY_PHASE_HERBIVORE,
+    LATENCY_PHASE_PLANT,
+    LATENCY_PHASE_COUNT
+} LatencyPhase;
+
+// Lépésenkénti időmérések gyűjtője: teljes futásra és (opcionálisan) csúszó ablakokra.
+// Egyetlen szál (a simulate_step soros része) írja, ezért nincs szükség szinkronizációra.
+struct LatencyRecorder
+{
+    LatencyHistogram overall[LATENCY_PHASE_COUNT];
+    LatencyHistogram window[LATENCY_PHASE_COUNT];
+    int window_steps;     // Ennyi lépésenként ablakösszegzés a stderr-re (0: kikapcsolva)
+    int window_first_step;
+    bool log_each_step;   // A korábbi "Step N timings: ..." sorok kiírása lépésenként
+};
+
+LatencyRecorder *latency_recorder_create(int window_steps, bool log_each_step);
+void latency_recorder_free(LatencyRecorder *recorder);
+
+// Egy lépés fázisidőinek (másodperc) rögzítése.
+void latency_recorder_record_step(LatencyRecorder *recorder, int current_step_number,
+                                  const double phase_seconds[LATENCY_PHASE_COUNT], int threads);
+// Összegzés (p50/p90/p99/p99.9/max) a teljes futásra.
+void latency_recorder_report(const LatencyRecorder *recorder, FILE *out);
+
+#endif // LATENCY_HISTOGRAM_H
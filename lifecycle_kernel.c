@@ -0,0 +1,409 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "lifecycle_kernel.h"
+#include "species.h"
+#include "memory_accounting.h"
+
+#define SIMD_WIDTH 8    // 8 x 32 bites sáv egy AVX2 regiszterben
+#define SIMD_PADDING 8  // Ráhagyás a tömbök végén a teljes vektoros betöltésekhez
+
+// Az AVX2 út a fajtábla oszlopait egy-egy regiszterből keresi ki sávonként
+// (_mm256_permutevar8x32_epi32), ezért csak legfeljebb 8 típusnál fordul be; több típusnál
+// minden tartományra a skalár út fut.
+#if (defined(__x86_64__) || defined(__i386__)) && ENTITY_TYPE_COUNT <= SIMD_WIDTH
+#include <immintrin.h>
+#define LIFECYCLE_HAVE_X86 1
+#endif
+
+static int *alloc_int_array(int count)
+{
+    void *ptr = NULL;
+    if (memory_posix_memalign(MEMORY_LIFECYCLE, &ptr, 32, (size_t)(count + SIMD_PADDING) * sizeof(int)) != 0)
+        return NULL;
+    return (int *)ptr;
+}
+
+LifecycleBuffers *lifecycle_buffers_create(int capacity)
+{
+    LifecycleBuffers *buffers = (LifecycleBuffers *)memory_calloc(MEMORY_LIFECYCLE, 1, sizeof(LifecycleBuffers));
+    if (!buffers)
+    {
+        perror("Hiba az életciklus pufferek foglalásakor");
+        return NULL;
+    }
+
+    buffers->capacity = capacity;
+    buffers->energy = alloc_int_array(capacity);
+    buffers->age = alloc_int_array(capacity);
+    buffers->type = alloc_int_array(capacity);
+    bool ok = buffers->energy && buffers->age && buffers->type;
+    for (int t = PLANT; t < ENTITY_TYPE_COUNT && ok; t++)
+    {
+        buffers->survivors[t] = alloc_int_array(capacity);
+        ok = buffers->survivors[t] != NULL;
+    }
+    if (!ok)
+    {
+        perror("Hiba az életciklus pufferek foglalásakor");
+        lifecycle_buffers_free(buffers);
+        return NULL;
+    }
+    return buffers;
+}
+
+// Egy SoA tömb mérete a külső tárolóban (ráhagyással, 64 bájtra kerekítve)
+static size_t storage_array_size(int capacity)
+{
+    size_t bytes = (size_t)(capacity + SIMD_PADDING) * sizeof(int);
+    return (bytes + 63) & ~(size_t)63;
+}
+
+size_t lifecycle_buffers_storage_size(int capacity)
+{
+    size_t header = (sizeof(LifecycleBuffers) + 63) & ~(size_t)63;
+    return header + (3 + (ENTITY_TYPE_COUNT - 1)) * storage_array_size(capacity);
+}
+
+LifecycleBuffers *lifecycle_buffers_create_in(int capacity, void *storage)
+{
+    unsigned char *cursor = (unsigned char *)storage;
+    LifecycleBuffers *buffers = (LifecycleBuffers *)cursor;
+    memset(buffers, 0, sizeof(*buffers));
+    cursor += (sizeof(LifecycleBuffers) + 63) & ~(size_t)63;
+
+    size_t array_size = storage_array_size(capacity);
+    buffers->capacity = capacity;
+    buffers->external_storage = true;
+    buffers->energy = (int *)cursor;
+    cursor += array_size;
+    buffers->age = (int *)cursor;
+    cursor += array_size;
+    buffers->type = (int *)cursor;
+    cursor += array_size;
+    for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+    {
+        buffers->survivors[t] = (int *)cursor;
+        cursor += array_size;
+    }
+    return buffers;
+}
+
+void lifecycle_buffers_free(LifecycleBuffers *buffers)
+{
+    if (!buffers)
+        return;
+    if (buffers->external_storage)
+    {
+        memory_free(MEMORY_LIFECYCLE, buffers->thread_counts); // A tömbök a külső tárolóval együtt szabadulnak fel
+        return;
+    }
+    memory_free(MEMORY_LIFECYCLE, buffers->energy);
+    memory_free(MEMORY_LIFECYCLE, buffers->age);
+    memory_free(MEMORY_LIFECYCLE, buffers->type);
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+        memory_free(MEMORY_LIFECYCLE, buffers->survivors[t]);
+    memory_free(MEMORY_LIFECYCLE, buffers->thread_counts);
+    memory_free(MEMORY_LIFECYCLE, buffers);
+}
+
+static bool ensure_thread_capacity(LifecycleBuffers *buffers, int threads)
+{
+    if (threads <= buffers->thread_capacity)
+        return true;
+    int(*counts)[ENTITY_TYPE_COUNT] = memory_realloc(MEMORY_LIFECYCLE, buffers->thread_counts, (size_t)threads * sizeof(*counts));
+    if (!counts)
+        return false;
+    buffers->thread_counts = counts;
+    buffers->thread_capacity = threads;
+    return true;
+}
+
+// Skalár referencia: egy entitás következő energiája és kora, valamint hogy túléli-e a lépést.
+// Ugyanazt számolja, mint a vektoros út; a maradék (nem 8-cal osztható) elemekre is ez fut.
+static inline bool is_alive_scalar(const int max_age[ENTITY_TYPE_COUNT], int type, int energy, int age)
+{
+    if (type <= EMPTY || type >= ENTITY_TYPE_COUNT)
+        return false;
+    return energy > 0 && age <= max_age[type];
+}
+
+static inline bool update_scalar(const int max_age[ENTITY_TYPE_COUNT], int type, int *energy, int *age)
+{
+    (*age)++;
+    if (type <= EMPTY || type >= ENTITY_TYPE_COUNT)
+        return false;
+    // Negatív változás: fogyás, amíg van energia; pozitív: növekedés max_energy-ig
+    const SpeciesInfo *species = species_info((EntityType)type);
+    if (*energy > 0 && (species->energy_change < 0 || *energy < species->max_energy))
+    {
+        *energy += species->energy_change;
+        if (species->energy_change > 0 && *energy > species->max_energy)
+            *energy = species->max_energy;
+    }
+    return is_alive_scalar(max_age, type, *energy, *age);
+}
+
+static void update_range_scalar(LifecycleBuffers *b, int begin, int end, int counts[ENTITY_TYPE_COUNT])
+{
+    for (int i = begin; i < end; i++)
+    {
+        if (update_scalar(b->max_age, b->type[i], &b->energy[i], &b->age[i]))
+            counts[b->type[i]]++;
+    }
+}
+
+static void compact_range_scalar(LifecycleBuffers *b, int begin, int end, int offsets[ENTITY_TYPE_COUNT])
+{
+    for (int i = begin; i < end; i++)
+    {
+        int type = b->type[i];
+        if (is_alive_scalar(b->max_age, type, b->energy[i], b->age[i]))
+            b->survivors[type][offsets[type]++] = i;
+    }
+}
+
+#ifdef LIFECYCLE_HAVE_X86
+// Balra tömörítő permutációk: a 8 bites maszk beállított sávjainak indexei előre rendezve.
+static int compress_lut[256][SIMD_WIDTH];
+// Az első n sávot kijelölő maszkok a _mm256_maskstore_epi32-höz (n = 0..8).
+static int prefix_mask_lut[SIMD_WIDTH + 1][SIMD_WIDTH];
+static int use_avx2 = -1; // -1: még nem ellenőriztük
+
+static void init_avx2_tables(void)
+{
+    for (int mask = 0; mask < 256; mask++)
+    {
+        int n = 0;
+        for (int lane = 0; lane < SIMD_WIDTH; lane++)
+        {
+            if (mask & (1 << lane))
+                compress_lut[mask][n++] = lane;
+        }
+        while (n < SIMD_WIDTH)
+            compress_lut[mask][n++] = 0;
+    }
+    for (int n = 0; n <= SIMD_WIDTH; n++)
+    {
+        for (int lane = 0; lane < SIMD_WIDTH; lane++)
+            prefix_mask_lut[n][lane] = lane < n ? -1 : 0;
+    }
+}
+
+// A fajtábla egy oszlopa vektorként: a sáv típusa indexeli (_mm256_permutevar8x32_epi32)
+__attribute__((target("avx2"))) static inline __m256i species_column_avx2(const int values[ENTITY_TYPE_COUNT])
+{
+    int padded[SIMD_WIDTH] = {0};
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+        padded[t] = values[t];
+    return _mm256_loadu_si256((const __m256i *)padded);
+}
+
+// Túlélési maszk: van energia, a korhatáron belül van, és ismert (nem üres) típus
+__attribute__((target("avx2"))) static inline __m256i alive_mask_avx2(__m256i max_age_table, __m256i type, __m256i energy,
+                                                                      __m256i age)
+{
+    __m256i max_age = _mm256_permutevar8x32_epi32(max_age_table, type);
+    __m256i known_type = _mm256_and_si256(_mm256_cmpgt_epi32(type, _mm256_set1_epi32(EMPTY)),
+                                          _mm256_cmpgt_epi32(_mm256_set1_epi32(ENTITY_TYPE_COUNT), type));
+    __m256i has_energy = _mm256_cmpgt_epi32(energy, _mm256_setzero_si256());
+    __m256i too_old = _mm256_cmpgt_epi32(age, max_age);
+    return _mm256_andnot_si256(too_old, _mm256_and_si256(has_energy, known_type));
+}
+
+__attribute__((target("avx2"))) static void update_range_avx2(LifecycleBuffers *b, int begin, int end, int counts[ENTITY_TYPE_COUNT])
+{
+    int change_values[ENTITY_TYPE_COUNT], max_energy_values[ENTITY_TYPE_COUNT];
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+    {
+        change_values[t] = t == EMPTY ? 0 : species_table[t].energy_change;
+        max_energy_values[t] = t == EMPTY ? 0 : species_table[t].max_energy;
+    }
+    const __m256i change_table = species_column_avx2(change_values);
+    const __m256i max_energy_table = species_column_avx2(max_energy_values);
+    const __m256i max_age_table = species_column_avx2(b->max_age);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+
+    int i = begin;
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH)
+    {
+        __m256i type = _mm256_loadu_si256((const __m256i *)&b->type[i]);
+        __m256i energy = _mm256_loadu_si256((const __m256i *)&b->energy[i]);
+        __m256i age = _mm256_loadu_si256((const __m256i *)&b->age[i]);
+
+        // Sávonkénti fajparaméterek
+        __m256i change = _mm256_permutevar8x32_epi32(change_table, type);
+        __m256i max_energy = _mm256_permutevar8x32_epi32(max_energy_table, type);
+        __m256i decays = _mm256_cmpgt_epi32(zero, change);
+        __m256i has_energy = _mm256_cmpgt_epi32(energy, zero);
+
+        // Fogyás (change < 0), ha van energia; növekedés max_energy-ig, ha 0 < energia < max
+        __m256i applies = _mm256_and_si256(has_energy, _mm256_or_si256(decays, _mm256_cmpgt_epi32(max_energy, energy)));
+        __m256i changed = _mm256_add_epi32(energy, change);
+        changed = _mm256_blendv_epi8(_mm256_min_epi32(changed, max_energy), changed, decays);
+        energy = _mm256_blendv_epi8(energy, changed, applies);
+
+        age = _mm256_add_epi32(age, one);
+
+        _mm256_storeu_si256((__m256i *)&b->energy[i], energy);
+        _mm256_storeu_si256((__m256i *)&b->age[i], age);
+
+        __m256i alive = alive_mask_avx2(max_age_table, type, energy, age);
+        for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+        {
+            __m256i is_type = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(t));
+            counts[t] += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(alive, is_type))));
+        }
+    }
+    update_range_scalar(b, i, end, counts);
+}
+
+// Vektoros stream compaction: a túlélő sávok indexeit permutációval balra tömörítjük,
+// majd maszkolt tárolással írjuk ki, hogy a szomszédos szál tartományába ne írjunk túl.
+__attribute__((target("avx2"))) static void compact_range_avx2(LifecycleBuffers *b, int begin, int end, int offsets[ENTITY_TYPE_COUNT])
+{
+    const __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i max_age_table = species_column_avx2(b->max_age);
+
+    int i = begin;
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH)
+    {
+        __m256i type = _mm256_loadu_si256((const __m256i *)&b->type[i]);
+        __m256i energy = _mm256_loadu_si256((const __m256i *)&b->energy[i]);
+        __m256i age = _mm256_loadu_si256((const __m256i *)&b->age[i]);
+        __m256i is_type[ENTITY_TYPE_COUNT];
+        for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+            is_type[t] = _mm256_cmpeq_epi32(type, _mm256_set1_epi32(t));
+
+        __m256i alive = alive_mask_avx2(max_age_table, type, energy, age);
+        __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(i), lane_index);
+
+        for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+        {
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(alive, is_type[t])));
+            if (!mask)
+                continue;
+            int n = __builtin_popcount(mask);
+            __m256i packed = _mm256_permutevar8x32_epi32(indices, _mm256_loadu_si256((const __m256i *)compress_lut[mask]));
+            _mm256_maskstore_epi32(&b->survivors[t][offsets[t]], _mm256_loadu_si256((const __m256i *)prefix_mask_lut[n]), packed);
+            offsets[t] += n;
+        }
+    }
+    compact_range_scalar(b, i, end, offsets);
+}
+
+bool lifecycle_kernel_uses_avx2(void)
+{
+    if (use_avx2 < 0)
+    {
+#pragma omp critical(LifecycleKernelInit)
+        {
+            if (use_avx2 < 0)
+            {
+                init_avx2_tables();
+                __builtin_cpu_init();
+                use_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+            }
+        }
+    }
+    return use_avx2 == 1;
+}
+#else
+bool lifecycle_kernel_uses_avx2(void)
+{
+    return false;
+}
+#endif
+
+void lifecycle_prepass(const World *world, LifecycleBuffers *buffers)
+{
+    int count = world->entity_count;
+    int total[ENTITY_TYPE_COUNT] = {0};
+    bool avx2 = lifecycle_kernel_uses_avx2();
+
+    if (count > buffers->capacity || !ensure_thread_capacity(buffers, omp_get_max_threads()))
+    {
+        fprintf(stderr, "Hiba: az életciklus pufferek túl kicsik (%d entitás).\n", count);
+        for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+            buffers->survivor_count[t] = 0;
+        return;
+    }
+
+    buffers->max_age[EMPTY] = 0;
+    for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+        buffers->max_age[t] = species_table[t].max_age;
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+        buffers->population[t] = 0;
+
+#pragma omp parallel shared(total)
+    {
+        int thread_id = omp_get_thread_num();
+        int thread_count = omp_get_num_threads();
+        // Összefüggő, 8-cal osztható határú tartományok, hogy a vektoros út sávjai ne lógjanak át
+        int blocks = (count + SIMD_WIDTH - 1) / SIMD_WIDTH;
+        int begin = (int)((long long)blocks * thread_id / thread_count) * SIMD_WIDTH;
+        int end = (int)((long long)blocks * (thread_id + 1) / thread_count) * SIMD_WIDTH;
+        if (end > count)
+            end = count;
+        if (begin > count)
+            begin = count;
+
+        // Gyűjtés a struktúra-tömbből (AoS) az összefüggő SoA tömbökbe
+        int population[ENTITY_TYPE_COUNT] = {0};
+        for (int i = begin; i < end; i++)
+        {
+            buffers->energy[i] = world->entities[i].energy;
+            buffers->age[i] = world->entities[i].age;
+            buffers->type[i] = world->entities[i].type;
+            population[buffers->type[i]]++;
+        }
+        for (int t = PLANT; t < ENTITY_TYPE_COUNT; t++)
+        {
+#pragma omp atomic update
+            buffers->population[t] += population[t];
+        }
+
+        // 1. menet: frissítés és túlélők megszámolása típusonként
+        int *counts = buffers->thread_counts[thread_id];
+        for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+            counts[t] = 0;
+#ifdef LIFECYCLE_HAVE_X86
+        if (avx2)
+            update_range_avx2(buffers, begin, end, counts);
+        else
+#endif
+            update_range_scalar(buffers, begin, end, counts);
+
+#pragma omp barrier
+#pragma omp single
+        {
+            // Exkluzív prefix összeg típusonként, a szálak sorrendjében
+            for (int t = 0; t < thread_count; t++)
+            {
+                for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+                {
+                    int c = buffers->thread_counts[t][type];
+                    buffers->thread_counts[t][type] = total[type];
+                    total[type] += c;
+                }
+            }
+        } // implicit barrier
+
+        // 2. menet: a túlélő indexek tömörítése a saját kimeneti tartományba
+        int offsets[ENTITY_TYPE_COUNT];
+        memcpy(offsets, buffers->thread_counts[thread_id], sizeof(offsets));
+#ifdef LIFECYCLE_HAVE_X86
+        if (avx2)
+            compact_range_avx2(buffers, begin, end, offsets);
+        else
+#endif
+            compact_range_scalar(buffers, begin, end, offsets);
+    }
+    (void)avx2;
+
+    for (int t = 0; t < ENTITY_TYPE_COUNT; t++)
+        buffers->survivor_count[t] = total[t];
+}
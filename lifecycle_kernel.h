@@ -0,0 +1,51 @@
+#ifndef LIFECYCLE_KERNEL_H
+#define LIFECYCLE_KERNEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "datatypes.h" // Szükséges a World, Entity, EntityType típusokhoz és az ENTITY_TYPE_COUNT-hoz
+
+// A lépés eleji "könyvelés" (öregedés, energiafogyás/növekedés, halál kora/energia miatt)
+// eredménye, struktúra-tömb (SoA) elrendezésben. Az energy/age tömbök a következő állapot
+// értékeit tartalmazzák minden entitásra; a survivors listák típusonként, növekvő index
+// szerint sorolják fel az életben maradt entitásokat.
+struct LifecycleBuffers
+{
+    int capacity;
+    int *energy; // 32 bájtra igazított tömbök az AVX2 betöltésekhez
+    int *age;
+    int *type;
+    int *survivors[ENTITY_TYPE_COUNT];     // Túlélő indexek típusonként
+    int survivor_count[ENTITY_TYPE_COUNT]; // A listák hossza
+    int population[ENTITY_TYPE_COUNT];     // Az elő-menet előtti létszám típusonként (statisztikához)
+    int max_age[ENTITY_TYPE_COUNT];        // Korhatár típusonként
+
+    int thread_capacity;
+    int (*thread_counts)[ENTITY_TYPE_COUNT]; // Szálankénti részösszegek a tömörítéshez
+
+    bool external_storage; // A struktúra és a tömbök egy külső (aréna) memóriában vannak
+};
+
+LifecycleBuffers *lifecycle_buffers_create(int capacity);
+// A pufferek elhelyezése egy előre lefoglalt, 64 bájtra igazított memóriaterületen (pl. a világ arénájában).
+// A terület mérete legalább lifecycle_buffers_storage_size(capacity) bájt.
+size_t lifecycle_buffers_storage_size(int capacity);
+LifecycleBuffers *lifecycle_buffers_create_in(int capacity, void *storage);
+void lifecycle_buffers_free(LifecycleBuffers *buffers);
+
+// Vektorizált elő-menet a world->entities tömbön: kitölti a buffers energy/age tömbjeit és a túlélő-listákat.
+// AVX2-t használ, ha a processzor támogatja, egyébként skalár úton fut.
+void lifecycle_prepass(const World *world, LifecycleBuffers *buffers);
+
+// Az elő-menet eredményének alkalmazása egy entitás következő állapotára.
+static inline void lifecycle_apply(const LifecycleBuffers *buffers, int index, Entity *next_state)
+{
+    next_state->energy = buffers->energy[index];
+    next_state->age = buffers->age[index];
+}
+
+// Igaz, ha a futtatási környezetben az AVX2 út aktív (tájékoztató jellegű).
+bool lifecycle_kernel_uses_avx2(void);
+
+#endif // LIFECYCLE_KERNEL_H
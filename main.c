@@ -5,12 +5,36 @@
 #include <ncurses.h>
 #include <string.h>
 #include <locale.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/resource.h>
 
 #include "simulation_constants.h"
 #include "datatypes.h"
 #include "world_utils.h" // create_world, initialize_world, free_world, is_valid_pos
 #include "entity_actions.h"
 #include "simulation_utils.h"
+#include "deterministic_step.h"
+#include "lifecycle_kernel.h"
+#include "plant_layer.h"
+#include "population_stats.h"
+#include "metrics_exporter.h"
+#include "latency_histogram.h"
+#include "world_arena.h"
+#include "free_cell_index.h"
+#include "world_generator.h"
+#include "species.h"
+#include "task_graph.h"
+#include "topology.h"
+#include "sync_telemetry.h"
+#include "memory_accounting.h"
+#include "shm_publisher.h"
+#include "event_log.h"
+#include "ecosim.h"
+#include "ecosim_fork.h"
+#include "phase_tuner.h"
+#include "world_chunks.h"
 
 #define RANDOM_SEED 42
 
@@ -324,6 +348,21 @@ void draw_simulation_state(World *world, int step_number, int total_steps, WINDO
     werase(world_display_window);
     box(world_display_window, 0, 0); // keret, 0, 0 a karakterek
 
+    // Növényréteg esetén a növények a rétegből kerülnek kirajzolásra (az állatok ezt felülrajzolhatják)
+    if (world->plants)
+    {
+        wattron(world_display_window, COLOR_PAIR(COLOR_PAIR_PLANT));
+        for (int y = 0; y < world->height; ++y)
+        {
+            for (int x = 0; x < world->width; ++x)
+            {
+                if (plant_layer_occupied(world->plants, x, y))
+                    mvwaddch(world_display_window, y + 1, x + 1, 'P');
+            }
+        }
+        wattroff(world_display_window, COLOR_PAIR(COLOR_PAIR_PLANT));
+    }
+
     // Entitások kirajzolása a world->grid alapján
     for (int y = 0; y < world->height; ++y)
     {
@@ -387,367 +426,639 @@ void draw_simulation_state(World *world, int step_number, int total_steps, WINDO
     wnoutrefresh(world_display_window); // Előkészíti a világ ablakának frissítését.
 }
 
-void _commit_entity_to_next_state(World *world, Entity entity_data)
+void run_simulation(World *world, int simulation_steps_to_run, long step_delay_ms)
 {
-    // Ellenőrzés, hogy van-e hely a next_entities tömbben
-    if (world->next_entity_count >= MAX_TOTAL_ENTITIES)
-    {
-        // fprintf(stderr, "FIGYELEM: next_entities tömb megtelt (%d/%d). Entitás (ID: %d) nem lett hozzáadva.\\n",
-        //         world->next_entity_count, MAX_TOTAL_ENTITIES, entity_data.id);
-        return; // Nincs több hely
-    }
-
-    int next_idx;
-#pragma omp atomic capture // atomikusan növeljük a next_entity_countot és elmentjük az eredeti értéket next_idx-be
-    next_idx = world->next_entity_count++;
+    // A timeout() beállítja a getch() viselkedését. Pozitív érték esetén
+    // a getch() ennyi milliszekundumig vár inputra, majd ERR-t ad vissza, ha nincs.
+    // Ez teszi lehetővé a nem blokkoló inputkezelést a szimulációs ciklusban.
+    timeout((int)step_delay_ms);
 
-    if (next_idx >= MAX_TOTAL_ENTITIES)
+    // Világ megjelenítésére szolgáló dedikált ncurses ablak létrehozása.
+    // Az információs sávnak 1 sort hagyunk fent (stdscr tetején), így az ablak y pozíciója 1.
+    // A keret miatt (+2) szélesség és magasság szükséges.
+    WINDOW *world_win = newwin(world->height + 2, world->width + 2, 1, (COLS - (world->width + 2)) / 2);
+    if (!world_win)
     {
-        // fprintf(stderr, "HIBA: next_entities kapacitás (%d) túlcsordult commit közben (idx: %d), ID: %d! Entitás elveszett.\\n",
-        //         MAX_TOTAL_ENTITIES, next_idx, entity_data.id);
-#pragma omp atomic update
-        world->next_entity_count--;
+        cleanup_display();
+        fprintf(stderr, "Hiba: Nem sikerült létrehozni az ncurses ablakot a szimulációhoz.\n");
         return;
     }
 
-    world->next_entities[next_idx] = entity_data;
-
-    if (is_valid_pos(world, entity_data.position.x, entity_data.position.y))
+    for (int step = 0; step < simulation_steps_to_run; step++)
     {
-#pragma omp critical
+        simulate_step(world, step);
+        draw_simulation_state(world, step, simulation_steps_to_run, world_win); // Ablak átadása
+
+        doupdate(); // Fizikai képernyő frissítése az összes előkészített változással (stdscr és world_win).
+
+        int ch = getch(); // Nem blokkoló olvasás a timeout miatt.
+        if (ch == 'q' || ch == 'Q')
         {
-            if (world->next_grid[entity_data.position.y][entity_data.position.x].entity == NULL)
-            {
-                world->next_grid[entity_data.position.y][entity_data.position.x].entity = &world->next_entities[next_idx];
-            }
+            break; // Kilépés a szimulációs ciklusból.
+        }
+        // Manuális entitás spawnolás billentyűleütésre.
+        else if (ch == 'h' || ch == 'H') // Herbivore spawn
+        {
+            spawn_entity(world, HERBIVORE, NULL, step);
+        }
+        else if (ch == 'c' || ch == 'C') // Carnivore spawn
+        {
+            spawn_entity(world, CARNIVORE, NULL, step);
+        }
+        else if (ch == 'p' || ch == 'P') // Növény spawnolása
+        {
+            spawn_entity(world, PLANT, NULL, step);
         }
     }
+
+    delwin(world_win); // A dedikált világ ablak törlése.
+    timeout(-1);       // Visszaállítjuk a getch() alapértelmezett blokkoló viselkedését a menühöz.
+    clear();           // Teljes képernyő törlése a szimuláció után.
+    refresh();         // A törölt képernyő tényleges frissítése.
 }
 
-void simulate_step(World *world, int current_step_number)
-{
-    if (!world)
-        return;
+#define MAX_BRANCHES 8 // --branch kapcsolók legfeljebb
 
-    double step_start_time, step_end_time;
-    double carnivore_start_time, carnivore_end_time;
-    double herbivore_start_time, herbivore_end_time;
-    double plant_start_time, plant_end_time;
+// Parancssori kapcsolók a menü nélküli (headless) futtatáshoz
+typedef struct
+{
+    bool headless;          // --headless: ncurses nélküli futás, a lépések után kilép
+    bool deterministic;     // --deterministic: szálszámtól független eredmény
+    bool task_graph;        // --task-graph: a fázisok sávos feladatokként, függőségek mentén átlapolódnak
+    bool print_hash;        // --hash: a végállapot lenyomatának kiírása a stdout-ra
+    const char *bench_name; // --bench-json NAME: egysoros JSON mérési eredmény a stdout-ra (make bench)
+    bool plant_layer;       // --plant-layer: a növények sűrű cellás rétegben élnek
+    bool print_stats;       // --stats: lépésenkénti populációs statisztika, a végén összegzés a stdout-ra
+    const char *metrics_socket; // --metrics-socket PATH: Prometheus metrikák Unix socketen
+    int metrics_port;           // --metrics-port N: Prometheus metrikák a 127.0.0.1:N címen (0: kikapcsolva)
+    const char *shm_name;       // --shm NAME: a világállapot publikálása a /NAME osztott memória szegmensbe
+    int shm_interval;           // --shm-interval N: N lépésenként publikál (alapértelmezés: 1)
+    const char *event_log_path; // --event-log FILE: bináris eseménynapló (ecosim_event_decode alakítja CSV-vé)
+    uint32_t event_filter;      // --event-filter LIST: a naplózott eseményfajták (alapértelmezés: mind)
+    bool step_log;              // --step-log: lépésenkénti "Step N timings" sor az stderr-re
+    const char *sync_log_path;  // --sync-log FILE: lépésenkénti, szálankénti szinkronizációs CSV (telemetriás fordítás)
+    int latency_window;         // --latency-window N: N lépésenként percentilis-összegzés (0: csak a végén)
+    bool huge_pages;            // --huge-pages: a világ arénája nagy lapokon
+    bool bulk_init;             // --bulk-init: párhuzamos, csempés kezdeti benépesítés
+    bool toroidal;              // --torus: a világ szélei körbefutnak
+    bool auto_threads;          // --auto-threads: fázisonként soros vagy kevesebb szálas futás, ha gyorsabb
+    bool chunked;               // --chunked: ritka (darabolt) rácstárolás nagy, nagyrészt üres világokhoz
+    size_t memory_budget;       // --memory-budget SIZE: kemény memóriakeret bájtban (0: nincs)
+    bool memory_report;         // --memory-report: memóriaösszegzés alrendszerenként az stderr-re
+    int initial_counts[ENTITY_TYPE_COUNT];           // --entities P,H,C: kezdeti létszámok
+    int population_caps[ENTITY_TYPE_COUNT];          // --caps P,H,C: létszámplafonok (0: a fajtábláé)
+    const char *density_paths[ENTITY_TYPE_COUNT];    // --density-map [típus=]FILE: PGM sűrűségtérkép
+    int fork_at;                                     // --fork-at N: az ágak a N. lépés előtt válnak le (-1: nincs)
+    int branch_extra[MAX_BRANCHES][ENTITY_TYPE_COUNT]; // --branch P,H,C: az ágban pluszban spawnolt egyedek
+    int branch_count;
+    unsigned long long seed; // --seed N
+    int steps;              // --steps N
+    int width;              // --size WxH
+    int height;
+} CommandLineOptions;
+
+static void print_usage(const char *program_name)
+{
+    fprintf(stderr, "Használat: %s [--headless] [--steps N] [--size WxH] [--seed N] [--deterministic] [--task-graph] [--plant-layer] [--stats] [--hash] [--metrics-socket PATH | --metrics-port N] [--shm NAME] [--shm-interval N] [--event-log FILE] [--event-filter birth,death,predation,graze] [--step-log] [--sync-log FILE] [--latency-window N] [--huge-pages] [--torus] [--auto-threads] [--chunked] [--memory-budget SIZE[K|M|G]] [--memory-report] [--entities P,H,C] [--caps P,H,C] [--bulk-init] [--density-map [plants=|herbivores=|carnivores=]FILE] [--bench-json NAME] [--fork-at N] [--branch P,H,C]...\n", program_name);
+}
 
-    step_start_time = omp_get_wtime();
+// Bájtméret K, M vagy G (1024-es) utótaggal; hamis hibás vagy túl nagy értéknél.
+static bool parse_byte_size(const char *text, size_t *out)
+{
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || errno != 0 || text[0] == '-')
+        return false;
+    int shift = 0;
+    switch (*end)
+    {
+    case 'K':
+    case 'k':
+        shift = 10;
+        break;
+    case 'M':
+    case 'm':
+        shift = 20;
+        break;
+    case 'G':
+    case 'g':
+        shift = 30;
+        break;
+    case '\0':
+        break;
+    default:
+        return false;
+    }
+    if (shift && end[1] != '\0')
+        return false;
+    if (value > ((unsigned long long)SIZE_MAX >> shift))
+        return false;
+    *out = (size_t)(value << shift);
+    return true;
+}
 
-    // Következő állapot előkészítése:
-    // - A next_entity_count nullázása.
-    // - A next_grid celláinak kiürítése
-    world->next_entity_count = 0;
-    for (int i = 0; i < world->height; i++)
+// Feldolgozza a parancssori kapcsolókat. Hamisat ad vissza ismeretlen vagy hibás kapcsoló esetén.
+static bool parse_command_line(int argc, char *argv[], CommandLineOptions *options)
+{
+    options->headless = false;
+    options->deterministic = false;
+    options->task_graph = false;
+    options->print_hash = false;
+    options->bench_name = NULL;
+    options->plant_layer = false;
+    options->print_stats = false;
+    options->metrics_socket = NULL;
+    options->metrics_port = 0;
+    options->shm_name = NULL;
+    options->shm_interval = 1;
+    options->event_log_path = NULL;
+    options->event_filter = EVENT_FILTER_ALL;
+    options->step_log = false;
+    options->sync_log_path = NULL;
+    options->latency_window = 0;
+    options->huge_pages = false;
+    options->bulk_init = false;
+    options->toroidal = false;
+    options->auto_threads = false;
+    options->chunked = false;
+    options->memory_budget = 0;
+    options->memory_report = false;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
     {
-        for (int j = 0; j < world->width; j++)
-        {
-            world->next_grid[i][j].entity = NULL;
-        }
+        options->initial_counts[type] = 0;
+        options->population_caps[type] = 0;
+        options->density_paths[type] = NULL;
     }
-    // int estimated_min_capacity = world->entity_count + (world->entity_count / 2) + 100;
-    // if (estimated_min_capacity < INITIAL_ENTITY_CAPACITY)
-    //     estimated_min_capacity = INITIAL_ENTITY_CAPACITY;
-    // _ensure_next_entity_capacity(world, estimated_min_capacity); // Ezt a hívást eltávolítjuk
-
-    // 1. RAGADOZÓK FELDOLGOZÁSA
-    // Minden ragadozó entitás feldolgozása párhuzamosan.
-    carnivore_start_time = omp_get_wtime();
-#pragma omp parallel for shared(world, current_step_number) schedule(dynamic)
-    for (int i = 0; i < world->entity_count; i++)
+    options->initial_counts[PLANT] = INITIAL_PLANTS;
+    options->initial_counts[HERBIVORE] = INITIAL_HERBIVORES;
+    options->initial_counts[CARNIVORE] = INITIAL_CARNIVORES;
+    options->fork_at = -1;
+    options->branch_count = 0;
+    options->seed = RANDOM_SEED;
+    options->steps = simulation_steps_values[STEPS_MEDIUM];
+    options->width = world_size_values[SIZE_MEDIUM].x;
+    options->height = world_size_values[SIZE_MEDIUM].y;
+
+    for (int i = 1; i < argc; i++)
     {
-        if (world->entities[i].type != CARNIVORE)
+        if (strcmp(argv[i], "--headless") == 0)
         {
-            continue;
+            options->headless = true;
         }
-
-        Entity current_entity_original_state = world->entities[i];
-        Entity next_entity_prototype = current_entity_original_state;
-
-        next_entity_prototype.age++;
-        if (next_entity_prototype.energy > 0)
-            next_entity_prototype.energy -= CARNIVORE_ENERGY_DECAY;
-
-        if (next_entity_prototype.energy <= 0 || next_entity_prototype.age > CARNIVORE_MAX_AGE)
+        else if (strcmp(argv[i], "--deterministic") == 0)
         {
-            continue; // Entitás elpusztul
+            options->deterministic = true;
         }
-
-        process_carnivore_actions_parallel(world, current_step_number, &world->entities[i], &next_entity_prototype);
-
-        if (next_entity_prototype.energy > 0)
+        else if (strcmp(argv[i], "--task-graph") == 0)
         {
-            _commit_entity_to_next_state(world, next_entity_prototype);
+            options->task_graph = true;
         }
-    }
-    carnivore_end_time = omp_get_wtime();
-
-    // === 2. NÖVÉNYEVŐK FELDOLGOZÁSA ===
-    // Minden növényevő entitás feldolgozása párhuzamosan.
-    herbivore_start_time = omp_get_wtime();
-#pragma omp parallel for shared(world, current_step_number) schedule(dynamic)
-    for (int i = 0; i < world->entity_count; i++)
-    {
-        if (world->entities[i].type != HERBIVORE)
+        else if (strcmp(argv[i], "--hash") == 0)
         {
-            continue;
+            options->print_hash = true;
         }
-
-        int initial_shared_energy;
-#pragma omp atomic read
-        initial_shared_energy = world->entities[i].energy;
-
-        if (initial_shared_energy == EATEN_ENERGY_MARKER) // Lehet, hogy egy ragadozó megette
+        else if (strcmp(argv[i], "--plant-layer") == 0)
         {
-            continue;
+            options->plant_layer = true;
         }
-
-        Entity current_entity_original_state = world->entities[i];
-        Entity next_entity_prototype = current_entity_original_state;
-
-        next_entity_prototype.age++;
-        if (next_entity_prototype.energy > 0)
-            next_entity_prototype.energy -= HERBIVORE_ENERGY_DECAY;
-
-        if (next_entity_prototype.energy <= 0 || next_entity_prototype.age > HERBIVORE_MAX_AGE)
+        else if (strcmp(argv[i], "--stats") == 0)
         {
-            continue; // Entitás elpusztul
+            options->print_stats = true;
         }
-
-        process_herbivore_actions_parallel(world, current_step_number, &world->entities[i], &next_entity_prototype);
-
-        if (next_entity_prototype.energy > 0)
+        else if (strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc)
         {
-            _commit_entity_to_next_state(world, next_entity_prototype);
+            options->metrics_socket = argv[++i];
         }
-    }
-    herbivore_end_time = omp_get_wtime();
-
-    // === 3. NÖVÉNYEK FELDOLGOZÁSA ===
-    // Minden növény entitás feldolgozása párhuzamosan.
-    plant_start_time = omp_get_wtime();
-#pragma omp parallel for shared(world, current_step_number) schedule(dynamic)
-    for (int i = 0; i < world->entity_count; i++)
-    {
-        if (world->entities[i].type != PLANT)
+        else if (strcmp(argv[i], "--huge-pages") == 0)
         {
-            continue;
+            options->huge_pages = true;
         }
-
-        int initial_shared_energy;
-#pragma omp atomic read
-        initial_shared_energy = world->entities[i].energy;
-
-        if (initial_shared_energy == EATEN_ENERGY_MARKER) // Lehet, hogy egy növényevő megette
+        else if (strcmp(argv[i], "--torus") == 0)
         {
-            continue;
+            options->toroidal = true;
         }
-
-        Entity current_entity_original_state = world->entities[i]; // Növényeknél ezt használjuk a process_plant_actions_parallel-ben
-        Entity next_entity_prototype = current_entity_original_state;
-
-        next_entity_prototype.age++;
-        if (next_entity_prototype.energy > 0 && next_entity_prototype.energy < PLANT_MAX_ENERGY)
+        else if (strcmp(argv[i], "--auto-threads") == 0)
         {
-            next_entity_prototype.energy += PLANT_GROWTH_RATE;
-            if (next_entity_prototype.energy > PLANT_MAX_ENERGY)
-                next_entity_prototype.energy = PLANT_MAX_ENERGY;
+            options->auto_threads = true;
         }
-
-        if (next_entity_prototype.energy <= 0 || next_entity_prototype.age > PLANT_MAX_AGE)
+        else if (strcmp(argv[i], "--chunked") == 0)
         {
-            continue; // Entitás elpusztul
+            options->chunked = true;
         }
-
-        process_plant_actions_parallel(world, current_step_number, &current_entity_original_state, &next_entity_prototype);
-
-        // Növényeknél a 'final_shared_energy_at_commit_time' ellenőrzése nem szükséges itt,
-        // mivel más entitás (pl. másik növény) nem "eszi meg" őket a saját feldolgozási fázisukban.
-        // Az EATEN_ENERGY_MARKER-t rájuk a növényevők állítják be a *növényevők* feldolgozási fázisában.
-        // A fenti `initial_shared_energy == EATEN_ENERGY_MARKER` ellenőrzés kezeli azt az esetet,
-        // ha egy növényevő már megette ezt a növényt ebben a `simulate_step`-ben.
-
-        if (next_entity_prototype.energy > 0)
+        else if (strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc)
+        {
+            if (!parse_byte_size(argv[++i], &options->memory_budget))
+            {
+                fprintf(stderr, "Hibás memóriakeret: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--memory-report") == 0)
+        {
+            options->memory_report = true;
+        }
+        else if (strcmp(argv[i], "--bench-json") == 0 && i + 1 < argc)
+        {
+            options->bench_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bulk-init") == 0)
+        {
+            options->bulk_init = true;
+        }
+        else if (strcmp(argv[i], "--entities") == 0 && i + 1 < argc)
         {
-            _commit_entity_to_next_state(world, next_entity_prototype);
+            int *counts = options->initial_counts;
+            if (sscanf(argv[++i], "%d,%d,%d", &counts[PLANT], &counts[HERBIVORE], &counts[CARNIVORE]) != 3 ||
+                counts[PLANT] < 0 || counts[HERBIVORE] < 0 || counts[CARNIVORE] < 0)
+                return false;
+        }
+        else if (strcmp(argv[i], "--caps") == 0 && i + 1 < argc)
+        {
+            int *caps = options->population_caps;
+            if (sscanf(argv[++i], "%d,%d,%d", &caps[PLANT], &caps[HERBIVORE], &caps[CARNIVORE]) != 3 ||
+                caps[PLANT] <= 0 || caps[HERBIVORE] <= 0 || caps[CARNIVORE] <= 0)
+                return false;
+        }
+        else if (strcmp(argv[i], "--fork-at") == 0 && i + 1 < argc)
+        {
+            options->fork_at = atoi(argv[++i]);
+            if (options->fork_at < 0)
+                return false;
+        }
+        else if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc)
+        {
+            if (options->branch_count == MAX_BRANCHES)
+            {
+                fprintf(stderr, "Legfeljebb %d ág adható meg.\n", MAX_BRANCHES);
+                return false;
+            }
+            int *extra = options->branch_extra[options->branch_count++];
+            extra[EMPTY] = 0;
+            if (sscanf(argv[++i], "%d,%d,%d", &extra[PLANT], &extra[HERBIVORE], &extra[CARNIVORE]) != 3 ||
+                extra[PLANT] < 0 || extra[HERBIVORE] < 0 || extra[CARNIVORE] < 0)
+                return false;
+        }
+        else if (strcmp(argv[i], "--density-map") == 0 && i + 1 < argc)
+        {
+            // "plants=FILE" stb. egy típusra, előtag nélkül mindháromra; a térkép a tömeges generálást kéri
+            static const char *prefixes[ENTITY_TYPE_COUNT] = {NULL, "plants=", "herbivores=", "carnivores="};
+            const char *arg = argv[++i];
+            bool typed = false;
+            for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+            {
+                if (!prefixes[type])
+                    continue;
+                size_t length = strlen(prefixes[type]);
+                if (strncmp(arg, prefixes[type], length) == 0)
+                {
+                    options->density_paths[type] = arg + length;
+                    typed = true;
+                }
+            }
+            for (int type = PLANT; type < ENTITY_TYPE_COUNT && !typed; type++)
+            {
+                if (prefixes[type])
+                    options->density_paths[type] = arg;
+            }
+            options->bulk_init = true;
+        }
+        else if (strcmp(argv[i], "--step-log") == 0)
+        {
+            options->step_log = true;
+        }
+        else if (strcmp(argv[i], "--sync-log") == 0 && i + 1 < argc)
+        {
+            options->sync_log_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--latency-window") == 0 && i + 1 < argc)
+        {
+            options->latency_window = atoi(argv[++i]);
+            if (options->latency_window < 0)
+                return false;
+        }
+        else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc)
+        {
+            options->shm_name = argv[++i];
+        }
+        else if (strcmp(argv[i], "--shm-interval") == 0 && i + 1 < argc)
+        {
+            options->shm_interval = atoi(argv[++i]);
+            if (options->shm_interval <= 0)
+            {
+                fprintf(stderr, "Hibás publikálási köz: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--event-log") == 0 && i + 1 < argc)
+        {
+            options->event_log_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--event-filter") == 0 && i + 1 < argc)
+        {
+            if (!event_filter_parse(argv[++i], &options->event_filter))
+            {
+                fprintf(stderr, "Hibás eseményszűrő: %s (birth, age_death, starvation, death, predation, graze, all)\n", argv[i]);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc)
+        {
+            options->metrics_port = atoi(argv[++i]);
+            if (options->metrics_port <= 0 || options->metrics_port > 65535)
+                return false;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+        {
+            options->steps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options->width, &options->height) != 2 || options->width <= 0 || options->height <= 0)
+                return false;
+        }
+        else
+        {
+            return false;
         }
     }
-    plant_end_time = omp_get_wtime();
-
-    // Állapotváltás (double buffering swap):
-    // A `grid` és `next_grid` (cellamátrixok), valamint az `entities` és `next_entities`
-    // (entitáslisták) pointereit megcseréljük. Így a `next_` állapotok válnak
-    // az aktuális állapottá a következő lépéshez, és a korábbi aktuális állapotok
-    // újra felhasználhatók lesznek a következő `next_` állapotok tárolására.
-    // Ez hatékony, mert nem igényel nagyméretű adatmozgatást, csak pointercseréket.
-    Cell **temp_grid_ptr = world->grid;
-    world->grid = world->next_grid;
-    world->next_grid = temp_grid_ptr;
-
-    Entity *temp_entities_ptr = world->entities;
-    world->entities = world->next_entities;
-    world->next_entities = temp_entities_ptr;
-
-    world->entity_count = world->next_entity_count;
-
-    int temp_capacity = world->entity_capacity;
-    world->entity_capacity = world->next_entity_capacity;
-    world->next_entity_capacity = temp_capacity;
-
-    step_end_time = omp_get_wtime();
-
-    // Időmérési eredmények kiírása az stderr-re
-    fprintf(stderr, "Step %d timings: Total: %.4fms, Carnivores: %.4fms, Herbivores: %.4fms, Plants: %.4fms | Threads: %d\n",
-            current_step_number,
-            (step_end_time - step_start_time) * 1000.0,
-            (carnivore_end_time - carnivore_start_time) * 1000.0,
-            (herbivore_end_time - herbivore_start_time) * 1000.0,
-            (plant_end_time - plant_start_time) * 1000.0,
-            omp_get_max_threads()); // Hozzáadva a szálak száma
+    // Ágak --fork-at nélkül a kezdőállapotból indulnak; az elágazásnak a futáson belül kell lennie
+    if (options->branch_count > 0 && options->fork_at < 0)
+        options->fork_at = 0;
+    if (options->branch_count > 0 && options->fork_at >= options->steps)
+    {
+        fprintf(stderr, "Az elágazás lépése (%d) a futás hosszán (%d) kívül esik.\n", options->fork_at, options->steps);
+        return false;
+    }
+    return options->steps >= 0;
 }
 
-// Segédfüggvények a manuális spawnoláshoz
-static bool find_random_empty_cell_for_spawn(World *world, Coordinates *out_pos)
+// Egy "mi lett volna, ha" ág terve: plusz egyedek az elágazáskor, majd a futás hátralévő lépései
+typedef struct
 {
-    int attempts = 0;
-    const int max_attempts = world->width * world->height;
-    do
-    {
-        int r_x = rand() % world->width;
-        int r_y = rand() % world->height;
-        if (world->grid[r_y][r_x].entity == NULL)
-        {
-            out_pos->x = r_x;
-            out_pos->y = r_y;
-            return true;
-        }
-        attempts++;
-    } while (attempts < max_attempts);
-    return false; // Nem talált üres cellát
+    const int *extra;
+    int steps;
+} BranchPlan;
+
+// Az ág törzse a gyermekfolyamatban; a payload a ténylegesen elhelyezett plusz egyedek száma típusonként
+static bool run_branch_plan(EcosimEngine *engine, EcosimBranchResult *result, void *user_data)
+{
+    const BranchPlan *plan = (const BranchPlan *)user_data;
+    int placed[ENTITY_TYPE_COUNT] = {0};
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        placed[type] = ecosim_spawn(engine, (EntityType)type, plan->extra[type]);
+    memcpy(result->payload, placed, sizeof(placed));
+    result->payload_size = sizeof(placed);
+    ecosim_step(engine, plan->steps);
+    return true;
 }
 
-static void spawn_entity_manually(World *world, EntityType type, int current_step)
+// Menü és megjelenítés nélküli futtatás (benchmarkokhoz, regressziós ellenőrzéshez).
+static int run_headless(const CommandLineOptions *options, MetricsExporter *metrics, LatencyRecorder *latency,
+                        ShmPublisher *publisher, EventLog *events)
 {
-    if (!world || world->entity_count >= world->entity_capacity)
+    // A menü nélküli futás a libecosim motorját használja, ugyanúgy, mint egy beágyazó
+    double startup_begin = omp_get_wtime();
+    EcosimConfig config;
+    ecosim_config_default(&config);
+    config.width = options->width;
+    config.height = options->height;
+    config.seed = options->seed;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
     {
-        // Opcionálisan logolás: Nincs hely a globális tömbben
-        return;
+        config.initial_counts[type] = options->initial_counts[type];
+        config.population_caps[type] = options->population_caps[type];
     }
-
-    int max_type_specific_entities = 0;
-    int initial_energy = 0;
-    int sight_range = 0;
-    bool use_visual_spawn_highlight = false;
-
-    switch (type)
+    config.deterministic = options->deterministic;
+    config.task_graph = options->task_graph;
+    config.plant_layer = options->plant_layer;
+    config.stats = options->print_stats;
+    config.bulk_init = options->bulk_init;
+    config.huge_pages = options->huge_pages;
+    config.toroidal = options->toroidal;
+    config.auto_threads = options->auto_threads;
+    config.chunked = options->chunked;
+    config.memory_budget = options->memory_budget;
+
+    // Sűrűségtérképek; ugyanaz a fájl több típushoz: egyszer töltjük be
+    DensityMap *maps[ENTITY_TYPE_COUNT] = {NULL};
+    bool maps_ok = true;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT && options->bulk_init; type++)
     {
-    case PLANT:
-        max_type_specific_entities = MAX_PLANTS;
-        initial_energy = PLANT_MAX_ENERGY / 2;
-        sight_range = 0;
-        use_visual_spawn_highlight = false;
-        break;
-    case HERBIVORE:
-        max_type_specific_entities = MAX_HERBIVORES;
-        initial_energy = HERBIVORE_INITIAL_ENERGY;
-        sight_range = HERBIVORE_SIGHT_RANGE;
-        use_visual_spawn_highlight = true;
-        break;
-    case CARNIVORE:
-        max_type_specific_entities = MAX_CARNIVORES;
-        initial_energy = CARNIVORE_INITIAL_ENERGY;
-        sight_range = CARNIVORE_SIGHT_RANGE;
-        use_visual_spawn_highlight = true;
-        break;
-    default:
-        // Ismeretlen típus, logolhatnánk
-        return;
+        if (!options->density_paths[type])
+            continue;
+        for (int other = PLANT; other < type && !maps[type]; other++)
+            if (options->density_paths[other] && strcmp(options->density_paths[other], options->density_paths[type]) == 0)
+                maps[type] = maps[other];
+        if (!maps[type] && !(maps[type] = density_map_load_pgm(options->density_paths[type])))
+            maps_ok = false;
+        config.density[type] = maps[type];
     }
-
-    if (count_entities_by_type(world, type) >= max_type_specific_entities)
+    EcosimEngine *engine = maps_ok ? ecosim_create(&config) : NULL;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
     {
-        // Opcionálisan logolás: Elérte a típus-specifikus maximumot
-        return;
+        bool shared = false;
+        for (int other = PLANT; other < type; other++)
+            shared = shared || maps[other] == maps[type];
+        if (!shared)
+            density_map_free(maps[type]);
     }
+    if (!engine)
+        return 1;
 
-    Coordinates spawn_pos;
-    if (find_random_empty_cell_for_spawn(world, &spawn_pos))
+    World *world = ecosim_world(engine);
+    if (options->huge_pages)
     {
-        Entity *new_entity = &world->entities[world->entity_count];
-        new_entity->id = world->next_entity_id++;
-        new_entity->type = type;
-        new_entity->position = spawn_pos;
-        new_entity->energy = initial_energy;
-        new_entity->age = 0;
-        new_entity->sight_range = sight_range;
-        new_entity->last_reproduction_step = current_step; // Azért, hogy ne szaporodjon azonnal
-        new_entity->last_eating_step = -1;
-        new_entity->just_spawned_by_keypress = use_visual_spawn_highlight;
-
-        world->grid[spawn_pos.y][spawn_pos.x].entity = new_entity;
-        world->entity_count++;
+        fprintf(stderr, "Aréna: %.1f MB, %s\n", world->arena->size / (1024.0 * 1024.0),
+                world->arena->huge_pages ? "MAP_HUGETLB" : (world->arena->transparent_huge ? "MADV_HUGEPAGE" : "normál lapok"));
     }
-    else
+    world->latency = latency;
+    event_log_attach(events, world);
+    if ((metrics && !metrics_exporter_attach(metrics, world)) || (publisher && !shm_publisher_attach(publisher, world)))
     {
-        // Opcionálisan logolás: Nem talált üres cellát a spawnoláshoz
+        ecosim_destroy(engine);
+        return 1;
     }
-}
 
-void run_simulation(World *world, int simulation_steps_to_run, long step_delay_ms)
-{
-    // A timeout() beállítja a getch() viselkedését. Pozitív érték esetén
-    // a getch() ennyi milliszekundumig vár inputra, majd ERR-t ad vissza, ha nincs.
-    // Ez teszi lehetővé a nem blokkoló inputkezelést a szimulációs ciklusban.
-    timeout((int)step_delay_ms);
-
-    // Világ megjelenítésére szolgáló dedikált ncurses ablak létrehozása.
-    // Az információs sávnak 1 sort hagyunk fent (stdscr tetején), így az ablak y pozíciója 1.
-    // A keret miatt (+2) szélesség és magasság szükséges.
-    WINDOW *world_win = newwin(world->height + 2, world->width + 2, 1, (COLS - (world->width + 2)) / 2);
-    if (!world_win)
+    // Az indulási idő (aréna, benépesítés, rétegek) külön a lépések idejétől
+    double steps_begin = omp_get_wtime();
+    fprintf(stderr, "Indulás: %.1f ms (benépesítés %.1f ms, %d entitás, %s)\n",
+            (steps_begin - startup_begin) * 1000.0, ecosim_populate_seconds(engine) * 1000.0,
+            world->entity_count, options->bulk_init ? "tömeges generálás" : "soros elhelyezés");
+    long long entity_updates = 0; // A lépések elején élő entitások (és rétegbeli növények) összege
+    EcosimBranch *branches[MAX_BRANCHES] = {NULL};
+    for (int step = 0; step < options->steps; step++)
     {
-        cleanup_display();
-        fprintf(stderr, "Hiba: Nem sikerült létrehozni az ncurses ablakot a szimulációhoz.\n");
-        return;
+        // Az ágak copy-on-write öröklik az állapotot; az alapág (ez a folyamat) változatlanul fut tovább
+        if (step == options->fork_at)
+        {
+            for (int b = 0; b < options->branch_count; b++)
+            {
+                BranchPlan plan = {options->branch_extra[b], options->steps - step};
+                branches[b] = ecosim_fork(engine, run_branch_plan, &plan);
+            }
+        }
+        entity_updates += world->entity_count + (world->plants ? plant_layer_count(world->plants) : 0);
+        ecosim_step(engine, 1);
+    }
+    double steps_end = omp_get_wtime();
+    if (options->steps > 0)
+    {
+        fprintf(stderr, "Lépések: %.3f s, átlag %.3f ms/lépés\n", steps_end - steps_begin,
+                (steps_end - steps_begin) * 1000.0 / options->steps);
     }
+    sync_telemetry_report(stderr);
+    phase_tuner_report(world->tuner, stderr);
+    world_chunks_report(world, stderr);
 
-    for (int step = 0; step < simulation_steps_to_run; step++)
+    if (options->bench_name)
     {
-        simulate_step(world, step);
-        draw_simulation_state(world, step, simulation_steps_to_run, world_win); // Ablak átadása
+        // Egy sor, egy lapos JSON objektum: a bench.sh ezt gyűjti és veti össze az alapvonallal
+        // A fázisok lépésenkénti átlagideje a scaling.sh-nak, a fajonkénti végső létszám a bench.sh
+        // túlélés-ellenőrzésének; telemetriás fordításnál a szinkronizációs pontok számlálói is a sorba kerülnek
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double seconds = steps_end - steps_begin;
+        double phase_ms[LATENCY_PHASE_COUNT] = {0};
+        for (int phase = 0; phase < LATENCY_PHASE_COUNT && latency; phase++)
+            phase_ms[phase] = latency_histogram_mean(&latency->overall[phase]) / 1e6;
+        char sync_fields[1024];
+        sync_telemetry_format_json(sync_fields, sizeof(sync_fields));
+        char memory_fields[1024];
+        memory_format_json(memory_fields, sizeof(memory_fields));
+        printf("{\"scenario\": \"%s\", \"width\": %d, \"height\": %d, \"steps\": %d, \"threads\": %d, "
+               "\"startup_ms\": %.1f, \"seconds\": %.3f, \"steps_per_sec\": %.4f, \"entity_updates_per_sec\": %.0f, "
+               "\"peak_rss_kb\": %ld, \"step_ms\": %.4f, \"carnivore_ms\": %.4f, \"herbivore_ms\": %.4f, "
+               "\"plant_ms\": %.4f, \"final_plants\": %d, \"final_herbivores\": %d, \"final_carnivores\": %d%s%s}\n",
+               options->bench_name, options->width, options->height, options->steps, omp_get_max_threads(),
+               (steps_begin - startup_begin) * 1000.0, seconds,
+               seconds > 0.0 ? options->steps / seconds : 0.0, seconds > 0.0 ? entity_updates / seconds : 0.0,
+               usage.ru_maxrss, phase_ms[LATENCY_PHASE_TOTAL], phase_ms[LATENCY_PHASE_CARNIVORE],
+               phase_ms[LATENCY_PHASE_HERBIVORE], phase_ms[LATENCY_PHASE_PLANT], count_entities_by_type(world, PLANT),
+               count_entities_by_type(world, HERBIVORE), count_entities_by_type(world, CARNIVORE), sync_fields, memory_fields);
+    }
 
-        doupdate(); // Fizikai képernyő frissítése az összes előkészített változással (stdscr és world_win).
+    if (options->print_hash)
+    {
+        printf("%016llx steps=%d entities=%d plants=%d threads=%d\n",
+               ecosim_state_hash(engine), options->steps, world->entity_count,
+               count_entities_by_type(world, PLANT), omp_get_max_threads());
+    }
 
-        int ch = getch(); // Nem blokkoló olvasás a timeout miatt.
-        if (ch == 'q' || ch == 'Q')
+    PopulationRecord record;
+    if (options->print_stats && ecosim_read_stats(engine, &record))
+    {
+        for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
         {
-            break; // Kilépés a szimulációs ciklusból.
+            printf("stats step=%d type=%s count=%d mean_energy=%.2f mean_age=%.2f births=%d deaths=%d eaten=%d\n",
+                   record.step, species_table[type].name, record.count[type],
+                   record.count[type] ? (double)record.energy_sum[type] / record.count[type] : 0.0,
+                   record.count[type] ? (double)record.age_sum[type] / record.count[type] : 0.0,
+                   record.births[type], record.deaths[type], record.predations[type]);
         }
-        // Manuális entitás spawnolás billentyűleütésre.
-        else if (ch == 'h' || ch == 'H') // Herbivore spawn
+    }
+
+    // Az ágak bevárása és összevetése az alapággal (az alapág a fenti végállapot)
+    int branch_failures = 0;
+    if (options->branch_count > 0)
+    {
+        printf("branch=base fork_at=%d steps=%d plants=%d herbivores=%d carnivores=%d hash=%016llx\n", options->fork_at,
+               ecosim_current_step(engine), ecosim_count(engine, PLANT), ecosim_count(engine, HERBIVORE),
+               ecosim_count(engine, CARNIVORE), ecosim_state_hash(engine));
+    }
+    for (int b = 0; b < options->branch_count; b++)
+    {
+        EcosimBranchResult result;
+        if (!branches[b] || !ecosim_branch_wait(branches[b], &result))
         {
-            spawn_entity_manually(world, HERBIVORE, step);
+            branch_failures++;
+            continue;
         }
-        else if (ch == 'c' || ch == 'C') // Carnivore spawn
+        int placed[ENTITY_TYPE_COUNT];
+        memcpy(placed, result.payload, sizeof(placed));
+        printf("branch=%d extra=%d,%d,%d placed=%d,%d,%d steps=%d plants=%d herbivores=%d carnivores=%d hash=%016llx "
+               "copied_kb=%ld seconds=%.3f\n",
+               b + 1, options->branch_extra[b][PLANT], options->branch_extra[b][HERBIVORE], options->branch_extra[b][CARNIVORE],
+               placed[PLANT], placed[HERBIVORE], placed[CARNIVORE], result.step, result.counts[PLANT],
+               result.counts[HERBIVORE], result.counts[CARNIVORE], result.hash, result.copied_kb, result.seconds);
+    }
+
+    if (options->memory_report)
+        memory_report(stderr);
+
+    ecosim_destroy(engine);
+    return branch_failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    CommandLineOptions options;
+    if (!parse_command_line(argc, argv, &options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    memory_set_budget(options.memory_budget); // A menüs futás világaira is érvényes
+    // Opcionális lépésenkénti, szálankénti szinkronizációs napló (csak telemetriás fordításban)
+    if (options.sync_log_path && !sync_telemetry_open_log(options.sync_log_path))
+        return 1;
+
+    // Opcionális metrika-exportáló szál; a teljes futás alatt él, a világok csak hivatkoznak rá
+    MetricsExporter *metrics = NULL;
+    if (options.metrics_socket || options.metrics_port)
+    {
+        metrics = metrics_exporter_start(options.metrics_socket, options.metrics_port);
+        if (!metrics)
+            return 1;
+    }
+
+    // Opcionális osztott memóriás publikáló; a szegmenst a világhoz rendeléskor méretezi
+    ShmPublisher *publisher = NULL;
+    if (options.shm_name)
+    {
+        publisher = shm_publisher_start(options.shm_name, options.shm_interval);
+        if (!publisher)
         {
-            spawn_entity_manually(world, CARNIVORE, step);
+            metrics_exporter_stop(metrics);
+            return 1;
         }
-        else if (ch == 'p' || ch == 'P') // Növény spawnolása
+    }
+
+    // Opcionális eseménynapló; a saját író szála a teljes futás alatt él, a világok csak hivatkoznak rá
+    EventLog *events = NULL;
+    if (options.event_log_path)
+    {
+        events = event_log_open(options.event_log_path, options.event_filter);
+        if (!events)
         {
-            spawn_entity_manually(world, PLANT, step);
+            metrics_exporter_stop(metrics);
+            shm_publisher_stop(publisher);
+            return 1;
         }
     }
 
-    delwin(world_win); // A dedikált világ ablak törlése.
-    timeout(-1);       // Visszaállítjuk a getch() alapértelmezett blokkoló viselkedését a menühöz.
-    clear();           // Teljes képernyő törlése a szimuláció után.
-    refresh();         // A törölt képernyő tényleges frissítése.
-}
+    // Lépésidő-hisztogramok a teljes futásra; a percentiliseket kilépéskor az stderr-re írjuk
+    LatencyRecorder *latency = latency_recorder_create(options.latency_window, options.step_log);
+
+    if (options.headless)
+    {
+        int result = run_headless(&options, metrics, latency, publisher, events);
+        if (latency)
+            latency_recorder_report(latency, stderr);
+        event_log_flush(events);
+        event_log_report(events, stderr);
+        event_log_close(events);
+        sync_telemetry_close_log();
+        latency_recorder_free(latency);
+        metrics_exporter_stop(metrics);
+        shm_publisher_stop(publisher);
+        return result;
+    }
 
-int main(int argc, char *argv[])
-{
     // Véletlenszám-generátor inicializálása fix seed-del az ismételhetőséghez
     srand(RANDOM_SEED);
 
@@ -769,21 +1080,37 @@ int main(int argc, char *argv[])
         switch (choice)
         {
         case MENU_START:
-            if (world)
-            { // Ha volt már korábbi szimuláció, a hozzá tartozó memóriát fel kell szabadítani.
+            if (world && (world->width != world_size_values[current_settings.world_size_choice].x ||
+                          world->height != world_size_values[current_settings.world_size_choice].y))
+            { // Ha a korábbi szimuláció más méretű volt, a hozzá tartozó memóriát fel kell szabadítani.
                 free_world(world);
                 world = NULL; // Fontos, hogy nullázzuk, jelezve, hogy nincs aktív világ.
             }
-            // Világ létrehozása az aktuális beállítások alapján.
-            world = create_world(world_size_values[current_settings.world_size_choice].x, world_size_values[current_settings.world_size_choice].y);
+            // Azonos méretnél a világ arénáját újrahasznosítjuk, egyébként új világot hozunk létre.
+            if (world)
+                reset_world(world);
+            else
+                world = create_world_in_arena(world_size_values[current_settings.world_size_choice].x,
+                                              world_size_values[current_settings.world_size_choice].y, options.huge_pages);
             if (!world)
             {
                 cleanup_display();
                 fprintf(stderr, "Hiba a világ létrehozásakor!\n");
+                metrics_exporter_stop(metrics);
+                shm_publisher_stop(publisher);
+                event_log_close(events);
+                latency_recorder_free(latency);
                 return 1; // Kritikus hiba, kilépés.
             }
+            topology_set_toroidal(world, options.toroidal);
             // Kezdeti entitásokkal való feltöltés a simulation_constants.h-ban definiált értékekkel.
             initialize_world(world, INITIAL_PLANTS, INITIAL_HERBIVORES, INITIAL_CARNIVORES);
+            world->latency = latency;
+            if (metrics)
+                metrics_exporter_attach(metrics, world);
+            if (publisher)
+                shm_publisher_attach(publisher, world);
+            event_log_attach(events, world);
             run_simulation(world, simulation_steps_values[current_settings.steps_choice], delay_values_ms[current_settings.delay_choice]);
             // A run_simulation után a képernyő tiszta, a főmenü újra megjelenik.
             break;
@@ -805,5 +1132,15 @@ int main(int argc, char *argv[])
         free_world(world);
     }
     cleanup_display(); // Ncurses lezárása.
+    if (latency)
+        latency_recorder_report(latency, stderr);
+    sync_telemetry_report(stderr);
+    event_log_flush(events);
+    event_log_report(events, stderr);
+    event_log_close(events);
+    sync_telemetry_close_log();
+    latency_recorder_free(latency);
+    metrics_exporter_stop(metrics);
+    shm_publisher_stop(publisher);
     return 0;
 }
\ No newline at end of file
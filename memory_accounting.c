@@ -0,0 +1,226 @@
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "memory_accounting.h"
+
+static const char *subsystem_names[MEMORY_SUBSYSTEM_COUNT] = {
+    "world", "grids", "entities", "lifecycle", "free_cells", "perception", "topology",
+    "plants", "deterministic", "task_graph", "stats", "generator", "publisher", "event_log", "phase_tuner"};
+
+// Alrendszerenként és összesen; a foglalások párhuzamos régiókból is jöhetnek (pl. az
+// eseménynapló szálankénti pufferei), ezért minden módosítás atomi
+static size_t current_bytes[MEMORY_SUBSYSTEM_COUNT];
+static size_t peak_bytes[MEMORY_SUBSYSTEM_COUNT];
+static size_t total_current;
+static size_t total_peak;
+static size_t budget_bytes;
+
+static void raise_peak(size_t *peak, size_t value)
+{
+    size_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > seen && !__atomic_compare_exchange_n(peak, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+// Növelés; keret esetén csak akkor, ha az összesen belefér (egyébként hamis, és nem változik semmi)
+static bool charge(MemorySubsystem subsystem, size_t bytes, bool enforce)
+{
+    size_t budget = __atomic_load_n(&budget_bytes, __ATOMIC_RELAXED);
+    size_t total = __atomic_load_n(&total_current, __ATOMIC_RELAXED);
+    size_t updated;
+    do
+    {
+        updated = total + bytes;
+        if (enforce && budget && (updated < total || updated > budget))
+            return false;
+    } while (!__atomic_compare_exchange_n(&total_current, &total, updated, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    raise_peak(&total_peak, updated);
+    raise_peak(&peak_bytes[subsystem], __atomic_add_fetch(&current_bytes[subsystem], bytes, __ATOMIC_RELAXED));
+    return true;
+}
+
+static void discharge(MemorySubsystem subsystem, size_t bytes)
+{
+    __atomic_sub_fetch(&current_bytes[subsystem], bytes, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&total_current, bytes, __ATOMIC_RELAXED);
+}
+
+// A kért méretet előre, kerettel terheljük; a sikeres foglalás után a tényleges (usable) méretre igazítunk
+static void settle(MemorySubsystem subsystem, size_t requested, void *ptr)
+{
+    size_t usable = malloc_usable_size(ptr);
+    if (usable > requested)
+        charge(subsystem, usable - requested, false);
+    else if (usable < requested)
+        discharge(subsystem, requested - usable);
+}
+
+static void *refuse(void)
+{
+    errno = ENOMEM;
+    return NULL;
+}
+
+void *memory_malloc(MemorySubsystem subsystem, size_t size)
+{
+    if (!charge(subsystem, size, true))
+        return refuse();
+    void *ptr = malloc(size);
+    if (!ptr)
+    {
+        discharge(subsystem, size);
+        return NULL;
+    }
+    settle(subsystem, size, ptr);
+    return ptr;
+}
+
+void *memory_calloc(MemorySubsystem subsystem, size_t count, size_t size)
+{
+    if (size && count > (size_t)-1 / size)
+        return refuse();
+    size_t bytes = count * size;
+    if (!charge(subsystem, bytes, true))
+        return refuse();
+    void *ptr = calloc(count, size);
+    if (!ptr)
+    {
+        discharge(subsystem, bytes);
+        return NULL;
+    }
+    settle(subsystem, bytes, ptr);
+    return ptr;
+}
+
+void *memory_realloc(MemorySubsystem subsystem, void *ptr, size_t size)
+{
+    size_t old_usable = ptr ? malloc_usable_size(ptr) : 0;
+    size_t growth = size > old_usable ? size - old_usable : 0;
+    if (!charge(subsystem, growth, true))
+        return refuse();
+    void *moved = realloc(ptr, size);
+    if (!moved)
+    {
+        discharge(subsystem, growth);
+        return NULL;
+    }
+    // Most old_usable + growth van terhelve; a tényleges új méretre igazítunk
+    settle(subsystem, old_usable + growth, moved);
+    return moved;
+}
+
+int memory_posix_memalign(MemorySubsystem subsystem, void **ptr, size_t alignment, size_t size)
+{
+    if (!charge(subsystem, size, true))
+        return ENOMEM;
+    int result = posix_memalign(ptr, alignment, size);
+    if (result != 0)
+    {
+        discharge(subsystem, size);
+        return result;
+    }
+    settle(subsystem, size, *ptr);
+    return 0;
+}
+
+void memory_free(MemorySubsystem subsystem, void *ptr)
+{
+    if (!ptr)
+        return;
+    discharge(subsystem, malloc_usable_size(ptr));
+    free(ptr);
+}
+
+bool memory_reserve(MemorySubsystem subsystem, size_t bytes)
+{
+    return charge(subsystem, bytes, true);
+}
+
+void memory_note_mapped(MemorySubsystem subsystem, size_t bytes)
+{
+    charge(subsystem, bytes, false);
+}
+
+void memory_release(MemorySubsystem subsystem, size_t bytes)
+{
+    discharge(subsystem, bytes);
+}
+
+bool memory_budget_allows(size_t bytes)
+{
+    size_t budget = __atomic_load_n(&budget_bytes, __ATOMIC_RELAXED);
+    size_t total = __atomic_load_n(&total_current, __ATOMIC_RELAXED);
+    return !budget || (bytes <= budget && total <= budget - bytes);
+}
+
+void memory_set_budget(size_t bytes)
+{
+    __atomic_store_n(&budget_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+size_t memory_budget(void)
+{
+    return __atomic_load_n(&budget_bytes, __ATOMIC_RELAXED);
+}
+
+MemoryUsage memory_usage(MemorySubsystem subsystem)
+{
+    MemoryUsage usage = {__atomic_load_n(&current_bytes[subsystem], __ATOMIC_RELAXED),
+                         __atomic_load_n(&peak_bytes[subsystem], __ATOMIC_RELAXED)};
+    return usage;
+}
+
+MemoryUsage memory_total_usage(void)
+{
+    MemoryUsage usage = {__atomic_load_n(&total_current, __ATOMIC_RELAXED), __atomic_load_n(&total_peak, __ATOMIC_RELAXED)};
+    return usage;
+}
+
+const char *memory_subsystem_name(MemorySubsystem subsystem)
+{
+    return subsystem >= 0 && subsystem < MEMORY_SUBSYSTEM_COUNT ? subsystem_names[subsystem] : "?";
+}
+
+long memory_peak_rss_kb(void)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss;
+}
+
+void memory_report(FILE *out)
+{
+    MemoryUsage total = memory_total_usage();
+    size_t budget = memory_budget();
+    fprintf(out, "Memória alrendszerenként (KiB, aktuális / csúcs):\n");
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; subsystem++)
+    {
+        MemoryUsage usage = memory_usage((MemorySubsystem)subsystem);
+        if (usage.peak == 0)
+            continue;
+        fprintf(out, "  %-14s %10.1f / %10.1f\n", subsystem_names[subsystem], usage.current / 1024.0, usage.peak / 1024.0);
+    }
+    fprintf(out, "  %-14s %10.1f / %10.1f", "total", total.current / 1024.0, total.peak / 1024.0);
+    if (budget)
+        fprintf(out, " (keret: %.1f KiB)", budget / 1024.0);
+    fprintf(out, "\n  A folyamat csúcs RSS-e: %ld KiB\n", memory_peak_rss_kb());
+}
+
+void memory_format_json(char *out, size_t size)
+{
+    MemoryUsage total = memory_total_usage();
+    int written = snprintf(out, size, ", \"mem_peak_bytes\": %zu, \"mem_budget_bytes\": %zu", total.peak, memory_budget());
+    size_t length = written > 0 ? (size_t)written : 0;
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT && length < size; subsystem++)
+    {
+        written = snprintf(out + length, size - length, ", \"mem_%s_peak_bytes\": %zu", subsystem_names[subsystem],
+                           memory_usage((MemorySubsystem)subsystem).peak);
+        if (written < 0)
+            break;
+        length += (size_t)written;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Memóriaelszámolás alrendszerenként: a motor foglalásai (az aréna régiói és a kiegészítő
+// rétegek heap-foglalásai) a memory_* függvényeken át mennek, amelyek alrendszerenként az aktuális
+// és a csúcs bájtszámot vezetik (szálbiztosan, atomi műveletekkel). A heap-foglalások a
+// malloc_usable_size szerinti tényleges méretükkel számítanak, a leképezések a leképezett mérettel.
+//
+// Opcionális kemény keret (memory_set_budget): a keretet túllépő foglalás NULL-t ad (errno = ENOMEM),
+// mintha elfogyott volna a memória, így a világ létrehozása a szokásos hibaúton, tisztán hiúsul meg
+// ahelyett, hogy a gép lapozni kezdene. A keret a számon tartott bájtokra vonatkozik, nem a
+// folyamat teljes RSS-ére (a front end, az OpenMP futtatókörnyezet és a libc nincs benne).
+
+typedef enum
+{
+    MEMORY_WORLD,         // A World struktúra, az aréna leírója, a sormutatók és a nagy lapos kerekítés
+    MEMORY_GRIDS,         // A két cellarács
+    MEMORY_ENTITIES,      // A két entitástömb
+    MEMORY_LIFECYCLE,     // Az életciklus SoA tömbjei és szálankénti számlálói
+    MEMORY_FREE_CELLS,    // A szabad cellák indexe
+    MEMORY_PERCEPTION,    // Az észlelési gyorsítótár
+    MEMORY_TOPOLOGY,      // A szomszédsági táblák
+    MEMORY_PLANTS,        // A sűrű növényréteg
+    MEMORY_DETERMINISTIC, // A determinisztikus mód segédpufferei
+    MEMORY_TASK_GRAPH,    // A sávos feladatgráf pufferei
+    MEMORY_STATS,         // A populációs statisztika részösszegei
+    MEMORY_GENERATOR,     // Sűrűségtérképek és a tömeges benépesítés ideiglenes tömbjei
+    MEMORY_PUBLISHER,     // Az osztott memóriás pillanatkép-szegmens
+    MEMORY_EVENT_LOG,     // Az eseménynapló szálankénti pufferei
+    MEMORY_PHASE_TUNER,   // A fázishangoló becslései
+    MEMORY_SUBSYSTEM_COUNT
+} MemorySubsystem;
+
+typedef struct
+{
+    size_t current;
+    size_t peak;
+} MemoryUsage;
+
+// Számon tartott heap-foglalások; a felszabadításnál ugyanazt az alrendszert kell megadni.
+void *memory_malloc(MemorySubsystem subsystem, size_t size);
+void *memory_calloc(MemorySubsystem subsystem, size_t count, size_t size);
+void *memory_realloc(MemorySubsystem subsystem, void *ptr, size_t size);
+int memory_posix_memalign(MemorySubsystem subsystem, void **ptr, size_t alignment, size_t size);
+void memory_free(MemorySubsystem subsystem, void *ptr);
+
+// Más úton (mmap) foglalt bájtok elszámolása. A memory_reserve a keretet is ellenőrzi
+// (hamis, ha nem fér bele); a memory_note_mapped keret nélkül számol (pl. egy már ellenőrzött
+// leképezés régióinak szétosztásához).
+bool memory_reserve(MemorySubsystem subsystem, size_t bytes);
+void memory_note_mapped(MemorySubsystem subsystem, size_t bytes);
+void memory_release(MemorySubsystem subsystem, size_t bytes);
+// Igaz, ha további bytes bájt belefér a keretbe (keret nélkül mindig igaz).
+bool memory_budget_allows(size_t bytes);
+
+// Kemény keret bájtban (0: nincs keret).
+void memory_set_budget(size_t bytes);
+size_t memory_budget(void);
+
+MemoryUsage memory_usage(MemorySubsystem subsystem);
+MemoryUsage memory_total_usage(void);
+const char *memory_subsystem_name(MemorySubsystem subsystem);
+// A folyamat csúcs rezidens mérete (getrusage, KiB).
+long memory_peak_rss_kb(void);
+
+// Összegzés alrendszerenként (aktuális és csúcs), a keret és a folyamat csúcs RSS-e.
+void memory_report(FILE *out);
+// A benchmark JSON sorába illeszthető ", \"mem_...\": ..." mezők.
+void memory_format_json(char *out, size_t size);
+
+#endif // MEMORY_ACCOUNTING_H
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <omp.h>
+
+#include "metrics_exporter.h"
+#include "population_stats.h"
+#include "species.h"
+
+#define METRICS_POLL_TIMEOUT_MS 200 // Ennyi időnként ellenőrzi a szál a leállítási kérést
+#define METRICS_RESPONSE_SIZE 16384
+
+// A fázisidő-hisztogram felső határai másodpercben (Prometheus "le" címkék); utána a +Inf rekesz
+static const double latency_bounds[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+                                        0.025, 0.05, 0.1, 0.25, 0.5, 1.0};
+#define LATENCY_BUCKETS ((int)(sizeof(latency_bounds) / sizeof(latency_bounds[0])) + 1)
+
+static const char *phase_names[METRICS_PHASE_COUNT] = {"carnivore", "herbivore", "plant"};
+
+struct MetricsExporter
+{
+    int listen_fd;
+    char socket_path[108]; // Unix socket esetén a leállításkor törlendő fájl (üres: TCP)
+    pthread_t thread;
+    int stop_requested;
+
+    // A szimuláció által írt számlálók (csak atomikus műveletekkel érjük el)
+    unsigned long long steps_completed;
+    unsigned long long commit_drops;
+    unsigned long long phase_buckets[METRICS_PHASE_COUNT][LATENCY_BUCKETS]; // Nem kumulatív darabszámok
+    unsigned long long phase_sum_ns[METRICS_PHASE_COUNT];
+    int entity_counts[ENTITY_TYPE_COUNT];
+    int threads;
+};
+
+// Formázott szöveg hozzáfűzése a válasz pufferhez (csonkol, ha megtelt)
+__attribute__((format(printf, 3, 4))) static void append(char *buffer, size_t *length, const char *format, ...)
+{
+    if (*length >= METRICS_RESPONSE_SIZE)
+        return;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + *length, METRICS_RESPONSE_SIZE - *length, format, args);
+    va_end(args);
+    if (written > 0)
+        *length += (size_t)written;
+    if (*length > METRICS_RESPONSE_SIZE)
+        *length = METRICS_RESPONSE_SIZE;
+}
+
+// A Prometheus szöveges kimenet összeállítása a számlálók pillanatnyi értékeiből
+static size_t render_metrics(MetricsExporter *exporter, char *buffer)
+{
+    size_t length = 0;
+    append(buffer, &length, "# HELP ecosim_steps_completed_total Befejezett szimulációs lépések.\n");
+    append(buffer, &length, "# TYPE ecosim_steps_completed_total counter\n");
+    append(buffer, &length, "ecosim_steps_completed_total %llu\n", __atomic_load_n(&exporter->steps_completed, __ATOMIC_RELAXED));
+
+    append(buffer, &length, "# HELP ecosim_phase_latency_seconds Fázisonkénti futásidő lépésenként.\n");
+    append(buffer, &length, "# TYPE ecosim_phase_latency_seconds histogram\n");
+    for (int phase = 0; phase < METRICS_PHASE_COUNT; phase++)
+    {
+        unsigned long long cumulative = 0;
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        {
+            cumulative += __atomic_load_n(&exporter->phase_buckets[phase][bucket], __ATOMIC_RELAXED);
+            if (bucket < LATENCY_BUCKETS - 1)
+                append(buffer, &length, "ecosim_phase_latency_seconds_bucket{phase=\"%s\",le=\"%g\"} %llu\n",
+                       phase_names[phase], latency_bounds[bucket], cumulative);
+            else
+                append(buffer, &length, "ecosim_phase_latency_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n",
+                       phase_names[phase], cumulative);
+        }
+        append(buffer, &length, "ecosim_phase_latency_seconds_sum{phase=\"%s\"} %.9f\n", phase_names[phase],
+               __atomic_load_n(&exporter->phase_sum_ns[phase], __ATOMIC_RELAXED) / 1e9);
+        append(buffer, &length, "ecosim_phase_latency_seconds_count{phase=\"%s\"} %llu\n", phase_names[phase], cumulative);
+    }
+
+    append(buffer, &length, "# HELP ecosim_entities Élőlények száma típusonként az utolsó lépés után.\n");
+    append(buffer, &length, "# TYPE ecosim_entities gauge\n");
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        append(buffer, &length, "ecosim_entities{type=\"%s\"} %d\n", species_table[type].name,
+               __atomic_load_n(&exporter->entity_counts[type], __ATOMIC_RELAXED));
+
+    append(buffer, &length, "# HELP ecosim_commit_drops_total Elveszett entitások, mert a next_entities megtelt.\n");
+    append(buffer, &length, "# TYPE ecosim_commit_drops_total counter\n");
+    append(buffer, &length, "ecosim_commit_drops_total %llu\n", __atomic_load_n(&exporter->commit_drops, __ATOMIC_RELAXED));
+
+    append(buffer, &length, "# HELP ecosim_threads Az OpenMP szálak száma.\n");
+    append(buffer, &length, "# TYPE ecosim_threads gauge\n");
+    append(buffer, &length, "ecosim_threads %d\n", __atomic_load_n(&exporter->threads, __ATOMIC_RELAXED));
+    return length;
+}
+
+static void send_all(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return;
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+// Egy kapcsolat kiszolgálása: a kérést (bármi is az) elolvassuk, majd HTTP/1.0 válasszal küldjük a metrikákat.
+static void serve_client(MetricsExporter *exporter, int client_fd)
+{
+    char request[1024];
+    struct pollfd pfd = {client_fd, POLLIN, 0};
+    if (poll(&pfd, 1, METRICS_POLL_TIMEOUT_MS) > 0)
+    {
+        if (recv(client_fd, request, sizeof(request), 0) < 0)
+            return;
+    }
+
+    static char body[METRICS_RESPONSE_SIZE]; // Csak az exportáló szál használja
+    size_t body_length = render_metrics(exporter, body);
+    char header[160];
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+                                 body_length);
+    send_all(client_fd, header, (size_t)header_length);
+    send_all(client_fd, body, body_length);
+}
+
+static void *exporter_thread_main(void *argument)
+{
+    MetricsExporter *exporter = (MetricsExporter *)argument;
+    while (!__atomic_load_n(&exporter->stop_requested, __ATOMIC_ACQUIRE))
+    {
+        struct pollfd pfd = {exporter->listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, METRICS_POLL_TIMEOUT_MS) <= 0)
+            continue;
+        int client_fd = accept(exporter->listen_fd, NULL, NULL);
+        if (client_fd < 0)
+            continue;
+        serve_client(exporter, client_fd);
+        close(client_fd);
+    }
+    return NULL;
+}
+
+static int open_unix_socket(const char *path)
+{
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Hiba: túl hosszú socket útvonal: %s\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        perror("Hiba a metrika socket létrehozásakor");
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path); // Egy korábbi futás ott maradt socketje
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 8) < 0)
+    {
+        perror("Hiba a metrika socket megnyitásakor");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int open_loopback_socket(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        perror("Hiba a metrika socket létrehozásakor");
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Csak helyi elérés
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 8) < 0)
+    {
+        perror("Hiba a metrika port megnyitásakor");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+MetricsExporter *metrics_exporter_start(const char *socket_path, int port)
+{
+    MetricsExporter *exporter = (MetricsExporter *)calloc(1, sizeof(MetricsExporter));
+    if (!exporter)
+    {
+        perror("Hiba a metrika-exportáló foglalásakor");
+        return NULL;
+    }
+
+    if (socket_path)
+    {
+        exporter->listen_fd = open_unix_socket(socket_path);
+        if (exporter->listen_fd >= 0)
+            strcpy(exporter->socket_path, socket_path);
+    }
+    else
+    {
+        exporter->listen_fd = open_loopback_socket(port);
+    }
+    if (exporter->listen_fd < 0)
+    {
+        free(exporter);
+        return NULL;
+    }
+
+    exporter->threads = omp_get_max_threads();
+    if (pthread_create(&exporter->thread, NULL, exporter_thread_main, exporter) != 0)
+    {
+        perror("Hiba a metrika-exportáló szál indításakor");
+        close(exporter->listen_fd);
+        if (exporter->socket_path[0])
+            unlink(exporter->socket_path);
+        free(exporter);
+        return NULL;
+    }
+    return exporter;
+}
+
+void metrics_exporter_stop(MetricsExporter *exporter)
+{
+    if (!exporter)
+        return;
+    __atomic_store_n(&exporter->stop_requested, 1, __ATOMIC_RELEASE);
+    pthread_join(exporter->thread, NULL);
+    close(exporter->listen_fd);
+    if (exporter->socket_path[0])
+        unlink(exporter->socket_path);
+    free(exporter);
+}
+
+bool metrics_exporter_attach(MetricsExporter *exporter, World *world)
+{
+    if (!exporter || !world || !population_stats_enable(world))
+        return false;
+    world->metrics = exporter;
+    return true;
+}
+
+void metrics_exporter_record_step(MetricsExporter *exporter, const World *world, const double phase_seconds[METRICS_PHASE_COUNT])
+{
+    for (int phase = 0; phase < METRICS_PHASE_COUNT; phase++)
+    {
+        int bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && phase_seconds[phase] > latency_bounds[bucket])
+            bucket++;
+        __atomic_fetch_add(&exporter->phase_buckets[phase][bucket], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&exporter->phase_sum_ns[phase], (unsigned long long)(phase_seconds[phase] * 1e9), __ATOMIC_RELAXED);
+    }
+
+    // A létszámokat a lépés végén publikált statisztikai rekordból vesszük (nincs újabb menet)
+    PopulationRecord record;
+    if (world->stats && population_stats_read(world->stats, &record))
+    {
+        for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+            __atomic_store_n(&exporter->entity_counts[type], record.count[type], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&exporter->threads, omp_get_max_threads(), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&exporter->steps_completed, 1, __ATOMIC_RELEASE);
+}
+
+void metrics_exporter_note_commit_drop(MetricsExporter *exporter)
+{
+    __atomic_fetch_add(&exporter->commit_drops, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,34 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <stdbool.h>
+
+#include "datatypes.h" // Szükséges a World típushoz
+
+// Helyi metrika-exportáló: egy külön szál Prometheus szöveges formátumban szolgálja ki a
+// számlálókat egy Unix domain socketen vagy a 127.0.0.1 egy TCP portján (minimális HTTP/1.0).
+// A szimuláció csak atomikus számlálókat ír; az exportáló szál nem vesz fel olyan zárat,
+// amit a simulate_step is használ.
+
+typedef enum
+{
+    METRICS_PHASE_CARNIVORE,
+    METRICS_PHASE_HERBIVORE,
+    METRICS_PHASE_PLANT,
+    METRICS_PHASE_COUNT
+} MetricsPhase;
+
+// Indítás Unix socketen (socket_path != NULL) vagy a 127.0.0.1:port címen. Hiba esetén NULL.
+MetricsExporter *metrics_exporter_start(const char *socket_path, int port);
+// A kiszolgáló szál leállítása és az erőforrások felszabadítása.
+void metrics_exporter_stop(MetricsExporter *exporter);
+
+// Az exportáló hozzárendelése egy világhoz (bekapcsolja a populációs statisztikát is). Hiba esetén hamis.
+bool metrics_exporter_attach(MetricsExporter *exporter, World *world);
+
+// A simulate_step végén: fázisidők (másodperc) és a lépés utáni létszámok rögzítése.
+void metrics_exporter_record_step(MetricsExporter *exporter, const World *world, const double phase_seconds[METRICS_PHASE_COUNT]);
+// Egy entitás elveszett, mert a next_entities tömb megtelt (bármely szálról hívható).
+void metrics_exporter_note_commit_drop(MetricsExporter *exporter);
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <omp.h>
+
+#include "phase_tuner.h"
+#include "species.h"
+#include "memory_accounting.h"
+
+#define PROBE_ROUNDS 5         // A fork/join mérés ismétlései (a legkisebb számít)
+#define PROBE_REGIONS 64       // Üres párhuzamos régió ismétlésenként
+#define COST_SMOOTHING 0.25    // A költségbecslés mozgóátlagának súlya
+#define REFRESH_INTERVAL 100   // Ennyi döntés után egy nem választott szálszám újra mérésre kerül
+
+// Egy üres, a fázisokéval azonos alakú régió átlagos ideje t szálon
+static double measure_fork_join(int threads)
+{
+    // Bemelegítés: a szálkészlet felépítése ne a mérésbe essen
+#pragma omp parallel num_threads(threads)
+    {
+    }
+    double best = DBL_MAX;
+    for (int round = 0; round < PROBE_ROUNDS; round++)
+    {
+        double begin = omp_get_wtime();
+        for (int region = 0; region < PROBE_REGIONS; region++)
+        {
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
+            for (int k = 0; k < threads; k++)
+            {
+            }
+        }
+        double seconds = (omp_get_wtime() - begin) / PROBE_REGIONS;
+        if (seconds < best)
+            best = seconds;
+    }
+    return best;
+}
+
+bool phase_tuner_enable(World *world)
+{
+    if (!world)
+        return false;
+    if (world->tuner)
+        return true;
+    PhaseTuner *tuner = (PhaseTuner *)memory_calloc(MEMORY_PHASE_TUNER, 1, sizeof(PhaseTuner));
+    if (!tuner)
+    {
+        perror("Hiba a fázishangoló foglalásakor");
+        return false;
+    }
+
+    int max_threads = omp_get_max_threads();
+    for (int threads = 1; threads < max_threads && tuner->candidate_count < PHASE_TUNER_MAX_CANDIDATES - 1; threads *= 2)
+        tuner->candidates[tuner->candidate_count++] = threads;
+    tuner->candidates[tuner->candidate_count++] = max_threads;
+
+    tuner->fork_join[0] = 0.0; // Soros futásnál nincs régió
+    for (int c = 1; c < tuner->candidate_count; c++)
+        tuner->fork_join[c] = measure_fork_join(tuner->candidates[c]);
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+    {
+        tuner->last_choice[type] = -1;
+        for (int c = 0; c < tuner->candidate_count; c++)
+            tuner->cost[type][c] = -1.0;
+    }
+    world->tuner = tuner;
+    return true;
+}
+
+void phase_tuner_free(PhaseTuner *tuner)
+{
+    memory_free(MEMORY_PHASE_TUNER, tuner);
+}
+
+static int candidate_index(const PhaseTuner *tuner, int threads)
+{
+    for (int c = 0; c < tuner->candidate_count; c++)
+        if (tuner->candidates[c] == threads)
+            return c;
+    return -1;
+}
+
+// Mérésre váró jelölt: a még ki nem próbáltak (a teljes csapattól lefelé), majd a rég nem mértek
+static int stale_candidate(const PhaseTuner *tuner, EntityType phase)
+{
+    for (int c = tuner->candidate_count - 1; c >= 0; c--)
+        if (tuner->cost[phase][c] < 0.0 || tuner->step[phase] - tuner->measured_at[phase][c] >= REFRESH_INTERVAL)
+            return c;
+    return -1;
+}
+
+int phase_tuner_choose(PhaseTuner *tuner, EntityType phase, int items, int regions)
+{
+    int choice;
+    if (items <= 0)
+        choice = 0; // Nincs munka: a régió indítása is felesleges
+    else if ((choice = stale_candidate(tuner, phase)) < 0)
+    {
+        choice = 0;
+        double best = DBL_MAX;
+        for (int c = 0; c < tuner->candidate_count; c++)
+        {
+            double predicted = items * tuner->cost[phase][c] / tuner->candidates[c] + regions * tuner->fork_join[c];
+            if (predicted < best)
+            {
+                best = predicted;
+                choice = c;
+            }
+        }
+    }
+
+    tuner->step[phase]++;
+    tuner->decisions[phase][choice]++;
+    if (tuner->last_choice[phase] >= 0 && tuner->last_choice[phase] != choice)
+        tuner->switches[phase]++;
+    tuner->last_choice[phase] = choice;
+    return tuner->candidates[choice];
+}
+
+void phase_tuner_record(PhaseTuner *tuner, EntityType phase, int items, int regions, int threads, double seconds)
+{
+    int c = candidate_index(tuner, threads);
+    if (c < 0 || items <= 0)
+        return;
+    double work = seconds - regions * tuner->fork_join[c];
+    if (work < 0.0)
+        work = 0.0;
+    double observed = work * threads / items;
+    // Egy rég mért becslést felülírunk: a létszám és a terhelés azóta megváltozhatott
+    double *cost = &tuner->cost[phase][c];
+    bool stale = *cost < 0.0 || tuner->step[phase] - tuner->measured_at[phase][c] > REFRESH_INTERVAL;
+    *cost = stale ? observed : *cost + COST_SMOOTHING * (observed - *cost);
+    tuner->measured_at[phase][c] = tuner->step[phase];
+}
+
+void phase_tuner_report(const PhaseTuner *tuner, FILE *out)
+{
+    if (!tuner)
+        return;
+    fprintf(out, "Fázishangoló, fork/join:");
+    for (int c = 1; c < tuner->candidate_count; c++)
+        fprintf(out, " %d szál %.1f us%s", tuner->candidates[c], tuner->fork_join[c] * 1e6,
+                c + 1 < tuner->candidate_count ? "," : "");
+    fprintf(out, "%s\n", tuner->candidate_count == 1 ? " nincs párhuzamos jelölt (1 szál)" : "");
+    for (int phase = 0; phase < species_phase_count; phase++)
+    {
+        EntityType type = species_phase_order[phase];
+        long long total = 0;
+        for (int c = 0; c < tuner->candidate_count; c++)
+            total += tuner->decisions[type][c];
+        if (total == 0)
+            continue;
+        fprintf(out, "  %-10s", species_info(type)->name);
+        for (int c = 0; c < tuner->candidate_count; c++)
+        {
+            if (tuner->decisions[type][c] == 0)
+                continue;
+            fprintf(out, " %d szál: %lld lépés", tuner->candidates[c], tuner->decisions[type][c]);
+            if (tuner->cost[type][c] >= 0.0)
+                fprintf(out, " (%.2f us/elem)", tuner->cost[type][c] * 1e6);
+            fprintf(out, ";");
+        }
+        fprintf(out, " váltás: %lld\n", tuner->switches[type]);
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef PHASE_TUNER_H
+#define PHASE_TUNER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "datatypes.h"        // Szükséges a World, EntityType típusokhoz
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+
+// Adaptív soros/párhuzamos döntés fázisonként. Kis világban (vagy néhány ragadozónál) egy fázis
+// munkája kevesebb, mint egy OpenMP párhuzamos régió indítása és bevárása; ilyenkor a fázis
+// sorosan vagy kevesebb szálon gyorsabb.
+//
+// Bekapcsoláskor a hangoló megméri egy üres párhuzamos régió (fork/join) idejét a jelölt
+// szálszámokra (1, 2, 4, ..., omp_get_max_threads()). Lépésenként, fázisonként a becsült
+//     idő(t) = elemszám * költség(t) / t + régiók * fork_join(t)
+// szerint a legkisebbet választja; a költség(t) a t szálas futások mért, a fork/join nélküli
+// idejéből számolt szál-másodperc elemenként (mozgóátlag), így a gyenge párhuzamos hatásfok is
+// benne van. Először minden jelölt egyszer lefut (a teljes csapattól lefelé), utána pedig a
+// REFRESH_INTERVAL (phase_tuner.c) döntésnél régebben mért jelölt újra sorra kerül, így a becslés
+// követi a létszám és a terhelés változását.
+//
+// Csak a normál mód fázisaiban dönt (process_species_phase); a determinisztikus mód, a
+// feladatgráf és a növényréteg stencilje a teljes csapattal fut.
+
+#define PHASE_TUNER_MAX_CANDIDATES 16 // Jelölt szálszámok legfeljebb (2 hatványai és a maximum)
+
+struct PhaseTuner
+{
+    int candidate_count;
+    int candidates[PHASE_TUNER_MAX_CANDIDATES]; // Növekvő szálszámok, az első mindig 1 (soros)
+    double fork_join[PHASE_TUNER_MAX_CANDIDATES]; // Egy párhuzamos régió indítása és bevárása (s)
+    double cost[ENTITY_TYPE_COUNT][PHASE_TUNER_MAX_CANDIDATES]; // Szál-másodperc elemenként (< 0: még nem mért)
+    long long decisions[ENTITY_TYPE_COUNT][PHASE_TUNER_MAX_CANDIDATES]; // Lépések száma szálszámonként
+    long long measured_at[ENTITY_TYPE_COUNT][PHASE_TUNER_MAX_CANDIDATES]; // Az utolsó mérés döntésszáma
+    long long step[ENTITY_TYPE_COUNT];  // A fázis eddigi döntései
+    int last_choice[ENTITY_TYPE_COUNT]; // Jelöltindex (-1: még nem döntött)
+    long long switches[ENTITY_TYPE_COUNT];
+};
+
+// Bekapcsolja a hangolót (a fork/join mérés néhány ms). Hiba esetén hamis.
+bool phase_tuner_enable(World *world);
+void phase_tuner_free(PhaseTuner *tuner);
+
+// A fázis szálszáma erre a lépésre; items: a feldolgozandó elemek, regions: a fázis párhuzamos régiói.
+// 1: soros (a régió if záradéka hamis).
+int phase_tuner_choose(PhaseTuner *tuner, EntityType phase, int items, int regions);
+// A fázis mért ideje a választott szálszámmal; a költségbecslést frissíti.
+void phase_tuner_record(PhaseTuner *tuner, EntityType phase, int items, int regions, int threads, double seconds);
+
+// Összegzés: fork/join idők, fázisonként a döntések eloszlása, a váltások és a költségbecslések.
+void phase_tuner_report(const PhaseTuner *tuner, FILE *out);
+
+#endif // PHASE_TUNER_H
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "plant_layer.h"
+#include "population_stats.h"
+#include "simulation_constants.h"
+#include "world_utils.h"
+#include "sim_random.h"
+#include "free_cell_index.h"
+#include "topology.h"
+#include "sync_telemetry.h"
+#include "memory_accounting.h"
+
+_Static_assert(PLANT_MAX_ENERGY <= 255 && PLANT_INITIAL_ENERGY <= 255, "A növényréteg bájtos energiát tárol");
+_Static_assert(PLANT_MAX_AGE < 255, "A növényréteg bájtos kort tárol");
+
+#define SINCE_REPRODUCTION_CAP 255
+
+// 8 irány, ugyanabban a sorrendben, mint a world_utils.c-ben
+static const int direction_dx[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+static const int direction_dy[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+PlantLayer *plant_layer_create(int width, int height)
+{
+    PlantLayer *layer = (PlantLayer *)memory_calloc(MEMORY_PLANTS, 1, sizeof(PlantLayer));
+    if (!layer)
+    {
+        perror("Hiba a növényréteg foglalásakor");
+        return NULL;
+    }
+
+    size_t cells = (size_t)width * height;
+    layer->width = width;
+    layer->height = height;
+    layer->words_per_row = (width + 63) / 64;
+    size_t words = (size_t)layer->words_per_row * height;
+
+    layer->energy = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->age = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->since_reproduction = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->occupancy = (unsigned long long *)memory_calloc(MEMORY_PLANTS, words, sizeof(unsigned long long));
+    layer->next_energy = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->next_age = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->next_since_reproduction = (unsigned char *)memory_calloc(MEMORY_PLANTS, cells, 1);
+    layer->next_occupancy = (unsigned long long *)memory_calloc(MEMORY_PLANTS, words, sizeof(unsigned long long));
+    layer->fire_direction = (signed char *)memory_malloc(MEMORY_PLANTS, cells);
+
+    if (!layer->energy || !layer->age || !layer->since_reproduction || !layer->occupancy ||
+        !layer->next_energy || !layer->next_age || !layer->next_since_reproduction || !layer->next_occupancy ||
+        !layer->fire_direction)
+    {
+        perror("Hiba a növényréteg foglalásakor");
+        plant_layer_free(layer);
+        return NULL;
+    }
+    return layer;
+}
+
+void plant_layer_free(PlantLayer *layer)
+{
+    if (!layer)
+        return;
+    memory_free(MEMORY_PLANTS, layer->energy);
+    memory_free(MEMORY_PLANTS, layer->age);
+    memory_free(MEMORY_PLANTS, layer->since_reproduction);
+    memory_free(MEMORY_PLANTS, layer->occupancy);
+    memory_free(MEMORY_PLANTS, layer->next_energy);
+    memory_free(MEMORY_PLANTS, layer->next_age);
+    memory_free(MEMORY_PLANTS, layer->next_since_reproduction);
+    memory_free(MEMORY_PLANTS, layer->next_occupancy);
+    memory_free(MEMORY_PLANTS, layer->fire_direction);
+    memory_free(MEMORY_PLANTS, layer);
+}
+
+bool plant_layer_place(PlantLayer *layer, int x, int y, int energy, int age)
+{
+    if (x < 0 || x >= layer->width || y < 0 || y >= layer->height || energy <= 0 || plant_layer_occupied(layer, x, y))
+        return false;
+
+    size_t idx = (size_t)y * layer->width + x;
+    layer->energy[idx] = (unsigned char)(energy > PLANT_MAX_ENERGY ? PLANT_MAX_ENERGY : energy);
+    layer->age[idx] = (unsigned char)age;
+    layer->since_reproduction[idx] = 0;
+    __atomic_fetch_or(&layer->occupancy[y * layer->words_per_row + (x >> 6)], 1ULL << (x & 63), __ATOMIC_RELAXED);
+    return true;
+}
+
+bool plant_layer_try_graze(PlantLayer *layer, int x, int y)
+{
+    // A bittérkép bitje a "tulajdonjog": aki atomikusan törli, az ette meg a növényt.
+    unsigned long long bit = 1ULL << (x & 63);
+    SYNC_PROBE_BEGIN(probe);
+    unsigned long long old = __atomic_fetch_and(&layer->occupancy[y * layer->words_per_row + (x >> 6)], ~bit, __ATOMIC_ACQ_REL);
+    SYNC_PROBE_END(probe, SYNC_PLANT_GRAZE);
+    if (!(old & bit))
+        return false;
+
+    size_t idx = (size_t)y * layer->width + x;
+    layer->energy[idx] = 0;
+    layer->age[idx] = 0;
+    return true;
+}
+
+bool plant_layer_find_nearest(const PlantLayer *layer, const Topology *topology, Coordinates center, int range, Coordinates *out_pos)
+{
+    bool toroidal = topology->toroidal;
+    if (toroidal && range > topology->padding)
+        range = topology->padding;
+    // Gyűrűnként (növekvő Manhattan-távolság) rögzített sorrendben járjuk be a rombuszt,
+    // így az eredmény determinisztikus és O(range^2), függetlenül a növények számától.
+    for (int d = 0; d <= range; d++)
+    {
+        for (int dx = -d; dx <= d; dx++)
+        {
+            int dy = d - (dx < 0 ? -dx : dx);
+            int x = center.x + dx;
+            if (toroidal)
+                x = topology->column[x];
+            else if (x < 0 || x >= layer->width)
+                continue;
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                int y = center.y + sign * dy;
+                if (toroidal)
+                    y = topology->row[y];
+                if (y >= 0 && y < layer->height && plant_layer_occupied(layer, x, y))
+                {
+                    out_pos->x = x;
+                    out_pos->y = y;
+                    return true;
+                }
+                if (dy == 0)
+                    break; // dy == 0 esetén csak egy pont van
+            }
+        }
+    }
+    return false;
+}
+
+int plant_layer_count(const PlantLayer *layer)
+{
+    long long count = 0;
+    size_t words = (size_t)layer->words_per_row * layer->height;
+#pragma omp parallel for reduction(+ : count) schedule(static)
+    for (size_t w = 0; w < words; w++)
+    {
+        count += __builtin_popcountll(layer->occupancy[w]);
+    }
+    return (int)count;
+}
+
+bool plant_layer_enable(World *world)
+{
+    if (!world)
+        return false;
+    if (world->plants)
+        return true;
+    if (world->chunks)
+    {
+        // A réteg W*H méretű és minden lépésben a teljes rácson fut: a ritka tárolás célját rontaná
+        fprintf(stderr, "Hiba: a növényréteg ritka rácstárolással nem kapcsolható be.\n");
+        return false;
+    }
+
+    PlantLayer *layer = plant_layer_create(world->width, world->height);
+    if (!layer)
+        return false;
+
+    // PLANT entitások átköltöztetése a rétegbe, a többi entitás tömörítése
+    int kept = 0;
+    for (int i = 0; i < world->entity_count; i++)
+    {
+        Entity *e = &world->entities[i];
+        if (e->type == PLANT)
+        {
+            if (e->energy > 0 && plant_layer_place(layer, e->position.x, e->position.y, e->energy, e->age))
+            {
+                // A "legutóbbi szaporodás" lépés-relatív alakja (a következő lépés 0. lépésnek számít)
+                int since = -1 - e->last_reproduction_step;
+                layer->since_reproduction[(size_t)e->position.y * layer->width + e->position.x] =
+                    (unsigned char)(since < 0 ? 0 : (since > SINCE_REPRODUCTION_CAP ? SINCE_REPRODUCTION_CAP : since));
+            }
+            continue;
+        }
+        world->entities[kept++] = *e;
+    }
+    world->entity_count = kept;
+
+    // A rács pointerei a tömörítés miatt elavultak, újraépítjük
+    for (int y = 0; y < world->height; y++)
+        for (int x = 0; x < world->width; x++)
+            world->grid[y][x].entity = NULL;
+    for (int i = 0; i < world->entity_count; i++)
+    {
+        Coordinates pos = world->entities[i].position;
+        if (is_valid_pos(world, pos.x, pos.y) && world->grid[pos.y][pos.x].entity == NULL)
+            world->grid[pos.y][pos.x].entity = &world->entities[i];
+    }
+
+    world->plants = layer;
+    free_cell_index_invalidate(world->free_cells);
+    return true;
+}
+
+// 1. menet: melyik növény szaporodik ebben a lépésben, és melyik irányba.
+// Cellánként független, a véletlen a (seed, lépés, cella) hármasból számolt hash, így a
+// szálak számától és a feldolgozás sorrendjétől független.
+static void compute_fire_directions(const World *world, PlantLayer *layer, unsigned long long step_key)
+{
+    int width = layer->width;
+    const Topology *topology = world->topology;
+    const unsigned long long probability_threshold = (unsigned long long)(PLANT_REPRODUCTION_PROBABILITY * 9007199254740992.0); // * 2^53
+
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < layer->height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            size_t idx = (size_t)y * width + x;
+            signed char direction = -1;
+            int energy = layer->energy[idx];
+            if (energy > 0)
+            {
+                int next_energy = energy < PLANT_MAX_ENERGY ? energy + PLANT_GROWTH_RATE : energy;
+                if (next_energy > PLANT_MAX_ENERGY)
+                    next_energy = PLANT_MAX_ENERGY;
+                bool eligible = layer->age[idx] + 1 <= PLANT_MAX_AGE &&                              // Túléli a lépést
+                                next_energy >= PLANT_INITIAL_ENERGY &&                                // Elegendő energia
+                                layer->since_reproduction[idx] + 1 >= PLANT_REPRODUCTION_COOLDOWN;    // Letelt a cooldown
+                unsigned long long r = sim_random_mix64(step_key ^ (unsigned long long)idx);
+                if (eligible && (r >> 11) < probability_threshold)
+                {
+                    // A szülő egyenletesen választ a 8 irány közül; ha a cél nem szabad, a szaporodás elmarad
+                    int d = (int)(r & 7);
+                    int tx = topology->column[x + direction_dx[d]];
+                    int ty = topology->row[y + direction_dy[d]];
+                    bool inside = (topology->column_mask[x] & topology->row_mask[y]) >> d & 1;
+                    if (inside && !plant_layer_occupied(layer, tx, ty) && world->grid[ty][tx].entity == NULL)
+                    {
+                        direction = (signed char)d;
+                    }
+                }
+            }
+            layer->fire_direction[idx] = direction;
+        }
+    }
+}
+
+void plant_layer_step(World *world, int current_step_number)
+{
+    PlantLayer *layer = world->plants;
+    if (!layer)
+        return;
+
+    int width = layer->width;
+    int height = layer->height;
+    // A növények száma a növényfázis elején (legelés után) dönti el, jöhet-e létre új növény,
+    // ugyanúgy, mint az entitás alapú úton.
+    int plant_count = plant_layer_count(layer);
+    bool can_seed = plant_count < world->population_cap[PLANT];
+    if (world->stats)
+        population_stats_note_plant_layer_start(world->stats, plant_count);
+    unsigned long long step_key = sim_random_mix64(world->seed ^ sim_random_mix64((unsigned long long)current_step_number + 0x5bd1e995ULL));
+
+    if (can_seed)
+        compute_fire_directions(world, layer, step_key);
+    else
+        memset(layer->fire_direction, -1, (size_t)width * height);
+
+    // 2. menet: soronkénti stencil. A túlélő növények nőnek és öregszenek, az üres cellák
+    // akkor népesülnek be, ha valamelyik szomszédjuk feléjük szaporodott. A szülő cellája a
+    // topológia tábláiból jön; a d irányú szülő a (7 - d) irányban van, és csak akkor számít,
+    // ha az az irány a világon belül marad (tóruszon mindig).
+    const Topology *topology = world->topology;
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < height; y++)
+    {
+        const signed char *fire = layer->fire_direction;
+        size_t row = (size_t)y * width;
+        const size_t parent_rows[3] = {(size_t)topology->row[y + 1] * width, row, (size_t)topology->row[y - 1] * width};
+        unsigned char row_mask = topology->row_mask[y];
+
+#pragma omp simd
+        for (int x = 0; x < width; x++)
+        {
+            size_t idx = row + x;
+            int energy = layer->energy[idx];
+            int grown = energy + (energy < PLANT_MAX_ENERGY ? PLANT_GROWTH_RATE : 0);
+            grown = grown > PLANT_MAX_ENERGY ? PLANT_MAX_ENERGY : grown;
+            int age = layer->age[idx] + 1;
+            int since = layer->since_reproduction[idx] + 1;
+            since = since > SINCE_REPRODUCTION_CAP ? SINCE_REPRODUCTION_CAP : since;
+            bool survives = energy > 0 && age <= PLANT_MAX_AGE;
+
+            // Szomszédból induló szaporodás: a (x - dx, y - dy) szülő a d irányt választotta
+            int seeded = 0;
+            unsigned int inside = topology->column_mask[x] & row_mask;
+            for (int d = 0; d < 8; d++)
+            {
+                int px = topology->column[x - direction_dx[d]];
+                size_t py_row = parent_rows[direction_dy[d] + 1];
+                seeded |= (fire[py_row + px] == d) & (int)(inside >> (7 - d));
+            }
+            seeded &= energy == 0;
+
+            layer->next_energy[idx] = (unsigned char)(survives ? grown : (seeded ? PLANT_INITIAL_ENERGY : 0));
+            layer->next_age[idx] = (unsigned char)(survives ? age : 0);
+            layer->next_since_reproduction[idx] = (unsigned char)(survives ? (fire[idx] >= 0 ? 0 : since) : 0);
+        }
+
+        // A sor bittérkép-szavainak újraépítése (soronként külön szavak, így nincs versenyhelyzet)
+        for (int w = 0; w < layer->words_per_row; w++)
+        {
+            unsigned long long bits = 0;
+            int x_end = (w + 1) * 64 < width ? (w + 1) * 64 : width;
+            for (int x = w * 64; x < x_end; x++)
+                bits |= (unsigned long long)(layer->next_energy[row + x] != 0) << (x & 63);
+            layer->next_occupancy[(size_t)y * layer->words_per_row + w] = bits;
+        }
+
+        // Statisztika a még cache-ben lévő, frissen kiszámolt sorból
+        if (world->stats)
+            population_stats_record_plant_row(world->stats, &layer->next_energy[row], &layer->next_age[row], width, y);
+    }
+
+    // Pufferek cseréje
+    unsigned char *tmp = layer->energy;
+    layer->energy = layer->next_energy;
+    layer->next_energy = tmp;
+    tmp = layer->age;
+    layer->age = layer->next_age;
+    layer->next_age = tmp;
+    tmp = layer->since_reproduction;
+    layer->since_reproduction = layer->next_since_reproduction;
+    layer->next_since_reproduction = tmp;
+    unsigned long long *tmp_bits = layer->occupancy;
+    layer->occupancy = layer->next_occupancy;
+    layer->next_occupancy = tmp_bits;
+}
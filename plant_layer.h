@@ -0,0 +1,57 @@
+#ifndef PLANT_LAYER_H
+#define PLANT_LAYER_H
+
+#include <stdbool.h>
+
+#include "datatypes.h" // Szükséges a World, Coordinates típusokhoz
+
+// Sűrű növényréteg: a növények nem Entity-k, hanem cellánkénti bájtos energia/kor/szaporodás
+// tömbök és egy soronkénti foglaltsági bittérkép. A növények frissítése (növekedés, öregedés,
+// szomszédból induló szaporodás) soronkénti stencil-menet, így a növényfázis egy
+// vektorizálható celluláris automata. A növényevők közvetlenül a cellát olvassák és ürítik.
+struct PlantLayer
+{
+    int width;
+    int height;
+    int words_per_row; // 64 bites szavak száma soronként a bittérképben
+
+    unsigned char *energy;             // 0, ha a cella üres
+    unsigned char *age;
+    unsigned char *since_reproduction; // Az utolsó szaporodás óta eltelt lépések (telítődik 255-nél)
+    unsigned long long *occupancy;     // Foglaltsági bittérkép (1 bit / cella)
+
+    unsigned char *next_energy; // Dupla pufferelés a stencilhez
+    unsigned char *next_age;
+    unsigned char *next_since_reproduction;
+    unsigned long long *next_occupancy;
+
+    signed char *fire_direction; // Segédtömb: a szülő választott iránya ebben a lépésben (-1: nem szaporodik)
+};
+
+PlantLayer *plant_layer_create(int width, int height);
+void plant_layer_free(PlantLayer *layer);
+
+// Bekapcsolja a növényréteget: a meglévő PLANT entitásokat átköltözteti a rétegbe,
+// az entitáslistát tömöríti és a rácsot újraépíti. Hiba esetén hamis.
+bool plant_layer_enable(World *world);
+
+static inline bool plant_layer_occupied(const PlantLayer *layer, int x, int y)
+{
+    unsigned long long word = __atomic_load_n(&layer->occupancy[y * layer->words_per_row + (x >> 6)], __ATOMIC_RELAXED);
+    return (word >> (x & 63)) & 1ULL;
+}
+
+// Növény elhelyezése egy üres cellába (inicializálás, kézi spawnolás). Hamis, ha a cella foglalt.
+bool plant_layer_place(PlantLayer *layer, int x, int y, int energy, int age);
+// Legelés: atomikusan kiüríti a cellát. Igaz, ha ez a hívás ette meg a növényt.
+bool plant_layer_try_graze(PlantLayer *layer, int x, int y);
+// A legközelebbi (Manhattan-távolság) növény keresése a center körül, range sugarú rombuszban.
+// Tóruszon a rombusz a széleken körbefut (a sugár legfeljebb a topológia kitömése).
+bool plant_layer_find_nearest(const PlantLayer *layer, const Topology *topology, Coordinates center, int range, Coordinates *out_pos);
+// A növények száma (popcount a bittérképen).
+int plant_layer_count(const PlantLayer *layer);
+
+// A növényfázis: egy stencil-lépés a teljes rétegen.
+void plant_layer_step(World *world, int current_step_number);
+
+#endif // PLANT_LAYER_H
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "population_stats.h"
+#include "simulation_constants.h"
+#include "lifecycle_kernel.h"
+#include "species.h"
+#include "memory_accounting.h"
+
+// Szálankénti részösszeg, cache-sorhoz igazítva, hogy a szálak ne írjanak közös sorba (false sharing)
+typedef struct
+{
+    PopulationRecord values;
+} __attribute__((aligned(64))) StatsPartial;
+
+struct PopulationStats
+{
+    StatsPartial *partials;
+    int thread_capacity;
+    int width;  // A régiók kiszámításához (a lépés elején rögzítve)
+    int height;
+    int plant_layer_start; // Növényréteg: a növényfázis eleji létszám (-1: nincs réteg)
+    int current_step;
+
+    PopulationRecord current; // Az összevonás munkaterülete (csak a szimuláció szála írja)
+
+    unsigned int sequence;      // Seqlock számláló: páratlan, amíg az író dolgozik
+    PopulationRecord published; // Az utolsó teljes rekord
+};
+
+static int max_energy_for_type(int type)
+{
+    return type > EMPTY && type < ENTITY_TYPE_COUNT ? species_table[type].max_energy : 1;
+}
+
+static int max_age_for_type(int type)
+{
+    return type > EMPTY && type < ENTITY_TYPE_COUNT ? species_table[type].max_age : 1;
+}
+
+static inline int histogram_bin(int value, int max_value)
+{
+    int bin = (int)((long long)value * STATS_HISTOGRAM_BINS / (max_value + 1));
+    if (bin < 0)
+        return 0;
+    return bin < STATS_HISTOGRAM_BINS ? bin : STATS_HISTOGRAM_BINS - 1;
+}
+
+static inline int region_index(const PopulationStats *stats, int x, int y)
+{
+    int rx = (int)((long long)x * STATS_REGION_GRID / stats->width);
+    int ry = (int)((long long)y * STATS_REGION_GRID / stats->height);
+    if (rx < 0 || rx >= STATS_REGION_GRID || ry < 0 || ry >= STATS_REGION_GRID)
+        return -1;
+    return ry * STATS_REGION_GRID + rx;
+}
+
+static void reset_record(PopulationRecord *record)
+{
+    memset(record, 0, sizeof(*record));
+    record->step = -1;
+}
+
+PopulationStats *population_stats_create(void)
+{
+    PopulationStats *stats = (PopulationStats *)memory_calloc(MEMORY_STATS, 1, sizeof(PopulationStats));
+    if (!stats)
+    {
+        perror("Hiba a statisztika foglalásakor");
+        return NULL;
+    }
+    stats->plant_layer_start = -1;
+    reset_record(&stats->current);
+    reset_record(&stats->published);
+    return stats;
+}
+
+void population_stats_free(PopulationStats *stats)
+{
+    if (!stats)
+        return;
+    memory_free(MEMORY_STATS, stats->partials);
+    memory_free(MEMORY_STATS, stats);
+}
+
+bool population_stats_enable(World *world)
+{
+    if (!world)
+        return false;
+    if (!world->stats)
+        world->stats = population_stats_create();
+    return world->stats != NULL;
+}
+
+static bool ensure_thread_capacity(PopulationStats *stats, int threads)
+{
+    if (threads <= stats->thread_capacity)
+        return true;
+    void *ptr = NULL;
+    if (memory_posix_memalign(MEMORY_STATS, &ptr, 64, (size_t)threads * sizeof(StatsPartial)) != 0)
+    {
+        fprintf(stderr, "Hiba: a statisztika szálankénti részösszegeinek foglalása sikertelen.\n");
+        return false;
+    }
+    memory_free(MEMORY_STATS, stats->partials);
+    stats->partials = (StatsPartial *)ptr;
+    stats->thread_capacity = threads;
+    return true;
+}
+
+void population_stats_begin_step(PopulationStats *stats, const World *world, int current_step_number)
+{
+    stats->current_step = current_step_number;
+    stats->width = world->width;
+    stats->height = world->height;
+    stats->plant_layer_start = -1;
+    if (!ensure_thread_capacity(stats, omp_get_max_threads()))
+        stats->thread_capacity = 0;
+    memset(stats->partials, 0, (size_t)stats->thread_capacity * sizeof(StatsPartial));
+}
+
+static inline PopulationRecord *thread_partial(PopulationStats *stats)
+{
+    int thread_id = omp_get_thread_num();
+    if (thread_id >= stats->thread_capacity)
+        return NULL;
+    return &stats->partials[thread_id].values;
+}
+
+void population_stats_record_entity(PopulationStats *stats, const Entity *entity)
+{
+    PopulationRecord *partial = thread_partial(stats);
+    int type = entity->type;
+    if (!partial || type <= EMPTY || type >= ENTITY_TYPE_COUNT)
+        return;
+
+    partial->count[type]++;
+    partial->energy_sum[type] += entity->energy;
+    partial->age_sum[type] += entity->age;
+    partial->energy_histogram[type][histogram_bin(entity->energy, max_energy_for_type(type))]++;
+    partial->age_histogram[type][histogram_bin(entity->age, max_age_for_type(type))]++;
+    if (entity->age == 0)
+        partial->births[type]++;
+    // Aki ebben a lépésben evett, az egy zsákmányt fogyasztott el
+    if (entity->last_eating_step == stats->current_step && !species_is_autotroph(type))
+        partial->predations[species_table[type].food]++;
+    int region = region_index(stats, entity->position.x, entity->position.y);
+    if (region >= 0)
+        partial->region_occupancy[region]++;
+}
+
+void population_stats_record_plant_row(PopulationStats *stats, const unsigned char *energy, const unsigned char *age,
+                                       int width, int y)
+{
+    PopulationRecord *partial = thread_partial(stats);
+    if (!partial)
+        return;
+
+    for (int x = 0; x < width; x++)
+    {
+        if (!energy[x])
+            continue;
+        partial->count[PLANT]++;
+        partial->energy_sum[PLANT] += energy[x];
+        partial->age_sum[PLANT] += age[x];
+        partial->energy_histogram[PLANT][histogram_bin(energy[x], species_table[PLANT].max_energy)]++;
+        partial->age_histogram[PLANT][histogram_bin(age[x], species_table[PLANT].max_age)]++;
+        if (age[x] == 0)
+            partial->births[PLANT]++;
+        int region = region_index(stats, x, y);
+        if (region >= 0)
+            partial->region_occupancy[region]++;
+    }
+}
+
+void population_stats_note_plant_layer_start(PopulationStats *stats, int plant_count)
+{
+    stats->plant_layer_start = plant_count;
+}
+
+void population_stats_end_step(PopulationStats *stats, const World *world)
+{
+    PopulationRecord *record = &stats->current;
+    memset(record, 0, sizeof(*record));
+    record->step = stats->current_step;
+
+    for (int t = 0; t < stats->thread_capacity; t++)
+    {
+        const PopulationRecord *partial = &stats->partials[t].values;
+        for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        {
+            record->count[type] += partial->count[type];
+            record->energy_sum[type] += partial->energy_sum[type];
+            record->age_sum[type] += partial->age_sum[type];
+            record->births[type] += partial->births[type];
+            record->predations[type] += partial->predations[type];
+            for (int bin = 0; bin < STATS_HISTOGRAM_BINS; bin++)
+            {
+                record->energy_histogram[type][bin] += partial->energy_histogram[type][bin];
+                record->age_histogram[type][bin] += partial->age_histogram[type][bin];
+            }
+        }
+        for (int region = 0; region < STATS_REGION_GRID * STATS_REGION_GRID; region++)
+            record->region_occupancy[region] += partial->region_occupancy[region];
+    }
+
+    // Halálozás: az elő-menet előtti létszám és a túlélők különbsége (a megevettek a túlélők között vannak)
+    const LifecycleBuffers *lifecycle = world->lifecycle;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        record->deaths[type] = lifecycle->population[type] - lifecycle->survivor_count[type];
+    if (stats->plant_layer_start >= 0)
+    {
+        // Növényréteg: a fázis eleji (legelés utáni) létszámból nem túlélők száma
+        int survivors = record->count[PLANT] - record->births[PLANT];
+        record->deaths[PLANT] = stats->plant_layer_start - survivors;
+    }
+
+    // Seqlock publikálás: páratlan számláló jelzi az olvasóknak, hogy írás folyik
+    unsigned int sequence = stats->sequence;
+    __atomic_store_n(&stats->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&stats->published, record, sizeof(*record));
+    __atomic_store_n(&stats->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool population_stats_read(const PopulationStats *stats, PopulationRecord *out_record)
+{
+    unsigned int before, after;
+    do
+    {
+        before = __atomic_load_n(&stats->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1U)
+            continue; // Az író éppen dolgozik, újrapróbáljuk
+        memcpy(out_record, &stats->published, sizeof(*out_record));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&stats->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1U) || before != after);
+    return out_record->step >= 0;
+}
@@ -0,0 +1,54 @@
+#ifndef POPULATION_STATS_H
+#define POPULATION_STATS_H
+
+#include <stdbool.h>
+
+#include "datatypes.h"        // Szükséges a World, Entity típusokhoz
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+
+// Inkrementális populációs statisztika. A számlálók a meglévő fázisciklusokban (véglegesítés,
+// növényréteg stencil) gyűlnek szálankénti részösszegekbe, extra menet nélkül; a lépés végén
+// ezek összevonása egy lépésenkénti rekordot ad, amit seqlock-kal publikálunk, így egy
+// megfigyelő (pl. másik szál) a szimuláció blokkolása nélkül olvashatja.
+
+#define STATS_HISTOGRAM_BINS 16 // Energia- és kor-hisztogram rekeszek száma típusonként
+#define STATS_REGION_GRID 8     // A térbeli foglaltság STATS_REGION_GRID x STATS_REGION_GRID régióra bontva
+
+typedef struct
+{
+    int step; // A lépés sorszáma (-1: még nincs publikált rekord)
+
+    int count[ENTITY_TYPE_COUNT];      // Létszám a lépés végén
+    long long energy_sum[ENTITY_TYPE_COUNT];
+    long long age_sum[ENTITY_TYPE_COUNT];
+    int births[ENTITY_TYPE_COUNT];     // Ebben a lépésben született egyedek
+    int deaths[ENTITY_TYPE_COUNT];     // Kor vagy energia miatt elpusztult egyedek
+    int predations[ENTITY_TYPE_COUNT]; // Megevett egyedek a zsákmány típusa szerint
+
+    int energy_histogram[ENTITY_TYPE_COUNT][STATS_HISTOGRAM_BINS]; // 0..típus max energiája
+    int age_histogram[ENTITY_TYPE_COUNT][STATS_HISTOGRAM_BINS];    // 0..típus max kora
+    int region_occupancy[STATS_REGION_GRID * STATS_REGION_GRID];   // Élőlények száma régiónként (sorfolytonosan)
+} PopulationRecord;
+
+PopulationStats *population_stats_create(void);
+void population_stats_free(PopulationStats *stats);
+
+// Bekapcsolja a statisztikát a világra. Hiba esetén hamis.
+bool population_stats_enable(World *world);
+
+// A lépés elején (soros részben): a szálankénti részösszegek nullázása.
+void population_stats_begin_step(PopulationStats *stats, const World *world, int current_step_number);
+// Véglegesítéskor (bármely szálról): egy következő állapotbeli entitás hozzáadása.
+void population_stats_record_entity(PopulationStats *stats, const Entity *entity);
+// Növényréteg: egy frissen kiszámolt sor hozzáadása (a stencil menetből), illetve a fázis eleji létszám.
+void population_stats_record_plant_row(PopulationStats *stats, const unsigned char *energy, const unsigned char *age,
+                                       int width, int y);
+void population_stats_note_plant_layer_start(PopulationStats *stats, int plant_count);
+// A lépés végén (soros részben): összevonás és publikálás.
+void population_stats_end_step(PopulationStats *stats, const World *world);
+
+// Az utolsó publikált rekord kiolvasása (bármely szálról, nem blokkolja a szimulációt).
+// Hamis, ha még nincs publikált rekord.
+bool population_stats_read(const PopulationStats *stats, PopulationRecord *out_record);
+
+#endif // POPULATION_STATS_H
@@ -0,0 +1,182 @@
+#!/bin/sh
+# Skálázási vizsgálat: a menü nélküli szimulátort több szálszámmal és affinitás-beállítással
+# futtatja, erős (rögzített világ) és gyenge (a szálszámmal arányos területű világ) skálázásban.
+# Fázisonként (teljes lépés, ragadozók, növényevők, növények) gyorsulást, hatékonyságot és a
+# soros hányad becslését adja: erős skálázásnál Amdahl-illesztést, gyengénél Gustafson-illesztést
+# (legkisebb négyzetek a legkisebb szálszámhoz viszonyítva), pontonként Karp-Flatt metrikát.
+#
+# Használat: ./scaling.sh [strong|weak|both]   (alapértelmezés: both)
+# Környezeti változók:
+#   SCALING_THREADS     szálszámok (alapértelmezés: "1 2 4 8")
+#   SCALING_BIND        OMP_PROC_BIND értékek, "false" esetén kötés nélkül (alapértelmezés: "close spread");
+#                       kötéskor OMP_PLACES=cores
+#   SCALING_SIZE        világméret a legkisebb szálszámhoz (alapértelmezés: 200x100)
+#   SCALING_ENTITIES    kezdeti létszámok P,H,C a legkisebb szálszámhoz (alapértelmezés: 2000,400,40)
+#   SCALING_STEPS       lépésszám futásonként (alapértelmezés: 100)
+#   SCALING_REPEAT      ismétlések; a legkisebb lépésidejű futás számít (alapértelmezés: 3)
+#   SCALING_ARGS        további kapcsolók, pl. "--deterministic" vagy "--plant-layer --bulk-init"
+#   SCALING_EFFICIENCY  az ajánlott szálszám minimális hatékonysága (alapértelmezés: 0.7)
+#   SCALING_BINARY      a szimulátor (alapértelmezés: ./ecosystem_simulator)
+#
+# Gyenge skálázásnál a világ magassága és a kezdeti létszámok a szálszám/legkisebb szálszám
+# arányában nőnek, így a sűrűség és a szálankénti terület állandó.
+# Kimenet: scaling_results.csv (minden mért futás) és összegzés a stdout-ra.
+
+BINARY=${SCALING_BINARY:-./ecosystem_simulator}
+THREADS=${SCALING_THREADS:-1 2 4 8}
+BINDS=${SCALING_BIND:-close spread}
+SIZE=${SCALING_SIZE:-200x100}
+ENTITIES=${SCALING_ENTITIES:-2000,400,40}
+STEPS=${SCALING_STEPS:-100}
+REPEAT=${SCALING_REPEAT:-3}
+EFFICIENCY=${SCALING_EFFICIENCY:-0.7}
+RESULTS=scaling_results.csv
+SEED=42
+MODES=${1:-both}
+
+case "$MODES" in
+both) MODES="strong weak" ;;
+strong | weak) ;;
+*)
+    echo "Használat: $0 [strong|weak|both]" >&2
+    exit 1
+    ;;
+esac
+if [ ! -x "$BINARY" ]; then
+    echo "Hiba: a szimulátor nem található: $BINARY" >&2
+    exit 1
+fi
+
+width=${SIZE%x*}
+height=${SIZE#*x}
+base_threads=$(echo $THREADS | tr ' ' '\n' | sort -n | head -n 1)
+
+# A --bench-json sor egy mezője
+field() {
+    echo "$1" | sed -n "s/.*\"$2\": \([^,}]*\).*/\1/p"
+}
+
+echo "mode,bind,threads,width,height,steps_per_sec,step_ms,carnivore_ms,herbivore_ms,plant_ms" >"$RESULTS"
+for mode in $MODES; do
+    for bind in $BINDS; do
+        for threads in $THREADS; do
+            run_height=$height
+            run_entities=$ENTITIES
+            if [ "$mode" = weak ]; then
+                run_height=$((height * threads / base_threads))
+                run_entities=$(echo "$ENTITIES" | awk -F, -v r="$threads" -v b="$base_threads" \
+                    '{ printf "%d,%d,%d", $1 * r / b, $2 * r / b, $3 * r / b }')
+            fi
+            best=""
+            i=0
+            while [ "$i" -lt "$REPEAT" ]; do
+                i=$((i + 1))
+                if [ "$bind" = false ]; then
+                    # shellcheck disable=SC2086 # a SCALING_ARGS-t szándékosan szavakra bontjuk
+                    line=$(OMP_NUM_THREADS=$threads OMP_PROC_BIND=false "$BINARY" --headless --seed "$SEED" \
+                        --steps "$STEPS" --size "${width}x${run_height}" --entities "$run_entities" \
+                        ${SCALING_ARGS:-} --bench-json scaling 2>/dev/null)
+                else
+                    # shellcheck disable=SC2086
+                    line=$(OMP_NUM_THREADS=$threads OMP_PROC_BIND=$bind OMP_PLACES=cores "$BINARY" --headless \
+                        --seed "$SEED" --steps "$STEPS" --size "${width}x${run_height}" --entities "$run_entities" \
+                        ${SCALING_ARGS:-} --bench-json scaling 2>/dev/null)
+                fi
+                if [ -z "$line" ]; then
+                    echo "Hiba: sikertelen futás ($mode, $bind, $threads szál)" >&2
+                    exit 1
+                fi
+                if [ -z "$best" ] || awk -v a="$(field "$line" step_ms)" -v b="$(field "$best" step_ms)" 'BEGIN { exit !(a < b) }'; then
+                    best=$line
+                fi
+            done
+            echo "$mode,$bind,$threads,$width,$run_height,$(field "$best" steps_per_sec),$(field "$best" step_ms),$(field "$best" carnivore_ms),$(field "$best" herbivore_ms),$(field "$best" plant_ms)" >>"$RESULTS"
+            echo "== $mode $bind $threads szál: $(field "$best" step_ms) ms/lépés" >&2
+        done
+    done
+done
+echo "Eredmények: $RESULTS" >&2
+
+# Kiértékelés: csoportonként (mode, bind) a legkisebb szálszámhoz viszonyítva
+awk -F, -v min_efficiency="$EFFICIENCY" '
+NR == 1 { next }
+{
+    key = $1 " " $2
+    if (!(key in seen)) {
+        seen[key] = 1
+        order[++groups] = key
+    }
+    n = ++count[key]
+    threads[key, n] = $3
+    size[key, n] = $4 "x" $5
+    for (p = 0; p < 4; p++)
+        time[key, n, p] = $(7 + p)
+}
+END {
+    split("step carnivore herbivore plant", names, " ") # A JSON mezőnevek, mint a latency összegzésben
+    for (g = 1; g <= groups; g++) {
+        key = order[g]
+        split(key, parts, " ")
+        weak = parts[1] == "weak"
+        printf "\n%s skálázás, OMP_PROC_BIND=%s\n", weak ? "Gyenge" : "Erős", parts[2]
+        printf "   szál      világ" # A többbájtos fejléc kézzel igazítva (%7d %10s)
+        for (p = 0; p < 4; p++)
+            printf " | %-9s %9s %5s %5s", names[p + 1], "ms", weak ? "s-gy." : "gyor.", "hat."
+        printf " | %s\n", "Karp-Flatt"
+        base = threads[key, 1]
+        recommended = base
+        for (i = 1; i <= count[key]; i++) {
+            r = threads[key, i] / base
+            printf "%7d %10s", threads[key, i], size[key, i]
+            for (p = 0; p < 4; p++) {
+                t = time[key, i, p]
+                t0 = time[key, 1, p]
+                ratio = t > 0 ? t0 / t : 0
+                # Erős: gyorsulás = T0/Tn, hatékonyság = gyorsulás / r
+                # Gyenge: hatékonyság = T0/Tn, skálázott gyorsulás = r * hatékonyság
+                speedup = weak ? r * ratio : ratio
+                efficiency = weak ? ratio : (r > 0 ? ratio / r : 0)
+                printf " | %-9s %9.3f %5.2f %5.2f", "", t, speedup, efficiency
+                if (p == 0) {
+                    step_speedup = speedup
+                    if (efficiency >= min_efficiency && threads[key, i] > recommended)
+                        recommended = threads[key, i]
+                }
+            }
+            # Karp-Flatt: a mért gyorsulásból visszaszámolt soros hányad (r > 1 esetén)
+            if (r > 1 && step_speedup > 0)
+                printf " | %.3f\n", (1 / step_speedup - 1 / r) / (1 - 1 / r)
+            else
+                printf " | -\n"
+        }
+        # Soros hányad illesztése fázisonként, legkisebb négyzetekkel
+        #   Amdahl (erős):     Tn/T0 = s + (1 - s) / r
+        #   Gustafson (gyenge): S(r) = r - s (r - 1)
+        printf "%s soros hányad:", weak ? "Gustafson" : "Amdahl"
+        for (p = 0; p < 4; p++) {
+            numerator = 0
+            denominator = 0
+            for (i = 1; i <= count[key]; i++) {
+                r = threads[key, i] / base
+                t = time[key, i, p]
+                t0 = time[key, 1, p]
+                if (r <= 1 || t <= 0 || t0 <= 0)
+                    continue
+                if (weak) {
+                    s_r = r * t0 / t
+                    numerator += (r - s_r) * (r - 1)
+                    denominator += (r - 1) * (r - 1)
+                } else {
+                    x = 1 / r
+                    numerator += (t / t0 - x) * (1 - x)
+                    denominator += (1 - x) * (1 - x)
+                }
+            }
+            if (denominator > 0)
+                printf " %s=%.3f", names[p + 1], numerator / denominator
+            else
+                printf " %s=-", names[p + 1]
+        }
+        printf "\nAjánlott szálszám (a lépés hatékonysága >= %.2f): %d\n", min_efficiency, recommended
+    }
+}' "$RESULTS"
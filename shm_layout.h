@@ -0,0 +1,64 @@
+#ifndef SHM_LAYOUT_H
+#define SHM_LAYOUT_H
+
+#include <stdint.h>
+
+// A világállapot osztott memóriás (POSIX shm) publikációjának bináris elrendezése. A szimulátor
+// (shm_publisher.c) és a külső olvasók (pl. shm_reader.c) közös szerződése; csak rögzített
+// szélességű típusok, mutatók nélkül, így más nyelvből is leképezhető.
+//
+// A szegmens: ShmHeader, majd SHM_SLOT_COUNT darab, slot_size méretű rés. Az író mindig a nem
+// legutóbbi résbe ír, a rés generációs számlálója (seqlock) az írás alatt páratlan. Az olvasó
+// a latest_slot rését olvassa: ha a generáció páratlan, vagy az olvasás előtt és után eltér,
+// az olvasás szakadt (közben felülírták), újra kell próbálni.
+
+#define SHM_LAYOUT_MAGIC 0x4d534345u // "ECSM" (little endian)
+#define SHM_LAYOUT_VERSION 1
+#define SHM_SLOT_COUNT 2
+#define SHM_EMPTY_CELL (-1) // A cells[] értéke üres cellánál
+#define SHM_ALIGNMENT 64    // A rések és a tömbök kezdete cache-sorhoz igazítva
+
+// Egy publikált entitás (a belső Entity struktúrától független, verziózott elrendezés)
+typedef struct
+{
+    int32_t id;
+    int32_t type; // EntityType: 1 növény, 2 növényevő, 3 ragadozó
+    int32_t x;
+    int32_t y;
+    int32_t energy;
+    int32_t age;
+} ShmEntity;
+
+// Egy rés fejléce; utána a rés elejétől számított eltolásokon a tömbök
+typedef struct
+{
+    uint32_t generation;  // Seqlock: páratlan, amíg az író dolgozik
+    int32_t step;         // A publikált állapotot létrehozó lépés sorszáma
+    int32_t entity_count; // Az entities[] érvényes elemszáma
+    int32_t plant_layer;  // 1: a plants[] érvényes (növényréteges mód), 0: a növények entitások
+} ShmSlotHeader;
+
+typedef struct
+{
+    uint32_t magic;       // SHM_LAYOUT_MAGIC
+    uint32_t version;     // SHM_LAYOUT_VERSION; eltérő verziót az olvasó ne értelmezzen
+    uint32_t header_size; // sizeof(ShmHeader), az első rés eltolása
+    int32_t width;
+    int32_t height;
+    int32_t entity_capacity;  // Az entities[] helye résenként
+    uint64_t slot_size;       // Egy rés mérete bájtban (fejléccel)
+    uint64_t cells_offset;    // int32_t cells[height][width]: az entities[] indexe vagy SHM_EMPTY_CELL
+    uint64_t plants_offset;   // uint8_t plants[height][width]: növényenergia (csak plant_layer esetén)
+    uint64_t entities_offset; // ShmEntity entities[entity_capacity]
+    uint32_t latest_slot;     // A legutóbb befejezett rés indexe
+    uint32_t publish_count;   // Befejezett publikációk száma (0: még nincs érvényes rés)
+    int32_t writer_pid;       // A szimulátor folyamatazonosítója
+    uint32_t closed;          // 1, ha az író leállt (a szegmens neve ekkor már törölve)
+} ShmHeader;
+
+static inline unsigned char *shm_slot(void *base, const ShmHeader *header, uint32_t slot)
+{
+    return (unsigned char *)base + header->header_size + (uint64_t)slot * header->slot_size;
+}
+
+#endif // SHM_LAYOUT_H
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#include "shm_publisher.h"
+#include "shm_layout.h"
+#include "plant_layer.h"
+#include "memory_accounting.h"
+
+struct ShmPublisher
+{
+    char name[256]; // A szegmens neve '/' előtaggal
+    int interval;
+    void *base;     // A leképezett szegmens (NULL: még nincs világhoz rendelve)
+    size_t size;
+};
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + SHM_ALIGNMENT - 1) & ~(uint64_t)(SHM_ALIGNMENT - 1);
+}
+
+ShmPublisher *shm_publisher_start(const char *name, int interval)
+{
+    ShmPublisher *publisher = (ShmPublisher *)memory_calloc(MEMORY_PUBLISHER, 1, sizeof(ShmPublisher));
+    if (!publisher)
+    {
+        perror("Hiba az osztott memóriás publikáló foglalásakor");
+        return NULL;
+    }
+    snprintf(publisher->name, sizeof(publisher->name), "%s%s", name[0] == '/' ? "" : "/", name);
+    publisher->interval = interval > 0 ? interval : 1;
+    return publisher;
+}
+
+// A meglévő leképezés lezárása; az olvasók a closed jelzésből tudják, hogy az író elment
+static void unmap_segment(ShmPublisher *publisher)
+{
+    if (!publisher->base)
+        return;
+    ShmHeader *header = (ShmHeader *)publisher->base;
+    __atomic_store_n(&header->closed, 1, __ATOMIC_RELEASE);
+    munmap(publisher->base, publisher->size);
+    memory_release(MEMORY_PUBLISHER, publisher->size);
+    shm_unlink(publisher->name);
+    publisher->base = NULL;
+    publisher->size = 0;
+}
+
+void shm_publisher_stop(ShmPublisher *publisher)
+{
+    if (!publisher)
+        return;
+    unmap_segment(publisher);
+    memory_free(MEMORY_PUBLISHER, publisher);
+}
+
+bool shm_publisher_attach(ShmPublisher *publisher, World *world)
+{
+    if (!publisher || !world)
+        return false;
+    if (world->chunks)
+    {
+        // A szegmens W*H-s cellatömböt tart, és a publikálás minden cellát bejár: a ritka tárolás célját rontaná
+        fprintf(stderr, "Hiba: az osztott memóriás publikálás ritka rácstárolással nem kapcsolható be.\n");
+        return false;
+    }
+    world->publisher = publisher;
+
+    ShmHeader layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.magic = SHM_LAYOUT_MAGIC;
+    layout.version = SHM_LAYOUT_VERSION;
+    layout.header_size = (uint32_t)align_up(sizeof(ShmHeader));
+    layout.width = world->width;
+    layout.height = world->height;
+    layout.entity_capacity = world->entity_capacity;
+    uint64_t cells = (uint64_t)world->width * world->height;
+    layout.cells_offset = align_up(sizeof(ShmSlotHeader));
+    layout.plants_offset = align_up(layout.cells_offset + cells * sizeof(int32_t));
+    layout.entities_offset = align_up(layout.plants_offset + cells);
+    layout.slot_size = align_up(layout.entities_offset + (uint64_t)world->entity_capacity * sizeof(ShmEntity));
+    layout.writer_pid = (int32_t)getpid();
+
+    // Azonos méretű világhoz (menüből újraindítva) a meglévő szegmens marad
+    if (publisher->base)
+    {
+        const ShmHeader *current = (const ShmHeader *)publisher->base;
+        if (current->width == layout.width && current->height == layout.height &&
+            current->entity_capacity == layout.entity_capacity)
+            return true;
+        unmap_segment(publisher);
+    }
+
+    size_t size = layout.header_size + SHM_SLOT_COUNT * layout.slot_size;
+    int fd = shm_open(publisher->name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror("Hiba az osztott memória szegmens létrehozásakor");
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        perror("Hiba az osztott memória szegmens méretezésekor");
+        close(fd);
+        shm_unlink(publisher->name);
+        return false;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        perror("Hiba az osztott memória szegmens leképezésekor");
+        shm_unlink(publisher->name);
+        return false;
+    }
+    memcpy(base, &layout, sizeof(layout)); // A rések generációi a ftruncate után nullák
+    memory_note_mapped(MEMORY_PUBLISHER, size);
+    publisher->base = base;
+    publisher->size = size;
+    return true;
+}
+
+void shm_publisher_publish(ShmPublisher *publisher, const World *world, int step)
+{
+    if (!publisher || !publisher->base || step % publisher->interval != 0)
+        return;
+    ShmHeader *header = (ShmHeader *)publisher->base;
+    if (header->width != world->width || header->height != world->height || world->entity_count > header->entity_capacity)
+        return;
+
+    uint32_t slot_index = __atomic_load_n(&header->publish_count, __ATOMIC_RELAXED) == 0 ? 0 : header->latest_slot ^ 1;
+    unsigned char *slot = shm_slot(publisher->base, header, slot_index);
+    ShmSlotHeader *slot_header = (ShmSlotHeader *)slot;
+    int32_t *cells = (int32_t *)(slot + header->cells_offset);
+    uint8_t *plants = slot + header->plants_offset;
+    ShmEntity *entities = (ShmEntity *)(slot + header->entities_offset);
+
+    // Seqlock: páratlan generáció az írás idejére
+    uint32_t generation = slot_header->generation;
+    __atomic_store_n(&slot_header->generation, generation + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot_header->step = step;
+    slot_header->entity_count = world->entity_count;
+    slot_header->plant_layer = world->plants != NULL;
+
+    const Entity *base_entity = world->entities;
+    int width = world->width;
+#pragma omp parallel
+    {
+#pragma omp for schedule(static) nowait
+        for (int i = 0; i < world->entity_count; i++)
+        {
+            const Entity *entity = &world->entities[i];
+            ShmEntity *out = &entities[i];
+            out->id = entity->id;
+            out->type = entity->type;
+            out->x = entity->position.x;
+            out->y = entity->position.y;
+            out->energy = entity->energy;
+            out->age = entity->age;
+        }
+        // Rács: a cella entitásának indexe a publikált entities[] tömbben
+#pragma omp for schedule(static)
+        for (int y = 0; y < world->height; y++)
+        {
+            const Cell *row = world->grid[y];
+            int32_t *out = &cells[(size_t)y * width];
+            for (int x = 0; x < width; x++)
+                out[x] = row[x].entity ? (int32_t)(row[x].entity - base_entity) : SHM_EMPTY_CELL;
+            if (world->plants)
+                memcpy(&plants[(size_t)y * width], &world->plants->energy[(size_t)y * width], (size_t)width);
+        }
+    }
+
+    __atomic_store_n(&slot_header->generation, generation + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->latest_slot, slot_index, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->publish_count, header->publish_count + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,23 @@
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+#include <stdbool.h>
+
+#include "datatypes.h" // Szükséges a World típushoz
+
+// A világállapot publikálása POSIX osztott memóriába (elrendezés: shm_layout.h) külső
+// megjelenítőknek és elemzőknek. A simulate_step a pufferek cseréje után hív; a publikálás
+// a két rés közül a nem legutóbbiba ír, így a futó olvasók sosem blokkolják a szimulációt.
+
+// A publikáló létrehozása (/NAME szegmensnév; interval: ennyi lépésenként publikál). Hiba esetén NULL.
+ShmPublisher *shm_publisher_start(const char *name, int interval);
+// A szegmens lezárása (closed jelzés), leképezésének megszüntetése és a név törlése.
+void shm_publisher_stop(ShmPublisher *publisher);
+
+// A publikáló hozzárendelése egy világhoz; a szegmenst a világ méretére (újra)méretezi. Hiba esetén hamis.
+bool shm_publisher_attach(ShmPublisher *publisher, World *world);
+
+// A pufferek cseréje után: az aktuális rács és entitáslista publikálása (ha esedékes).
+void shm_publisher_publish(ShmPublisher *publisher, const World *world, int step);
+
+#endif // SHM_PUBLISHER_H
@@ -0,0 +1,216 @@
+// Referencia olvasó a szimulátor osztott memóriás publikációjához (elrendezés: shm_layout.h).
+// Csak olvasásra képezi le a szegmenst, a legutóbbi rést helyben (másolás nélkül) dolgozza fel,
+// és a rés generációs számlálójával ismeri fel a szakadt olvasást.
+//
+// Használat: ecosim_shm_reader NAME [--watch MS] [--map]
+//   --watch MS  MS ezredmásodpercenként új összegzés, amíg a szimulátor fut
+//   --map       a rács bal felső sarkának karakteres képe (. üres, * növény, H, C)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm_layout.h"
+
+#define MAP_MAX_COLUMNS 120
+#define MAP_MAX_ROWS 50
+#define MAX_READ_ATTEMPTS 100
+
+typedef struct
+{
+    int32_t step;
+    int32_t entity_count;
+    int counts[4]; // Típusonként (a növényréteg növényei a plants[]-ből)
+    int torn_retries;
+    char map[MAP_MAX_ROWS][MAP_MAX_COLUMNS + 1];
+    int map_rows;
+} Snapshot;
+
+static void sleep_ms(int ms)
+{
+    struct timespec delay = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&delay, NULL);
+}
+
+// A rés feldolgozása helyben; a hívó a generációval ellenőrzi, hogy közben nem írták-e felül
+static void summarize_slot(const ShmHeader *header, const unsigned char *slot, bool with_map, Snapshot *out)
+{
+    const ShmSlotHeader *slot_header = (const ShmSlotHeader *)slot;
+    const int32_t *cells = (const int32_t *)(slot + header->cells_offset);
+    const uint8_t *plants = slot + header->plants_offset;
+    const ShmEntity *entities = (const ShmEntity *)(slot + header->entities_offset);
+
+    out->step = slot_header->step;
+    out->entity_count = slot_header->entity_count;
+    if (out->entity_count < 0 || out->entity_count > header->entity_capacity)
+        out->entity_count = 0; // Szakadt fejléc; a generáció-ellenőrzés eldobja
+    memset(out->counts, 0, sizeof(out->counts));
+    for (int i = 0; i < out->entity_count; i++)
+    {
+        int type = entities[i].type;
+        if (type > 0 && type < 4)
+            out->counts[type]++;
+    }
+    size_t cell_count = (size_t)header->width * header->height;
+    if (slot_header->plant_layer)
+    {
+        for (size_t i = 0; i < cell_count; i++)
+            out->counts[1] += plants[i] != 0;
+    }
+
+    out->map_rows = 0;
+    if (!with_map)
+        return;
+    int rows = header->height < MAP_MAX_ROWS ? header->height : MAP_MAX_ROWS;
+    int columns = header->width < MAP_MAX_COLUMNS ? header->width : MAP_MAX_COLUMNS;
+    static const char symbols[4] = {'.', '*', 'H', 'C'};
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < columns; x++)
+        {
+            size_t cell = (size_t)y * header->width + x;
+            int32_t index = cells[cell];
+            char symbol = '.';
+            if (index >= 0 && index < out->entity_count && entities[index].type > 0 && entities[index].type < 4)
+                symbol = symbols[entities[index].type];
+            else if (slot_header->plant_layer && plants[cell])
+                symbol = '*';
+            out->map[y][x] = symbol;
+        }
+        out->map[y][columns] = '\0';
+    }
+    out->map_rows = rows;
+}
+
+// Konzisztens pillanatkép a legutóbbi résből. Hamis, ha még nincs publikáció, vagy az
+// olvasás MAX_READ_ATTEMPTS próbálkozás után is szakadt.
+static bool read_snapshot(const ShmHeader *header, const void *base, bool with_map, Snapshot *out)
+{
+    out->torn_retries = 0;
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+    {
+        if (__atomic_load_n(&header->publish_count, __ATOMIC_ACQUIRE) == 0)
+            return false;
+        uint32_t slot_index = __atomic_load_n(&header->latest_slot, __ATOMIC_ACQUIRE);
+        const unsigned char *slot = shm_slot((void *)base, header, slot_index % SHM_SLOT_COUNT);
+        const ShmSlotHeader *slot_header = (const ShmSlotHeader *)slot;
+
+        uint32_t before = __atomic_load_n(&slot_header->generation, __ATOMIC_ACQUIRE);
+        if (before & 1)
+        {
+            out->torn_retries++;
+            continue;
+        }
+        summarize_slot(header, slot, with_map, out);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t after = __atomic_load_n(&slot_header->generation, __ATOMIC_RELAXED);
+        if (before == after)
+            return true;
+        out->torn_retries++;
+    }
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Használat: %s NAME [--watch MS] [--map]\n", argv[0]);
+        return 1;
+    }
+    char name[256];
+    snprintf(name, sizeof(name), "%s%s", argv[1][0] == '/' ? "" : "/", argv[1]);
+    int watch_ms = 0;
+    bool with_map = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+            watch_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--map") == 0)
+            with_map = true;
+        else
+        {
+            fprintf(stderr, "Ismeretlen kapcsoló: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        perror("Hiba az osztott memória szegmens megnyitásakor");
+        return 1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ShmHeader))
+    {
+        fprintf(stderr, "Hiba: a szegmens túl kicsi vagy nem olvasható.\n");
+        close(fd);
+        return 1;
+    }
+    void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        perror("Hiba az osztott memória szegmens leképezésekor");
+        return 1;
+    }
+
+    const ShmHeader *header = (const ShmHeader *)base;
+    if (header->magic != SHM_LAYOUT_MAGIC || header->version != SHM_LAYOUT_VERSION ||
+        header->header_size < sizeof(ShmHeader) ||
+        header->header_size + SHM_SLOT_COUNT * header->slot_size > (uint64_t)info.st_size)
+    {
+        fprintf(stderr, "Hiba: ismeretlen szegmens formátum (magic %08x, verzió %u).\n", header->magic, header->version);
+        munmap(base, (size_t)info.st_size);
+        return 1;
+    }
+    printf("szegmens %s: %dx%d, kapacitás %d entitás, író pid %d\n", name, header->width, header->height,
+           header->entity_capacity, header->writer_pid);
+
+    Snapshot *snapshot = (Snapshot *)malloc(sizeof(Snapshot));
+    if (!snapshot)
+    {
+        perror("Hiba a pillanatkép foglalásakor");
+        munmap(base, (size_t)info.st_size);
+        return 1;
+    }
+    int last_step = -1;
+    do
+    {
+        if (read_snapshot(header, base, with_map, snapshot))
+        {
+            if (snapshot->step != last_step)
+            {
+                printf("step=%d publications=%u entities=%d plants=%d herbivores=%d carnivores=%d torn_retries=%d\n",
+                       snapshot->step, __atomic_load_n(&header->publish_count, __ATOMIC_ACQUIRE), snapshot->entity_count,
+                       snapshot->counts[1], snapshot->counts[2], snapshot->counts[3], snapshot->torn_retries);
+                for (int y = 0; y < snapshot->map_rows; y++)
+                    printf("%s\n", snapshot->map[y]);
+                fflush(stdout);
+                last_step = snapshot->step;
+            }
+        }
+        else if (!watch_ms)
+        {
+            fprintf(stderr, "Nincs konzisztens publikált állapot.\n");
+        }
+        if (__atomic_load_n(&header->closed, __ATOMIC_ACQUIRE))
+        {
+            printf("a szimulátor leállt\n");
+            break;
+        }
+        if (watch_ms)
+            sleep_ms(watch_ms);
+    } while (watch_ms);
+
+    free(snapshot);
+    munmap(base, (size_t)info.st_size);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <omp.h>
+
+#include "sim_random.h"
+
+// Szálanként külön folyam-állapot (threadprivate), így a párhuzamos ciklusokban
+// nincs szükség szinkronizációra.
+typedef struct
+{
+    bool active;
+    unsigned long long state;
+} RandomStream;
+
+static RandomStream thread_stream = {false, 0};
+#pragma omp threadprivate(thread_stream)
+
+unsigned long long sim_random_mix64(unsigned long long value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+void sim_random_begin_stream(unsigned long long seed, int step, int phase, int entity_id)
+{
+    // A kulcs összetevőit egymás után keverjük, hogy a szomszédos ID-k/lépések folyamai függetlenek legyenek.
+    unsigned long long key = sim_random_mix64(seed + 0x9e3779b97f4a7c15ULL);
+    key = sim_random_mix64(key ^ (unsigned long long)(unsigned int)step);
+    key = sim_random_mix64(key ^ ((unsigned long long)(unsigned int)phase << 32));
+    key = sim_random_mix64(key ^ (unsigned long long)(unsigned int)entity_id);
+
+    thread_stream.state = key;
+    thread_stream.active = true;
+}
+
+void sim_random_end_stream(void)
+{
+    thread_stream.active = false;
+}
+
+int sim_rand(void)
+{
+    if (!thread_stream.active)
+    {
+        return rand();
+    }
+
+    thread_stream.state += 0x9e3779b97f4a7c15ULL;
+    return (int)(sim_random_mix64(thread_stream.state) >> 33); // felső 31 bit
+}
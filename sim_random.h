@@ -0,0 +1,23 @@
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H
+
+// Véletlenszám-forrás a szimulációhoz.
+// Alapesetben a C könyvtári rand()-ot használja. Determinisztikus módban minden entitás
+// lépésenként saját, számláló alapú (splitmix64) folyamot kap, amely csak a seed-től,
+// a lépésszámtól, a fázistól és az entitás ID-jától függ - a szálak számától és
+// ütemezésétől nem.
+
+#define SIM_RAND_MAX 0x7fffffff
+
+// Az aktuális szálon elindít egy entitáshoz kötött determinisztikus folyamot.
+void sim_random_begin_stream(unsigned long long seed, int step, int phase, int entity_id);
+// Lezárja az aktuális szál folyamát; ezután a sim_rand() ismét a rand()-ot használja.
+void sim_random_end_stream(void);
+
+// Egész véletlenszám a [0, SIM_RAND_MAX] tartományban.
+int sim_rand(void);
+
+// Általános 64 bites keverőfüggvény (splitmix64 véglépése), hash-ekhez is használható.
+unsigned long long sim_random_mix64(unsigned long long value);
+
+#endif // SIM_RANDOM_H
@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+#include "simulation_utils.h"
+#include "world_utils.h"
+#include "entity_actions.h"
+#include "deterministic_step.h"
+#include "lifecycle_kernel.h"
+#include "plant_layer.h"
+#include "population_stats.h"
+#include "metrics_exporter.h"
+#include "latency_histogram.h"
+#include "free_cell_index.h"
+#include "species.h"
+#include "task_graph.h"
+#include "shm_publisher.h"
+#include "sync_telemetry.h"
+#include "event_log.h"
+#include "phase_tuner.h"
+#include "world_chunks.h"
+
+// A szimulációs motor: egy lépés (fázisok, pufferek cseréje, mérések) és az entitások
+// véglegesítése a következő állapotba. Nem függ a megjelenítéstől (ncurses), így a
+// libecosim könyvtár része; a main.c menüje és a beágyazók (ecosim.h) is ezt hívják.
+
+bool _commit_entity_to_next_state(World *world, Entity entity_data)
+{
+    // Determinisztikus módban az entitás a saját kimeneti helyére kerül, a sorrendet a fázis vége rögzíti.
+    if (world->deterministic)
+    {
+        deterministic_emit_entity(&entity_data);
+        return true;
+    }
+
+    // Ellenőrzés, hogy van-e hely a next_entities tömbben
+    if (world->next_entity_count >= world->next_entity_capacity)
+    {
+        // fprintf(stderr, "FIGYELEM: next_entities tömb megtelt (%d/%d). Entitás (ID: %d) nem lett hozzáadva.\\n",
+        //         world->next_entity_count, MAX_TOTAL_ENTITIES, entity_data.id);
+        if (world->metrics)
+            metrics_exporter_note_commit_drop(world->metrics);
+        return false; // Nincs több hely
+    }
+
+    int next_idx;
+    SYNC_PROBE_BEGIN(slot_probe);
+#pragma omp atomic capture // atomikusan növeljük a next_entity_countot és elmentjük az eredeti értéket next_idx-be
+    next_idx = world->next_entity_count++;
+    SYNC_PROBE_END(slot_probe, SYNC_COMMIT_SLOT);
+
+    if (next_idx >= world->next_entity_capacity)
+    {
+        // fprintf(stderr, "HIBA: next_entities kapacitás (%d) túlcsordult commit közben (idx: %d), ID: %d! Entitás elveszett.\\n",
+        //         MAX_TOTAL_ENTITIES, next_idx, entity_data.id);
+#pragma omp atomic update
+        world->next_entity_count--;
+        if (world->metrics)
+            metrics_exporter_note_commit_drop(world->metrics);
+        return false;
+    }
+
+    world->next_entities[next_idx] = entity_data;
+    if (world->stats)
+        population_stats_record_entity(world->stats, &entity_data);
+
+    if (is_valid_pos(world, entity_data.position.x, entity_data.position.y))
+    {
+        SYNC_PROBE_BEGIN(grid_probe);
+#pragma omp critical
+        {
+            SYNC_PROBE_END(grid_probe, SYNC_COMMIT_GRID);
+            if (world->next_grid[entity_data.position.y][entity_data.position.x].entity == NULL)
+            {
+                world->next_grid[entity_data.position.y][entity_data.position.x].entity = &world->next_entities[next_idx];
+                world_chunks_note_write(world, WORLD_CHUNKS_NEXT, entity_data.position.x, entity_data.position.y);
+            }
+        }
+    }
+    return true;
+}
+
+// Egy faj fázisa. Állatoknál előbb az érzékelési menet (állatonként egyetlen célpontkeresés),
+// majd a döntés és végrehajtás a faj lépés eleji túlélőin, az általános kernellel.
+static void process_species_phase(World *world, int current_step_number, EntityType type)
+{
+    if (type == PLANT && world->plants)
+    {
+        // Növényréteg: a teljes növényfázis egyetlen stencil-menet (determinisztikus is)
+        plant_layer_step(world, current_step_number);
+        return;
+    }
+    if (world->deterministic)
+    {
+        deterministic_process_phase(world, current_step_number, type);
+        return;
+    }
+
+    const int *survivors = world->lifecycle->survivors[type];
+    int survivor_count = world->lifecycle->survivor_count[type];
+    bool animal = !species_is_autotroph(type);
+    // Hangolóval a fázis a becsült leggyorsabb szálszámon fut (1: sorosan), egyébként a teljes csapattal
+    int regions = animal ? 2 : 1;
+    int threads = world->tuner ? phase_tuner_choose(world->tuner, type, survivor_count, regions) : omp_get_max_threads();
+    double phase_begin = omp_get_wtime();
+    if (animal)
+    {
+#pragma omp parallel for schedule(dynamic) num_threads(threads) if (threads > 1)
+        for (int k = 0; k < survivor_count; k++)
+        {
+            perceive_animal(world, &world->entities[survivors[k]], &world->perception[survivors[k]]);
+        }
+    }
+
+#pragma omp parallel for shared(world, current_step_number) schedule(dynamic) num_threads(threads) if (threads > 1)
+    for (int k = 0; k < survivor_count; k++)
+    {
+        process_species_entity(world, current_step_number, survivors[k]);
+    }
+    if (world->tuner)
+    {
+        phase_tuner_record(world->tuner, type, survivor_count, regions, threads, omp_get_wtime() - phase_begin);
+    }
+}
+
+void simulate_step(World *world, int current_step_number)
+{
+    if (!world)
+        return;
+
+    double step_start_time, step_end_time;
+
+    step_start_time = omp_get_wtime();
+
+    // Következő állapot előkészítése:
+    // - A next_entity_count nullázása.
+    // - A next_grid celláinak kiürítése (ritka tárolásnál csak az előző használat óta írt darabok)
+    world->next_entity_count = 0;
+    if (world->chunks)
+    {
+        world_chunks_clear_next(world);
+    }
+    else
+    {
+        for (int i = 0; i < world->height; i++)
+        {
+            for (int j = 0; j < world->width; j++)
+            {
+                world->next_grid[i][j].entity = NULL;
+            }
+        }
+    }
+    // int estimated_min_capacity = world->entity_count + (world->entity_count / 2) + 100;
+    // if (estimated_min_capacity < INITIAL_ENTITY_CAPACITY)
+    //     estimated_min_capacity = INITIAL_ENTITY_CAPACITY;
+    // _ensure_next_entity_capacity(world, estimated_min_capacity); // Ezt a hívást eltávolítjuk
+
+    if (world->stats)
+    {
+        population_stats_begin_step(world->stats, world, current_step_number);
+    }
+
+    // Vektorizált elő-menet: öregedés, energiafogyás/növekedés és halál-szűrés az összes entitásra.
+    // A fázisok ezután csak a típusonkénti túlélő-listákon iterálnak.
+    lifecycle_prepass(world, world->lifecycle);
+    // Az elő-menetben elhunytak naplózása (a túlélő-listákon kívül maradtak)
+    if (world->events)
+    {
+        event_log_record_deaths(world->events, world, current_step_number);
+    }
+
+    // Fajonkénti fázisok a fajtábla sorrendjében (ragadozók, növényevők, növények).
+    // Minden fázis ugyanazt az általános kernelt futtatja, a faj paramétereivel.
+    // Feladatgráfos módban a fázisok sávonként, a valódi függőségek mentén átlapolódnak.
+    double phase_seconds_by_type[ENTITY_TYPE_COUNT] = {0};
+    if (world->task_graph && !world->deterministic)
+    {
+        task_graph_run_phases(world, current_step_number, phase_seconds_by_type);
+    }
+    else
+    {
+        for (int phase = 0; phase < species_phase_count; phase++)
+        {
+            EntityType type = species_phase_order[phase];
+            double phase_start_time = omp_get_wtime();
+            process_species_phase(world, current_step_number, type);
+            phase_seconds_by_type[type] = omp_get_wtime() - phase_start_time;
+        }
+    }
+
+    // Determinisztikus módban a next_grid a véglegesített, stabil sorrendű next_entities-ből épül fel.
+    if (world->deterministic)
+    {
+        deterministic_build_next_grid(world);
+    }
+    // A lépés eseményeinek átadása a napló író szálának (a kiírás a következő lépéssel átlapolódik)
+    if (world->events)
+    {
+        event_log_end_step(world->events);
+    }
+#ifdef ECOSIM_SYNC_TELEMETRY
+    sync_telemetry_end_step(current_step_number);
+#endif
+
+    // Állapotváltás (double buffering swap):
+    // A `grid` és `next_grid` (cellamátrixok), valamint az `entities` és `next_entities`
+    // (entitáslisták) pointereit megcseréljük. Így a `next_` állapotok válnak
+    // az aktuális állapottá a következő lépéshez, és a korábbi aktuális állapotok
+    // újra felhasználhatók lesznek a következő `next_` állapotok tárolására.
+    // Ez hatékony, mert nem igényel nagyméretű adatmozgatást, csak pointercseréket.
+    // Ritka tárolásnál előbb a next_grid tartósan üres darabjai visszaadják a lapjaikat, és a
+    // darabkönyvtár pufferei a rácsokkal együtt cserélődnek.
+    if (world->chunks)
+    {
+        world_chunks_reclaim_next(world);
+    }
+    Cell **temp_grid_ptr = world->grid;
+    world->grid = world->next_grid;
+    world->next_grid = temp_grid_ptr;
+    world_chunks_swap(world->chunks);
+
+    Entity *temp_entities_ptr = world->entities;
+    world->entities = world->next_entities;
+    world->next_entities = temp_entities_ptr;
+    // A szabad cellák indexe az új rácsra már nem érvényes; a következő lekérdezés újraépíti
+    free_cell_index_invalidate(world->free_cells);
+
+    world->entity_count = world->next_entity_count;
+
+    int temp_capacity = world->entity_capacity;
+    world->entity_capacity = world->next_entity_capacity;
+    world->next_entity_capacity = temp_capacity;
+
+    // Az új aktuális állapot publikálása a külső megjelenítőknek (osztott memória, két rés)
+    if (world->publisher)
+    {
+        shm_publisher_publish(world->publisher, world, current_step_number);
+    }
+
+    // A lépés statisztikájának összevonása és publikálása (a megfigyelők a seqlock-on át olvassák)
+    if (world->stats)
+    {
+        population_stats_end_step(world->stats, world);
+    }
+
+    step_end_time = omp_get_wtime();
+
+    if (world->metrics)
+    {
+        double phase_seconds[METRICS_PHASE_COUNT];
+        phase_seconds[METRICS_PHASE_CARNIVORE] = phase_seconds_by_type[CARNIVORE];
+        phase_seconds[METRICS_PHASE_HERBIVORE] = phase_seconds_by_type[HERBIVORE];
+        phase_seconds[METRICS_PHASE_PLANT] = phase_seconds_by_type[PLANT];
+        metrics_exporter_record_step(world->metrics, world, phase_seconds);
+    }
+
+    // Időmérési eredmények rögzítése a hisztogramokba (a lépésenkénti stderr sor csak --step-log esetén)
+    if (world->latency)
+    {
+        double latency_seconds[LATENCY_PHASE_COUNT];
+        latency_seconds[LATENCY_PHASE_TOTAL] = step_end_time - step_start_time;
+        latency_seconds[LATENCY_PHASE_CARNIVORE] = phase_seconds_by_type[CARNIVORE];
+        latency_seconds[LATENCY_PHASE_HERBIVORE] = phase_seconds_by_type[HERBIVORE];
+        latency_seconds[LATENCY_PHASE_PLANT] = phase_seconds_by_type[PLANT];
+        latency_recorder_record_step(world->latency, current_step_number, latency_seconds, omp_get_max_threads());
+    }
+}
+
+// Egy új entitás elhelyezése a létszámplafon ellenőrzése nélkül (lásd spawn_entity). A position
+// NULL esetén egyenletes eloszlású üres cellára kerül; megadott pozíciónál a cellának érvényesnek
+// és üresnek kell lennie. Hamis, ha nincs hely vagy a típus ismeretlen.
+bool place_entity(World *world, EntityType type, const Coordinates *position, int current_step)
+{
+    if (!world || world->entity_count >= world->entity_capacity)
+    {
+        // Nincs hely a globális tömbben
+        return false;
+    }
+    if (type <= EMPTY || type >= ENTITY_TYPE_COUNT)
+    {
+        // Ismeretlen típus
+        return false;
+    }
+    const SpeciesInfo *species = species_info(type);
+    int initial_energy = species->initial_energy;
+
+    Coordinates spawn_pos;
+    if (position)
+    {
+        if (!is_valid_pos(world, position->x, position->y) || !is_cell_free(world, position->x, position->y))
+            return false;
+        spawn_pos = *position;
+        if (world->free_cells->valid)
+            free_cell_index_mark_occupied(world->free_cells, spawn_pos.x, spawn_pos.y);
+    }
+    else if (!take_random_free_cell(world, &spawn_pos))
+    {
+        // Nem talált üres cellát a spawnoláshoz
+        return false;
+    }
+
+    if (type == PLANT && world->plants)
+    {
+        // Növényréteg: a növény nem foglal entitás helyet
+        plant_layer_place(world->plants, spawn_pos.x, spawn_pos.y, initial_energy, 0);
+        return true;
+    }
+    Entity *new_entity = &world->entities[world->entity_count];
+    new_entity->id = world->next_entity_id++;
+    new_entity->type = type;
+    new_entity->position = spawn_pos;
+    new_entity->energy = initial_energy;
+    new_entity->age = 0;
+    new_entity->sight_range = species->sight_range;
+    new_entity->last_reproduction_step = current_step; // Azért, hogy ne szaporodjon azonnal
+    new_entity->last_eating_step = -1;
+    new_entity->just_spawned_by_keypress = species->highlight_on_spawn;
+
+    world->grid[spawn_pos.y][spawn_pos.x].entity = new_entity;
+    world_chunks_note_write(world, WORLD_CHUNKS_CURRENT, spawn_pos.x, spawn_pos.y);
+    world->entity_count++;
+    return true;
+}
+
+// Kézi spawnolás: mint a place_entity, de a faj létszámplafonját is betartja.
+bool spawn_entity(World *world, EntityType type, const Coordinates *position, int current_step)
+{
+    if (!world || type <= EMPTY || type >= ENTITY_TYPE_COUNT)
+        return false;
+    if (count_entities_by_type(world, type) >= world->population_cap[type])
+    {
+        // Elérte a típus-specifikus maximumot
+        return false;
+    }
+    return place_entity(world, type, position, current_step);
+}
@@ -1,15 +1,26 @@
 #ifndef SIMULATION_UTILS_H
 #define SIMULATION_UTILS_H
 
+#include <stdbool.h>
+
 #include "datatypes.h" // Szükséges a World és Entity típusokhoz
 
-// Segédfüggvények a double bufferinghoz és párhuzamosításhoz
-// Ezeket a main.c definiálja
-void _commit_entity_to_next_state(World *world, Entity entity_data);
+// A szimulációs motor belső felülete (simulation.c); a beágyazók az ecosim.h API-t használják.
+// Egy szimulációs lépés: fázisok, pufferek cseréje, statisztika, metrikák és publikálás.
+void simulate_step(World *world, int current_step_number);
+// Egy entitás véglegesítése a következő állapotba (next_entities, next_grid); bármely szálról hívható.
+// Hamis, ha a next_entities megtelt és az entitás elveszett (determinisztikus módban mindig igaz).
+bool _commit_entity_to_next_state(World *world, Entity entity_data);
+// Egy új entitás elhelyezése véletlen (position == NULL) vagy megadott üres cellára. Hamis, ha nem sikerült.
+// A spawn_entity a faj létszámplafonját is betartja, a place_entity nem (a hívó ellenőrzi).
+bool spawn_entity(World *world, EntityType type, const Coordinates *position, int current_step);
+bool place_entity(World *world, EntityType type, const Coordinates *position, int current_step);
+
+// A world_utils.c segédfüggvényei
 void free_world(World *world);
 int is_valid_pos(const World *world, int x, int y);
 Coordinates get_random_adjacent_empty_cell(World *world, Coordinates pos);
 Coordinates get_step_towards_target(World *world, Coordinates current_pos, Coordinates target_pos);
 int count_entities_by_type(const World *world, EntityType type);
 
-#endif // SIMULATION_UTILS_H
\ No newline at end of file
+#endif // SIMULATION_UTILS_H
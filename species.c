@@ -0,0 +1,76 @@
+#include "species.h"
+#include "simulation_constants.h"
+
+// A paraméterek forrása továbbra is a simulation_constants.h; a tábla csak fajonként rendezi őket.
+const SpeciesInfo species_table[ENTITY_TYPE_COUNT] = {
+    [EMPTY] = {.name = "empty", .food = EMPTY, .max_age = 0},
+    [PLANT] = {
+        .name = "plant",
+        .food = EMPTY,
+        .initial_energy = PLANT_INITIAL_ENERGY,
+        .max_energy = PLANT_MAX_ENERGY,
+        .energy_change = PLANT_GROWTH_RATE,
+        .move_cost = 0,
+        .sight_range = 0,
+        .max_age = PLANT_MAX_AGE,
+        .critical_energy = 0,
+        .energy_from_food = 0,
+        .reproduction_threshold = PLANT_INITIAL_ENERGY,
+        .reproduction_cost = 0,
+        .reproduction_cooldown = PLANT_REPRODUCTION_COOLDOWN,
+        .reproduction_probability = PLANT_REPRODUCTION_PROBABILITY,
+        .max_population = MAX_PLANTS,
+        .eats_after_move = false,
+        .moves_onto_food = false,
+        .highlight_on_spawn = false,
+    },
+    [HERBIVORE] = {
+        .name = "herbivore",
+        .food = PLANT,
+        .initial_energy = HERBIVORE_INITIAL_ENERGY,
+        .max_energy = HERBIVORE_MAX_ENERGY,
+        .energy_change = -HERBIVORE_ENERGY_DECAY,
+        .move_cost = HERBIVORE_MOVE_COST,
+        .sight_range = HERBIVORE_SIGHT_RANGE,
+        .max_age = HERBIVORE_MAX_AGE,
+        .critical_energy = HERBIVORE_CRITICAL_ENERGY_THRESHOLD,
+        .energy_from_food = HERBIVORE_ENERGY_FROM_PLANT,
+        .reproduction_threshold = HERBIVORE_REPRODUCTION_THRESHOLD,
+        .reproduction_cost = HERBIVORE_REPRODUCTION_COST,
+        .reproduction_cooldown = HERBIVORE_REPRODUCTION_COOLDOWN,
+        .reproduction_probability = 1.0,
+        .max_population = MAX_HERBIVORES,
+        .eats_after_move = false,
+        .moves_onto_food = false,
+        .highlight_on_spawn = true,
+    },
+    [CARNIVORE] = {
+        .name = "carnivore",
+        .food = HERBIVORE,
+        .initial_energy = CARNIVORE_INITIAL_ENERGY,
+        .max_energy = CARNIVORE_MAX_ENERGY,
+        .energy_change = -CARNIVORE_ENERGY_DECAY,
+        .move_cost = CARNIVORE_MOVE_COST,
+        .sight_range = CARNIVORE_SIGHT_RANGE,
+        .max_age = CARNIVORE_MAX_AGE,
+        .critical_energy = CARNIVORE_CRITICAL_ENERGY_THRESHOLD,
+        .energy_from_food = CARNIVORE_ENERGY_FROM_HERBIVORE,
+        .reproduction_threshold = CARNIVORE_REPRODUCTION_THRESHOLD,
+        .reproduction_cost = CARNIVORE_REPRODUCTION_COST,
+        .reproduction_cooldown = CARNIVORE_REPRODUCTION_COOLDOWN,
+        .reproduction_probability = 1.0,
+        .max_population = MAX_CARNIVORES,
+        .eats_after_move = true,
+        .moves_onto_food = true,
+        .highlight_on_spawn = true,
+    },
+#if ECOSIM_EXTRA_SPECIES > 0
+    // Próbafajok: autotrófok nulla létszámplafonnal, a fázissorrendben sem szerepelnek
+    [CARNIVORE + 1 ... ENTITY_TYPE_COUNT - 1] = {.name = "extra", .food = EMPTY, .max_age = 0},
+#endif
+};
+
+// A ragadozók a növényevők előtt, azok a növények előtt lépnek: a zsákmány a saját fázisában már
+// tudja, hogy megették-e.
+const EntityType species_phase_order[] = {CARNIVORE, HERBIVORE, PLANT};
+const int species_phase_count = (int)(sizeof(species_phase_order) / sizeof(species_phase_order[0]));
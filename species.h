@@ -0,0 +1,50 @@
+#ifndef SPECIES_H
+#define SPECIES_H
+
+#include <stdbool.h>
+
+#include "datatypes.h"        // Szükséges az EntityType típushoz
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+
+// Fajtábla: minden faj viselkedését és paramétereit egy sor írja le, a szimuláció egyetlen
+// általános kernellel (process_species_actions) dolgozza fel bármelyiket. Új faj felvétele:
+// új EntityType érték, az ENTITY_TYPE_COUNT növelése és egy új sor a species_table-ben.
+typedef struct
+{
+    const char *name;          // Rövid név (statisztika, metrikák)
+    EntityType food;           // Táplálék faja; EMPTY: autotróf (nem mozog, nem eszik, nő)
+    int initial_energy;        // Kezdeti, spawnolási és születési energia
+    int max_energy;            // Energiaplafon (evésnél és növekedésnél)
+    int energy_change;         // Lépésenkénti energiaváltozás: negatív fogyás, pozitív növekedés max_energy-ig
+    int move_cost;             // A mozgás energiaköltsége (a szaporodás után ennél többnek kell maradnia)
+    int sight_range;           // Látótávolság (Manhattan)
+    int max_age;               // E kor felett elpusztul
+    int critical_energy;       // Ez alatt előbb enni próbál, mielőtt mozogna
+    int energy_from_food;      // Egy zsákmány energiája
+    int reproduction_threshold; // Minimális energia a szaporodáshoz
+    int reproduction_cost;     // A szülő energiavesztesége
+    int reproduction_cooldown; // Minimum lépésszám két szaporodás között
+    double reproduction_probability; // Szaporodási esély, ha a feltételek adottak (1.0: mindig)
+    int max_population;        // Alapértelmezett létszámplafon (World.population_cap; e felett nincs szaporodás és spawnolás)
+    bool eats_after_move;      // Mozgás után is megpróbál enni (az új helyén)
+    bool moves_onto_food;      // Normál evés után a zsákmány helyére lép
+    bool highlight_on_spawn;   // Kézi spawnolás után kiemelt színnel jelenik meg
+} SpeciesInfo;
+
+extern const SpeciesInfo species_table[ENTITY_TYPE_COUNT];
+
+// A fázisok sorrendje egy lépésen belül (a csúcsragadozóktól az autotrófokig), és a hossza
+extern const EntityType species_phase_order[];
+extern const int species_phase_count;
+
+static inline const SpeciesInfo *species_info(EntityType type)
+{
+    return &species_table[type];
+}
+
+static inline bool species_is_autotroph(EntityType type)
+{
+    return species_table[type].food == EMPTY;
+}
+
+#endif // SPECIES_H
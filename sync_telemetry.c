@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sync_telemetry.h"
+
+#ifdef ECOSIM_SYNC_TELEMETRY
+
+static const char *point_names[SYNC_POINT_COUNT] = {"eat_critical", "entity_id", "commit_slot", "commit_grid", "plant_graze"};
+
+SyncThreadCounters sync_thread_counters[SYNC_TELEMETRY_MAX_THREADS];
+
+// Lépésenkénti összesítés pontonként (csak a soros lépésvégi rész írja)
+static unsigned long long steps_recorded;
+static unsigned long long max_step_entries[SYNC_POINT_COUNT];
+static unsigned long long max_step_wait_ns[SYNC_POINT_COUNT];
+
+// Lépésenkénti, szálankénti napló (NULL: nincs); a forkolt ágak nem írják
+static FILE *step_log;
+static pid_t step_log_owner;
+
+bool sync_telemetry_enabled(void)
+{
+    return true;
+}
+
+bool sync_telemetry_open_log(const char *path)
+{
+    sync_telemetry_close_log();
+    step_log = fopen(path, "w");
+    if (!step_log)
+    {
+        perror("Hiba a szinkronizációs napló megnyitásakor");
+        return false;
+    }
+    step_log_owner = getpid();
+    fprintf(step_log, "step,thread,point,entries,wait_ns\n");
+    return true;
+}
+
+void sync_telemetry_close_log(void)
+{
+    if (!step_log)
+        return;
+    if (getpid() == step_log_owner && fclose(step_log) != 0)
+        perror("Hiba a szinkronizációs napló lezárásakor");
+    step_log = NULL;
+}
+
+void sync_telemetry_end_step(int step_number)
+{
+    bool log = step_log && getpid() == step_log_owner;
+    SyncCounter step_sum[SYNC_POINT_COUNT];
+    memset(step_sum, 0, sizeof(step_sum));
+    for (int thread = 0; thread < SYNC_TELEMETRY_MAX_THREADS; thread++)
+    {
+        SyncThreadCounters *counters = &sync_thread_counters[thread];
+        for (int point = 0; point < SYNC_POINT_COUNT; point++)
+        {
+            SyncCounter *step = &counters->step[point];
+            if (log && step->entries)
+                fprintf(step_log, "%d,%d,%s,%llu,%llu\n", step_number, thread, point_names[point], step->entries, step->wait_ns);
+            step_sum[point].entries += step->entries;
+            step_sum[point].wait_ns += step->wait_ns;
+            counters->total[point].entries += step->entries;
+            counters->total[point].wait_ns += step->wait_ns;
+            step->entries = 0;
+            step->wait_ns = 0;
+        }
+    }
+    for (int point = 0; point < SYNC_POINT_COUNT; point++)
+    {
+        if (step_sum[point].entries > max_step_entries[point])
+            max_step_entries[point] = step_sum[point].entries;
+        if (step_sum[point].wait_ns > max_step_wait_ns[point])
+            max_step_wait_ns[point] = step_sum[point].wait_ns;
+    }
+    steps_recorded++;
+}
+
+static SyncCounter point_total(int point)
+{
+    SyncCounter sum = {0, 0};
+    for (int thread = 0; thread < SYNC_TELEMETRY_MAX_THREADS; thread++)
+    {
+        sum.entries += sync_thread_counters[thread].total[point].entries;
+        sum.wait_ns += sync_thread_counters[thread].total[point].wait_ns;
+    }
+    return sum;
+}
+
+void sync_telemetry_report(FILE *out)
+{
+    double steps = steps_recorded ? (double)steps_recorded : 1.0;
+    fprintf(out, "Szinkronizációs pontok (%llu lépés; várakozás: belépésig, ill. az atomi művelet ideje):\n", steps_recorded);
+    for (int point = 0; point < SYNC_POINT_COUNT; point++)
+    {
+        SyncCounter sum = point_total(point);
+        if (sum.entries == 0)
+            continue;
+        fprintf(out, "  %-12s belépés %llu (%.1f/lépés, max %llu), várakozás %.3f ms (%.0f ns/belépés, %.3f ms/lépés, max %.3f ms)\n",
+                point_names[point], sum.entries, sum.entries / steps, max_step_entries[point], sum.wait_ns / 1e6,
+                (double)sum.wait_ns / sum.entries, sum.wait_ns / 1e6 / steps, max_step_wait_ns[point] / 1e6);
+        fprintf(out, "               szálanként:");
+        for (int thread = 0; thread < SYNC_TELEMETRY_MAX_THREADS; thread++)
+        {
+            const SyncCounter *total = &sync_thread_counters[thread].total[point];
+            if (total->entries)
+                fprintf(out, " t%d %llu/%.3fms", thread, total->entries, total->wait_ns / 1e6);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void sync_telemetry_format_json(char *out, size_t size)
+{
+    size_t length = 0;
+    out[0] = '\0';
+    for (int point = 0; point < SYNC_POINT_COUNT && length < size; point++)
+    {
+        SyncCounter sum = point_total(point);
+        int written = snprintf(out + length, size - length, ", \"sync_%s_entries\": %llu, \"sync_%s_wait_ms\": %.3f",
+                               point_names[point], sum.entries, point_names[point], sum.wait_ns / 1e6);
+        if (written < 0)
+            break;
+        length += (size_t)written;
+    }
+}
+
+#else
+
+bool sync_telemetry_enabled(void)
+{
+    return false;
+}
+
+bool sync_telemetry_open_log(const char *path)
+{
+    (void)path;
+    fprintf(stderr, "Hiba: a szinkronizációs napló csak telemetriás fordításban érhető el (make SYNC_TELEMETRY=1).\n");
+    return false;
+}
+
+void sync_telemetry_close_log(void)
+{
+}
+
+void sync_telemetry_end_step(int step)
+{
+    (void)step;
+}
+
+void sync_telemetry_report(FILE *out)
+{
+    (void)out;
+}
+
+void sync_telemetry_format_json(char *out, size_t size)
+{
+    if (size > 0)
+        out[0] = '\0';
+}
+
+#endif // ECOSIM_SYNC_TELEMETRY
@@ -0,0 +1,104 @@
+#ifndef SYNC_TELEMETRY_H
+#define SYNC_TELEMETRY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Szinkronizációs telemetria: a szinkronizációs pontok (kritikus szakaszok, atomi műveletek)
+// belépéseinek száma és várakozási ideje szálanként és lépésenként. Csak a
+// -DECOSIM_SYNC_TELEMETRY-vel fordított változatban él ("make SYNC_TELEMETRY=1"); anélkül a
+// SYNC_PROBE_* makrók üresek, így a normál fordításban nincs többletköltség.
+//
+// Használat egy ponton:
+//     SYNC_PROBE_BEGIN(probe);
+//     #pragma omp critical
+//     {
+//         SYNC_PROBE_END(probe, SYNC_EAT_CRITICAL); // a várakozás a belépésig tart
+//         ...
+//     }
+// Atomi műveletnél a művelet utánra kerül a SYNC_PROBE_END (a cache-sor megszerzése a várakozás).
+// A mért idő a két órakiolvasás (~20 ns) költségét is tartalmazza.
+//
+// A futás végi összegzés szálanként csak összesít; a lépésenkénti, szálankénti sorokat a
+// sync_telemetry_open_log-gal megnyitott CSV napló kapja (step,thread,point,entries,wait_ns;
+// csak a nem nulla számlálók), a lépés végén a soros részből írva.
+
+typedef enum
+{
+    SYNC_EAT_CRITICAL, // try_eat_target: névtelen omp critical
+    SYNC_ENTITY_ID,    // allocate_entity_id: atomic capture a next_entity_id-n
+    SYNC_COMMIT_SLOT,  // _commit_entity_to_next_state: atomic capture a next_entity_count-on
+    SYNC_COMMIT_GRID,  // _commit_entity_to_next_state: névtelen omp critical a next_grid cellájára
+    SYNC_PLANT_GRAZE,  // plant_layer_try_graze: atomi fetch_and a foglaltsági bittérképen
+    SYNC_POINT_COUNT
+} SyncPoint;
+
+#define SYNC_TELEMETRY_MAX_THREADS 128 // Szálindexek e fölött közös rekeszbe esnek (pontatlan, de biztonságos)
+
+#ifdef ECOSIM_SYNC_TELEMETRY
+
+#include <time.h>
+#include <omp.h>
+
+typedef struct
+{
+    unsigned long long entries;
+    unsigned long long wait_ns;
+} SyncCounter;
+
+// Szálanként egy cache-sorhoz igazított rekesz, hogy a számlálás ne okozzon hamis megosztást
+typedef struct
+{
+    SyncCounter step[SYNC_POINT_COUNT];  // Az aktuális lépés számlálói
+    SyncCounter total[SYNC_POINT_COUNT]; // A futás összesen
+} __attribute__((aligned(64))) SyncThreadCounters;
+
+extern SyncThreadCounters sync_thread_counters[SYNC_TELEMETRY_MAX_THREADS];
+
+static inline unsigned long long sync_telemetry_clock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+}
+
+static inline void sync_telemetry_record(SyncPoint point, unsigned long long wait_ns)
+{
+    int thread = omp_get_thread_num();
+    SyncCounter *counter = &sync_thread_counters[thread < SYNC_TELEMETRY_MAX_THREADS ? thread : SYNC_TELEMETRY_MAX_THREADS - 1].step[point];
+    counter->entries++;
+    counter->wait_ns += wait_ns;
+}
+
+#define SYNC_PROBE_BEGIN(name) unsigned long long name = sync_telemetry_clock()
+#define SYNC_PROBE_END(name, point) sync_telemetry_record((point), sync_telemetry_clock() - (name))
+
+#else
+
+#define SYNC_PROBE_BEGIN(name) \
+    do                         \
+    {                          \
+    } while (0)
+#define SYNC_PROBE_END(name, point) \
+    do                              \
+    {                               \
+    } while (0)
+
+#endif // ECOSIM_SYNC_TELEMETRY
+
+// Igaz, ha a program a telemetriával fordult.
+bool sync_telemetry_enabled(void);
+// A lépésenkénti, szálankénti CSV napló megnyitása és lezárása. A megnyitás hamis, ha a fájl nem
+// nyitható, vagy ha a program telemetria nélkül fordult. A naplót csak a megnyitó folyamat írja
+// (az ecosim_fork ágai nem).
+bool sync_telemetry_open_log(const char *path);
+void sync_telemetry_close_log(void);
+// A lépés számlálóinak lezárása (a simulate_step soros részéből, a fázisok után).
+void sync_telemetry_end_step(int step);
+// Összegzés pontonként és szálanként; a telemetria nélküli fordításban nem ír semmit.
+void sync_telemetry_report(FILE *out);
+// A benchmark JSON sorába illeszthető ", \"sync_<pont>_...\": ..." mezők (üres, ha nincs telemetria).
+void sync_telemetry_format_json(char *out, size_t size);
+
+#endif // SYNC_TELEMETRY_H
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+#include "task_graph.h"
+#include "entity_actions.h"
+#include "plant_layer.h"
+#include "species.h"
+#include "topology.h"
+#include "memory_accounting.h"
+
+bool task_graph_enable(World *world)
+{
+    if (!world)
+        return false;
+    if (!world->task_graph)
+    {
+        world->task_graph = (TaskGraph *)memory_calloc(MEMORY_TASK_GRAPH, 1, sizeof(TaskGraph));
+        if (!world->task_graph)
+        {
+            perror("Hiba a feladatgráf foglalásakor");
+            return false;
+        }
+    }
+    return true;
+}
+
+void task_graph_free(TaskGraph *graph)
+{
+    if (!graph)
+        return;
+    memory_free(MEMORY_TASK_GRAPH, graph->band_start);
+    memory_free(MEMORY_TASK_GRAPH, graph->band_items);
+    memory_free(MEMORY_TASK_GRAPH, graph->tokens);
+    memory_free(MEMORY_TASK_GRAPH, graph->task_start);
+    memory_free(MEMORY_TASK_GRAPH, graph->task_end);
+    memory_free(MEMORY_TASK_GRAPH, graph);
+}
+
+// A sávkiosztás és a pufferek igazítása a világ méretéhez, a szálszámhoz és a létszámhoz
+static bool prepare_bands(TaskGraph *graph, const World *world)
+{
+    int wanted = omp_get_max_threads() * TASK_GRAPH_BANDS_PER_THREAD;
+    int band_height = (world->height + wanted - 1) / wanted;
+    if (band_height < TASK_GRAPH_REACH)
+        band_height = TASK_GRAPH_REACH;
+    graph->band_height = band_height;
+    graph->band_count = (world->height + band_height - 1) / band_height;
+    // Tóruszon az utolsó sáv az elsővel is szomszédos, ezért ott sem lehet TASK_GRAPH_REACH-nél
+    // alacsonyabb: a maradék sorokat az előző sávhoz csapjuk
+    if (world->topology->toroidal && graph->band_count > 1 &&
+        world->height - (graph->band_count - 1) * band_height < TASK_GRAPH_REACH)
+        graph->band_count--;
+
+    if (graph->band_count > graph->band_capacity)
+    {
+        int capacity = graph->band_count;
+        int *band_start = (int *)memory_realloc(MEMORY_TASK_GRAPH, graph->band_start, (size_t)species_phase_count * (capacity + 1) * sizeof(int));
+        if (band_start)
+            graph->band_start = band_start;
+        char *tokens = (char *)memory_realloc(MEMORY_TASK_GRAPH, graph->tokens, (size_t)(species_phase_count + 1) * capacity);
+        if (tokens)
+            graph->tokens = tokens;
+        double *task_start = (double *)memory_realloc(MEMORY_TASK_GRAPH, graph->task_start, (size_t)species_phase_count * capacity * sizeof(double));
+        if (task_start)
+            graph->task_start = task_start;
+        double *task_end = (double *)memory_realloc(MEMORY_TASK_GRAPH, graph->task_end, (size_t)species_phase_count * capacity * sizeof(double));
+        if (task_end)
+            graph->task_end = task_end;
+        if (!band_start || !tokens || !task_start || !task_end)
+        {
+            perror("Hiba a feladatgráf sávpuffereinek foglalásakor");
+            return false;
+        }
+        graph->band_capacity = capacity;
+    }
+    if (world->entity_count > graph->item_capacity)
+    {
+        int capacity = world->entity_count;
+        int *band_items = (int *)memory_realloc(MEMORY_TASK_GRAPH, graph->band_items, (size_t)species_phase_count * capacity * sizeof(int));
+        if (!band_items)
+        {
+            perror("Hiba a feladatgráf elemlistáinak foglalásakor");
+            return false;
+        }
+        graph->band_items = band_items;
+        graph->item_capacity = capacity;
+    }
+    return true;
+}
+
+// A sor sávja (az utolsó sáv a hozzácsapott maradék sorokat is tartalmazza)
+static int band_of(const TaskGraph *graph, int y)
+{
+    int band = y / graph->band_height;
+    return band < graph->band_count ? band : graph->band_count - 1;
+}
+
+// A fázis túlélőinek szétosztása sávokba (leszámláló rendezés, a sávon belül megtartja a sorrendet)
+static void bucket_phase(TaskGraph *graph, const World *world, int phase, EntityType type)
+{
+    int *start = &graph->band_start[(size_t)phase * (graph->band_capacity + 1)];
+    int *items = &graph->band_items[(size_t)phase * graph->item_capacity];
+    const int *survivors = world->lifecycle->survivors[type];
+    int survivor_count = world->lifecycle->survivor_count[type];
+
+    for (int band = 0; band <= graph->band_count; band++)
+        start[band] = 0;
+    for (int k = 0; k < survivor_count; k++)
+        start[band_of(graph, world->entities[survivors[k]].position.y) + 1]++;
+    for (int band = 0; band < graph->band_count; band++)
+        start[band + 1] += start[band];
+    for (int k = 0; k < survivor_count; k++)
+    {
+        int band = band_of(graph, world->entities[survivors[k]].position.y);
+        items[start[band]++] = survivors[k];
+    }
+    // A beírás a kezdőindexeket a következő sáv elejére tolta; visszaállítjuk
+    for (int band = graph->band_count; band > 0; band--)
+        start[band] = start[band - 1];
+    start[0] = 0;
+}
+
+// Egy (fázis, sáv) feladat: a sáv állatainak érzékelése, majd minden entitás lépése
+static void run_band(World *world, TaskGraph *graph, int current_step_number, int phase, int band, bool animal)
+{
+    const int *start = &graph->band_start[(size_t)phase * (graph->band_capacity + 1)];
+    const int *items = &graph->band_items[(size_t)phase * graph->item_capacity];
+    size_t task = (size_t)phase * graph->band_capacity + band;
+    if (start[band] == start[band + 1])
+        return; // Üres sáv: csak a függőségek miatt ütemezett, a fázisidőbe nem számít
+
+    graph->task_start[task] = omp_get_wtime();
+    if (animal)
+    {
+        for (int k = start[band]; k < start[band + 1]; k++)
+            perceive_animal(world, &world->entities[items[k]], &world->perception[items[k]]);
+    }
+    for (int k = start[band]; k < start[band + 1]; k++)
+        process_species_entity(world, current_step_number, items[k]);
+    graph->task_end[task] = omp_get_wtime();
+}
+
+void task_graph_run_phases(World *world, int current_step_number, double phase_seconds[ENTITY_TYPE_COUNT])
+{
+    TaskGraph *graph = world->task_graph;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        phase_seconds[type] = 0.0;
+    if (!prepare_bands(graph, world))
+        return;
+
+    bool layered[ENTITY_TYPE_COUNT] = {false}; // A növényréteg stencilje nem sávos, a gráf után fut
+    for (int phase = 0; phase < species_phase_count; phase++)
+    {
+        EntityType type = species_phase_order[phase];
+        layered[type] = type == PLANT && world->plants;
+        if (!layered[type])
+            bucket_phase(graph, world, phase, type);
+        for (int band = 0; band < graph->band_count; band++)
+            graph->task_start[(size_t)phase * graph->band_capacity + band] = -1.0;
+    }
+
+#pragma omp parallel
+#pragma omp single
+    {
+        int dependency_row = 0; // Az utolsó ténylegesen ütemezett fázis tokensora (0: nincs előzmény)
+        for (int phase = 0; phase < species_phase_count; phase++)
+        {
+            EntityType type = species_phase_order[phase];
+            if (layered[type])
+                continue;
+            bool animal = !species_is_autotroph(type);
+            size_t previous = (size_t)dependency_row * graph->band_capacity;
+            size_t current = (size_t)(phase + 1) * graph->band_capacity;
+            int last = graph->band_count - 1;
+            bool wraps = world->topology->toroidal;
+            for (int band = 0; band < graph->band_count; band++)
+            {
+                // Az üres sáv is feladat: a munkája semmi, de a függőségi láncot továbbviszi (a
+                // következő fázis sávja különben a két fázissal korábbi szomszédok előtt indulhatna)
+                int above = band > 0 ? band - 1 : (wraps ? last : band);
+                int below = band < last ? band + 1 : (wraps ? 0 : band);
+#pragma omp task firstprivate(phase, band, animal) shared(world, graph, current_step_number) \
+    depend(in : graph->tokens[previous + above], graph->tokens[previous + band], graph->tokens[previous + below]) \
+    depend(out : graph->tokens[current + band])
+                run_band(world, graph, current_step_number, phase, band, animal);
+            }
+            dependency_row = phase + 1;
+        }
+    }
+
+    // Fázisidők: az első feladat kezdetétől az utolsó végéig
+    for (int phase = 0; phase < species_phase_count; phase++)
+    {
+        EntityType type = species_phase_order[phase];
+        if (layered[type])
+            continue;
+        double first = 0.0, last = 0.0;
+        bool any = false;
+        for (int band = 0; band < graph->band_count; band++)
+        {
+            size_t task = (size_t)phase * graph->band_capacity + band;
+            if (graph->task_start[task] < 0.0)
+                continue;
+            if (!any || graph->task_start[task] < first)
+                first = graph->task_start[task];
+            if (!any || graph->task_end[task] > last)
+                last = graph->task_end[task];
+            any = true;
+        }
+        phase_seconds[type] = any ? last - first : 0.0;
+    }
+
+    // Növényréteg: a teljes növényfázis egyetlen stencil-menet, az összes növényevő-feladat után
+    for (int phase = 0; phase < species_phase_count; phase++)
+    {
+        EntityType type = species_phase_order[phase];
+        if (!layered[type])
+            continue;
+        double phase_start_time = omp_get_wtime();
+        plant_layer_step(world, current_step_number);
+        phase_seconds[type] = omp_get_wtime() - phase_start_time;
+    }
+}
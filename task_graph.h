@@ -0,0 +1,41 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <stdbool.h>
+
+#include "datatypes.h"        // Szükséges a World típushoz
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+
+// Feladatgráfos végrehajtás: minden fázis vízszintes sávokra bomlik, egy (fázis, sáv) feladat
+// pedig csak az előző fázis szomszédos sávjaira vár (OpenMP task depend). Egy entitás egy
+// lépésben legfeljebb TASK_GRAPH_REACH sorral arrébb lévő zsákmányt ehet meg, így a sáv
+// magassága legalább ennyi, és a valódi függőség csak a b-1, b, b+1 sáv. A fázisok így
+// átlapolódnak: a növények egy sávja indulhat, amint a környező növényevő-sávok végeztek.
+// Csak a normál (nem determinisztikus) módban él; a növényréteg stencilje a gráf után fut.
+// Tóruszon az első és az utolsó sáv is szomszédos.
+
+#define TASK_GRAPH_REACH 2            // Mozgás (1) + szomszédos zsákmány (1) sorokban
+#define TASK_GRAPH_BANDS_PER_THREAD 8 // Ennyi sáv jut egy szálra (terheléskiegyenlítés)
+
+struct TaskGraph
+{
+    int band_height;
+    int band_count;
+    int band_capacity;
+    int *band_start; // [fázis * (band_capacity + 1) + sáv]: a sáv első eleme a band_items-ben
+    int *band_items; // A fázis túlélőinek indexei sávonként rendezve (fázisonként entity_count hely)
+    int item_capacity;
+    char *tokens;       // Függőségi tokenek: [(fázis + 1) * band_capacity + sáv]; a 0. sor az induló állapot
+    double *task_start; // Feladatonkénti kezdő- és záróidő a fázisidők méréséhez (< 0: nem futott)
+    double *task_end;
+};
+
+// Bekapcsolja a feladatgráfos módot (a puffereket az első lépés foglalja). Hiba esetén hamis.
+bool task_graph_enable(World *world);
+void task_graph_free(TaskGraph *graph);
+
+// Az összes fázis lefuttatása a feladatgráffal. A phase_seconds[típus] a fázis első feladatának
+// kezdetétől az utolsó végéig tart, így az átlapolódó fázisok ideje összeadva több lehet a lépésnél.
+void task_graph_run_phases(World *world, int current_step_number, double phase_seconds[ENTITY_TYPE_COUNT]);
+
+#endif // TASK_GRAPH_H
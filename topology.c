@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "topology.h"
+#include "species.h"
+#include "memory_accounting.h"
+
+// A world_utils.c szomszéd-sorrendje: bit i az (dx[i], dy[i]) eltolás
+static const int direction_dx[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+static const int direction_dy[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+// Egy tengely táblája és iránymaszkja. delta[] az adott tengely irányonkénti eltolása.
+static void build_axis(int *table, unsigned char *mask, int size, int padding, bool toroidal, const int delta[8])
+{
+    for (int v = -padding; v < size + padding; v++)
+    {
+        int wrapped = ((v % size) + size) % size;
+        int clamped = v < 0 ? 0 : (v >= size ? size - 1 : v);
+        table[v + padding] = toroidal ? wrapped : clamped;
+    }
+    for (int v = 0; v < size; v++)
+    {
+        unsigned char bits = 0;
+        for (int d = 0; d < 8; d++)
+        {
+            int moved = v + delta[d];
+            if (toroidal || (moved >= 0 && moved < size))
+                bits |= (unsigned char)(1u << d);
+        }
+        mask[v] = bits;
+    }
+}
+
+static void build_tables(Topology *topology, int width, int height, bool toroidal)
+{
+    topology->toroidal = toroidal;
+    topology->span_x = toroidal ? width : TOPOLOGY_UNBOUNDED_SPAN;
+    topology->span_y = toroidal ? height : TOPOLOGY_UNBOUNDED_SPAN;
+    build_axis(topology->column_storage, topology->mask_storage, width, topology->padding, toroidal, direction_dx);
+    build_axis(topology->row_storage, topology->mask_storage + width, height, topology->padding, toroidal, direction_dy);
+}
+
+Topology *topology_create(int width, int height)
+{
+    Topology *topology = (Topology *)memory_calloc(MEMORY_TOPOLOGY, 1, sizeof(Topology));
+    if (!topology)
+    {
+        perror("Hiba a topológia foglalásakor");
+        return NULL;
+    }
+    // A kitömés a legnagyobb látótávolságot fedi le (növényréteg rombusz-keresése)
+    int padding = 1;
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        if (species_table[type].sight_range > padding)
+            padding = species_table[type].sight_range;
+    topology->padding = padding;
+    topology->column_storage = (int *)memory_malloc(MEMORY_TOPOLOGY, (size_t)(width + 2 * padding) * sizeof(int));
+    topology->row_storage = (int *)memory_malloc(MEMORY_TOPOLOGY, (size_t)(height + 2 * padding) * sizeof(int));
+    topology->mask_storage = (unsigned char *)memory_malloc(MEMORY_TOPOLOGY, (size_t)width + height);
+    if (!topology->column_storage || !topology->row_storage || !topology->mask_storage)
+    {
+        perror("Hiba a topológia tábláinak foglalásakor");
+        topology_free(topology);
+        return NULL;
+    }
+    topology->column = topology->column_storage + padding;
+    topology->row = topology->row_storage + padding;
+    topology->column_mask = topology->mask_storage;
+    topology->row_mask = topology->mask_storage + width;
+    build_tables(topology, width, height, false);
+    return topology;
+}
+
+void topology_free(Topology *topology)
+{
+    if (!topology)
+        return;
+    memory_free(MEMORY_TOPOLOGY, topology->column_storage);
+    memory_free(MEMORY_TOPOLOGY, topology->row_storage);
+    memory_free(MEMORY_TOPOLOGY, topology->mask_storage);
+    memory_free(MEMORY_TOPOLOGY, topology);
+}
+
+void topology_set_toroidal(World *world, bool toroidal)
+{
+    if (world && world->topology && world->topology->toroidal != toroidal)
+        build_tables(world->topology, world->width, world->height, toroidal);
+}
@@ -0,0 +1,54 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "datatypes.h" // Szükséges a World és Coordinates típusokhoz
+
+// A világ topológiája: peremes (alapértelmezés) vagy tórusz (a szélek körbefutnak).
+// A szomszédos cellák koordinátáit előre kiszámolt, mindkét végén kitömött táblákból olvassuk:
+// column[x] a -padding <= x < width + padding tartományban tóruszon a körbefutott, peremes
+// világban a szélre szorított oszlop (a row ugyanígy). A 8 irány (world_utils.c sorrendje)
+// közül a világon belül maradók maszkja column_mask[x] & row_mask[y], tóruszon mindig 0xff.
+// Így a szomszédok elérése elágazás és maradékos osztás nélküli, és a szorított koordináta
+// mindig érvényes cellára mutat (a maszk dönti el, számít-e).
+
+#define TOPOLOGY_UNBOUNDED_SPAN (1 << 30) // Peremes világban a "körbefutó" távolság sosem rövidebb
+
+struct Topology
+{
+    bool toroidal;
+    int padding;                      // A táblák túlnyúlása mindkét oldalon (a legnagyobb látótávolság)
+    const int *column;                // column[x], -padding <= x < width + padding
+    const int *row;                   // row[y], -padding <= y < height + padding
+    const unsigned char *column_mask; // [x]: azok az irányok, amelyek oszlopa a világon belül van
+    const unsigned char *row_mask;    // [y]: ugyanez a sorokra
+    int span_x;                       // Tengelyenkénti kerület a távolsághoz (tóruszon width, egyébként TOPOLOGY_UNBOUNDED_SPAN)
+    int span_y;
+    int *column_storage;
+    int *row_storage;
+    unsigned char *mask_storage;
+};
+
+// Peremes topológia a világ méretéhez; hiba esetén NULL.
+Topology *topology_create(int width, int height);
+void topology_free(Topology *topology);
+// Átváltás tórusz és peremes világ között (a táblák újraszámolása, foglalás nélkül).
+void topology_set_toroidal(World *world, bool toroidal);
+
+// Távolság egy tengely mentén: tóruszon a rövidebb irány számít.
+static inline int topology_axis_distance(int a, int b, int span)
+{
+    int direct = abs(a - b);
+    int around = span - direct;
+    return direct < around ? direct : around;
+}
+
+// Manhattan-távolság a topológia szerint.
+static inline int topology_distance(const Topology *topology, Coordinates a, Coordinates b)
+{
+    return topology_axis_distance(a.x, b.x, topology->span_x) + topology_axis_distance(a.y, b.y, topology->span_y);
+}
+
+#endif // TOPOLOGY_H
@@ -0,0 +1,241 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <omp.h>
+
+#include "world_arena.h"
+#include "lifecycle_kernel.h"
+#include "free_cell_index.h"
+#include "entity_actions.h"
+#include "memory_accounting.h"
+#include "world_chunks.h"
+
+#define ARENA_ALIGNMENT 64                  // Cache-sor igazítás minden résztömbre
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024) // x86-64 alapértelmezett nagy lapmérete
+
+// A leképezésen belüli eltolások
+typedef struct
+{
+    size_t world;
+    size_t arena;
+    size_t grid_rows;
+    size_t next_grid_rows;
+    size_t grid_cells;
+    size_t next_grid_cells;
+    size_t entities;
+    size_t next_entities;
+    size_t lifecycle;
+    size_t free_cells;
+    size_t perception;
+    size_t total;
+} ArenaLayout;
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t reserve(size_t *cursor, size_t bytes)
+{
+    size_t offset = align_up(*cursor, ARENA_ALIGNMENT);
+    *cursor = offset + bytes;
+    return offset;
+}
+
+// Ritka tárolásnál a cellatömbök lapra igazítottak (a darabok lapjai külön visszaadhatók)
+static size_t reserve_page(size_t *cursor, size_t bytes)
+{
+    size_t offset = align_up(*cursor, (size_t)sysconf(_SC_PAGESIZE));
+    *cursor = offset + bytes;
+    return offset;
+}
+
+// Ritka tárolásnál (chunked) a sorok távolsága a darabszélesség többszöröse, és a szabad cellák
+// indexének nincs cellabittérképe, csak soronkénti számai (a soron belül a darabkönyvtár keres)
+static ArenaLayout compute_layout(int width, int height, int entity_capacity, bool chunked)
+{
+    ArenaLayout layout;
+    size_t cursor = 0;
+    size_t cells = (size_t)(chunked ? world_chunks_stride(width) : width) * height;
+    layout.world = reserve(&cursor, sizeof(World));
+    layout.arena = reserve(&cursor, sizeof(WorldArena));
+    layout.grid_rows = reserve(&cursor, (size_t)height * sizeof(Cell *));
+    layout.next_grid_rows = reserve(&cursor, (size_t)height * sizeof(Cell *));
+    layout.grid_cells = chunked ? reserve_page(&cursor, cells * sizeof(Cell)) : reserve(&cursor, cells * sizeof(Cell));
+    layout.next_grid_cells = chunked ? reserve_page(&cursor, cells * sizeof(Cell)) : reserve(&cursor, cells * sizeof(Cell));
+    layout.entities = reserve(&cursor, (size_t)entity_capacity * sizeof(Entity));
+    layout.next_entities = reserve(&cursor, (size_t)entity_capacity * sizeof(Entity));
+    layout.lifecycle = reserve(&cursor, lifecycle_buffers_storage_size(entity_capacity));
+    layout.free_cells = reserve(&cursor, free_cell_index_storage_size(width, height, chunked));
+    layout.perception = reserve(&cursor, (size_t)entity_capacity * sizeof(Perception));
+    layout.total = align_up(cursor, ARENA_ALIGNMENT);
+    return layout;
+}
+
+// Az aréna régióinak elszámolása alrendszerenként (sign > 0: leképezés, < 0: felszabadítás).
+// A régiók közti igazítási rés az előző régióé, a nagy lapos kerekítés a MEMORY_WORLD-é. Ritka
+// tárolásnál a cellatömbök kimaradnak: a darabjaikat a könyvtár számolja el, ahogy lefoglalódnak.
+static void account_layout(const ArenaLayout *layout, size_t size, bool chunked, int sign)
+{
+    const struct
+    {
+        MemorySubsystem subsystem;
+        size_t bytes;
+    } regions[] = {
+        {MEMORY_WORLD, layout->grid_cells - layout->world},
+        {MEMORY_GRIDS, chunked ? 0 : layout->entities - layout->grid_cells},
+        {MEMORY_ENTITIES, layout->lifecycle - layout->entities},
+        {MEMORY_LIFECYCLE, layout->free_cells - layout->lifecycle},
+        {MEMORY_FREE_CELLS, layout->perception - layout->free_cells},
+        {MEMORY_PERCEPTION, layout->total - layout->perception},
+        {MEMORY_WORLD, size - layout->total},
+    };
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++)
+    {
+        if (sign > 0)
+            memory_note_mapped(regions[i].subsystem, regions[i].bytes);
+        else
+            memory_release(regions[i].subsystem, regions[i].bytes);
+    }
+}
+
+// Párhuzamos kiürítés/first-touch: a rács sorait és az entitástömböket statikus felosztásban
+// ugyanazok a szálak érintik, amelyek a lépésekben is dolgoznak rajtuk, így NUMA gépen a lapok
+// a feldolgozó szál csomópontjára kerülnek.
+// Ritka tárolásnál a rácsokat nem érintjük: a le nem foglalt lapok nullák, a lefoglaltakat a
+// könyvtár adja vissza.
+static void clear_buffers(World *world)
+{
+    int width = world->width;
+    int height = world->height;
+    Cell *grid_cells = world->grid[0];
+    Cell *next_grid_cells = world->next_grid[0];
+    if (world->chunks)
+        world_chunks_release_all(world);
+    else
+    {
+#pragma omp parallel for schedule(static)
+        for (int y = 0; y < height; y++)
+        {
+            memset(&grid_cells[(size_t)y * width], 0, (size_t)width * sizeof(Cell));
+            memset(&next_grid_cells[(size_t)y * width], 0, (size_t)width * sizeof(Cell));
+        }
+    }
+
+    int capacity = world->entity_capacity;
+#pragma omp parallel
+    {
+        int thread_id = omp_get_thread_num();
+        int thread_count = omp_get_num_threads();
+        int begin = (int)((long long)capacity * thread_id / thread_count);
+        int end = (int)((long long)capacity * (thread_id + 1) / thread_count);
+        memset(&world->entities[begin], 0, (size_t)(end - begin) * sizeof(Entity));
+        memset(&world->next_entities[begin], 0, (size_t)(end - begin) * sizeof(Entity));
+    }
+}
+
+World *world_arena_create(int width, int height, int entity_capacity, bool huge_pages, bool chunked)
+{
+    if (chunked && huge_pages)
+    {
+        // Nagy lapokon egy darab nem adható vissza külön, és az első írás 2 MiB-ot foglalna le
+        fprintf(stderr, "Figyelem: ritka rácstárolásnál a nagy lapok nem használhatók, kikapcsolva.\n");
+        huge_pages = false;
+    }
+    ArenaLayout layout = compute_layout(width, height, entity_capacity, chunked);
+    size_t size = huge_pages ? align_up(layout.total, HUGE_PAGE_SIZE) : layout.total;
+    // Ritka tárolásnál a cellatömbök csak a lakott darabokkal arányosan foglalódnak le
+    size_t committed = chunked ? size - (layout.entities - layout.grid_cells) : size;
+    if (!memory_budget_allows(committed))
+    {
+        MemoryUsage used = memory_total_usage();
+        fprintf(stderr, "Hiba: a világ arénája (%zu bájt) nem fér bele a memóriakeretbe (%zu bájt, ebből foglalt %zu).\n",
+                committed, memory_budget(), used.current);
+        errno = ENOMEM;
+        return NULL;
+    }
+    ChunkDirectory *chunks = NULL;
+    if (chunked && !(chunks = world_chunks_create(width, height, entity_capacity)))
+        return NULL;
+
+    void *base = MAP_FAILED;
+    bool hugetlb = false;
+#ifdef MAP_HUGETLB
+    if (huge_pages)
+    {
+        // Előre lefoglalt nagy lapok (vm.nr_hugepages); ha nincs, átlátszó nagy lapokkal próbálkozunk
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugetlb = base != MAP_FAILED;
+    }
+#endif
+    // Ritka tárolásnál a teljes (virtuális) rácsnak nem kell swap-fedezet (MAP_NORESERVE)
+    if (base == MAP_FAILED)
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | (chunked ? MAP_NORESERVE : 0), -1, 0);
+    if (base == MAP_FAILED)
+    {
+        perror("Hiba a világ arénájának leképezésekor");
+        world_chunks_free(chunks);
+        return NULL;
+    }
+    bool transparent = false;
+#ifdef MADV_HUGEPAGE
+    if (huge_pages && !hugetlb)
+        transparent = madvise(base, size, MADV_HUGEPAGE) == 0;
+#endif
+
+    unsigned char *bytes = (unsigned char *)base;
+    World *world = (World *)(bytes + layout.world);
+    WorldArena *arena = (WorldArena *)(bytes + layout.arena);
+    arena->base = base;
+    arena->size = size;
+    arena->huge_pages = hugetlb;
+    arena->transparent_huge = transparent;
+    arena->entity_capacity = entity_capacity;
+    arena->chunked = chunked;
+    account_layout(&layout, size, chunked, 1);
+
+    world->arena = arena;
+    world->width = width;
+    world->height = height;
+    world->entity_capacity = entity_capacity;
+    world->next_entity_capacity = entity_capacity;
+    world->grid = (Cell **)(bytes + layout.grid_rows);
+    world->next_grid = (Cell **)(bytes + layout.next_grid_rows);
+    Cell *grid_cells = (Cell *)(bytes + layout.grid_cells);
+    Cell *next_grid_cells = (Cell *)(bytes + layout.next_grid_cells);
+    int stride = chunked ? chunks->stride : width;
+    for (int y = 0; y < height; y++)
+    {
+        world->grid[y] = &grid_cells[(size_t)y * stride];
+        world->next_grid[y] = &next_grid_cells[(size_t)y * stride];
+    }
+    world->entities = (Entity *)(bytes + layout.entities);
+    world->next_entities = (Entity *)(bytes + layout.next_entities);
+    world->lifecycle = lifecycle_buffers_create_in(entity_capacity, bytes + layout.lifecycle);
+    world->free_cells = free_cell_index_create_in(width, height, chunked, bytes + layout.free_cells);
+    world->perception = (Perception *)(bytes + layout.perception);
+    world->chunks = chunks;
+
+    clear_buffers(world);
+    return world;
+}
+
+void world_arena_destroy(World *world)
+{
+    if (!world || !world->arena)
+        return;
+    // A leírót előbb kimásoljuk, mert maga is a leképezésben van
+    WorldArena arena = *world->arena;
+    ArenaLayout layout = compute_layout(world->width, world->height, arena.entity_capacity, arena.chunked);
+    world_chunks_free(world->chunks);
+    munmap(arena.base, arena.size);
+    account_layout(&layout, arena.size, arena.chunked, -1);
+}
+
+void world_arena_clear(World *world)
+{
+    clear_buffers(world);
+    free_cell_index_invalidate(world->free_cells);
+}
@@ -0,0 +1,36 @@
+#ifndef WORLD_ARENA_H
+#define WORLD_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "datatypes.h" // Szükséges a World típushoz
+
+// A világ összes mérethez kötött puffere (a World struktúra, a két rács sormutatói és cellái,
+// a két entitástömb és az életciklus segédtömbjei) egyetlen igazított mmap leképezésben.
+// Így a létrehozás és a felszabadítás egy-egy rendszerhívás, az adatok egymás mellett vannak,
+// opcionálisan nagy lapokon (MAP_HUGETLB, ennek hiányában madvise(MADV_HUGEPAGE)).
+struct WorldArena
+{
+    void *base;            // A leképezés kezdete (itt van maga a World struktúra is)
+    size_t size;           // A leképezés mérete bájtban
+    bool huge_pages;       // MAP_HUGETLB-vel sikerült leképezni
+    bool transparent_huge; // Átlátszó nagy lapokat kértünk (madvise)
+    int entity_capacity;   // A leképezés entitáskapacitása (a World kapacitásmezői a lépésekben cserélődnek)
+    bool chunked;          // Ritka (darabolt) rácstárolás: lusta cellatömbök (lásd world_chunks.h)
+};
+
+// Leképezi az arénát és beköti a World mutatóit (grid, next_grid, entities, next_entities, lifecycle,
+// free_cells, perception).
+// A többi mezőt a hívó inicializálja. A lapokat párhuzamosan, a későbbi feldolgozással egyező
+// statikus felosztásban érintjük először (first-touch). A régiók a memóriaelszámolásban
+// alrendszerenként jelennek meg; ha a leképezés nem fér bele a memóriakeretbe, nem képezünk le
+// semmit (lásd memory_accounting.h). chunked: ritka rácstárolás (MAP_NORESERVE, first-touch nélküli
+// cellatömbök és darabkönyvtár; a keret csak a többi régióra vonatkozik). Hiba esetén NULL.
+World *world_arena_create(int width, int height, int entity_capacity, bool huge_pages, bool chunked);
+// Az aréna felszabadítása (a World struktúra is megszűnik).
+void world_arena_destroy(World *world);
+// A rácsok és az entitástömbök párhuzamos kiürítése (újrahasznosításhoz).
+void world_arena_clear(World *world);
+
+#endif // WORLD_ARENA_H
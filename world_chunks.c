@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <omp.h>
+
+#include "world_chunks.h"
+#include "free_cell_index.h"
+#include "memory_accounting.h"
+
+// A darabszélesség: legalább WORLD_CHUNK_MIN_WIDTH cella, és a lapméret egész többszöröse
+int world_chunks_width(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    int page_cells = page > 0 ? (int)(page / (long)sizeof(Cell)) : WORLD_CHUNK_MIN_WIDTH;
+    if (page_cells < 1)
+        page_cells = 1;
+    return (WORLD_CHUNK_MIN_WIDTH + page_cells - 1) / page_cells * page_cells;
+}
+
+int world_chunks_stride(int width)
+{
+    int chunk_width = world_chunks_width();
+    return (width + chunk_width - 1) / chunk_width * chunk_width;
+}
+
+// Egy darabsor (lapjainak) mérete bájtban
+static size_t row_bytes(const ChunkDirectory *directory)
+{
+    return (size_t)directory->chunk_width * sizeof(Cell);
+}
+
+ChunkDirectory *world_chunks_create(int width, int height, int entity_capacity)
+{
+    ChunkDirectory *directory = (ChunkDirectory *)memory_calloc(MEMORY_GRIDS, 1, sizeof(ChunkDirectory));
+    if (!directory)
+    {
+        perror("Hiba a darabkönyvtár foglalásakor");
+        return NULL;
+    }
+    directory->chunk_width = world_chunks_width();
+    directory->chunk_height = WORLD_CHUNK_HEIGHT;
+    directory->stride = world_chunks_stride(width);
+    directory->columns = directory->stride / directory->chunk_width;
+    directory->rows = (height + directory->chunk_height - 1) / directory->chunk_height;
+    directory->width = width;
+    directory->height = height;
+    directory->chunk_count = (long long)directory->columns * directory->rows;
+    // Egy puffer két kiürítés között legfeljebb egy lépés véglegesítéseit és a következő lépés
+    // spawnjait kapja, ezek együtt sem haladják meg a kapacitás kétszeresét
+    directory->written_capacity = 2LL * (entity_capacity > 0 ? entity_capacity : 1);
+
+    bool ok = true;
+    for (int buffer = 0; buffer < 2; buffer++)
+    {
+        directory->touched[buffer] = (unsigned char *)memory_calloc(MEMORY_GRIDS, (size_t)directory->chunk_count, 1);
+        directory->pages[buffer] = (unsigned long long *)memory_calloc(MEMORY_GRIDS, (size_t)directory->chunk_count, sizeof(unsigned long long));
+        directory->idle[buffer] = (unsigned char *)memory_calloc(MEMORY_GRIDS, (size_t)directory->chunk_count, 1);
+        directory->written[buffer] = (long long *)memory_malloc(MEMORY_GRIDS, (size_t)directory->written_capacity * sizeof(long long));
+        ok = ok && directory->touched[buffer] && directory->pages[buffer] && directory->idle[buffer] && directory->written[buffer];
+    }
+    if (!ok)
+    {
+        perror("Hiba a darabkönyvtár tömbjeinek foglalásakor");
+        world_chunks_free(directory);
+        return NULL;
+    }
+    return directory;
+}
+
+void world_chunks_free(ChunkDirectory *directory)
+{
+    if (!directory)
+        return;
+    for (int buffer = 0; buffer < 2; buffer++)
+    {
+        // A lefoglalt lapok a leképezéssel együtt szűnnek meg; az elszámolásukat itt vesszük vissza
+        memory_release(MEMORY_GRIDS, (size_t)directory->resident_pages[buffer] * row_bytes(directory));
+        memory_free(MEMORY_GRIDS, directory->touched[buffer]);
+        memory_free(MEMORY_GRIDS, directory->pages[buffer]);
+        memory_free(MEMORY_GRIDS, directory->idle[buffer]);
+        memory_free(MEMORY_GRIDS, directory->written[buffer]);
+    }
+    memory_free(MEMORY_GRIDS, directory);
+}
+
+void world_chunks_note_page(ChunkDirectory *directory, int buffer, bool first)
+{
+    // A lap az írással foglalódik le, ezért itt nem lehet visszautasítani: a keret nem korlátozza
+    memory_note_mapped(MEMORY_GRIDS, row_bytes(directory));
+    __atomic_add_fetch(&directory->resident_pages[buffer], 1, __ATOMIC_RELAXED);
+    if (!first)
+        return;
+    long long resident = __atomic_add_fetch(&directory->resident_count[buffer], 1, __ATOMIC_RELAXED) +
+                         __atomic_load_n(&directory->resident_count[1 - buffer], __ATOMIC_RELAXED);
+    long long peak = __atomic_load_n(&directory->peak_resident, __ATOMIC_RELAXED);
+    while (resident > peak &&
+           !__atomic_compare_exchange_n(&directory->peak_resident, &peak, resident, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+bool world_chunks_resident(const World *world, int x, int y)
+{
+    const ChunkDirectory *directory = world->chunks;
+    if (!directory)
+        return true;
+    long long chunk = (long long)(y / directory->chunk_height) * directory->columns + x / directory->chunk_width;
+    return directory->pages[WORLD_CHUNKS_CURRENT][chunk] != 0;
+}
+
+// A darab sorainak első cellája és a benne lévő sorok száma egy pufferben
+static Cell *chunk_origin(const ChunkDirectory *directory, Cell *cells, long long chunk, int *rows)
+{
+    int y0 = (int)(chunk / directory->columns) * directory->chunk_height;
+    int x0 = (int)(chunk % directory->columns) * directory->chunk_width;
+    *rows = directory->height - y0 < directory->chunk_height ? directory->height - y0 : directory->chunk_height;
+    return &cells[(size_t)y0 * directory->stride + x0];
+}
+
+void world_chunks_clear_next(World *world)
+{
+    ChunkDirectory *directory = world->chunks;
+    Cell *cells = world->next_grid[0];
+    unsigned char *touched = directory->touched[WORLD_CHUNKS_NEXT];
+    long long written_count = directory->written_count[WORLD_CHUNKS_NEXT];
+    if (written_count <= directory->written_capacity)
+    {
+        // A naplózott cellák nullázása; a darab jelzőjét több bejegyzés is nullázhatja
+        const long long *written = directory->written[WORLD_CHUNKS_NEXT];
+#pragma omp parallel for schedule(static)
+        for (long long k = 0; k < written_count; k++)
+        {
+            long long offset = written[k];
+            cells[offset].entity = NULL;
+            long long chunk = offset / directory->stride / directory->chunk_height * directory->columns +
+                              offset % directory->stride / directory->chunk_width;
+            __atomic_store_n(&touched[chunk], 0, __ATOMIC_RELAXED);
+        }
+    }
+    else
+    {
+        // Betelt napló: az érintett darabok lefoglalt sorainak teljes kiürítése
+        const unsigned long long *pages = directory->pages[WORLD_CHUNKS_NEXT];
+#pragma omp parallel for schedule(dynamic, 64)
+        for (long long chunk = 0; chunk < directory->chunk_count; chunk++)
+        {
+            if (!touched[chunk])
+                continue;
+            int rows;
+            Cell *origin = chunk_origin(directory, cells, chunk, &rows);
+            for (int row = 0; row < rows; row++)
+                if (pages[chunk] & (1ULL << row))
+                    memset(&origin[(size_t)row * directory->stride], 0, row_bytes(directory));
+            touched[chunk] = 0;
+        }
+    }
+    directory->written_count[WORLD_CHUNKS_NEXT] = 0;
+}
+
+// A darab lefoglalt sorai lapjainak visszaadása (a tartalmuk a következő íráskor nullákkal jön vissza)
+static void release_chunk(ChunkDirectory *directory, Cell *cells, int buffer, long long chunk)
+{
+    int rows;
+    Cell *origin = chunk_origin(directory, cells, chunk, &rows);
+    unsigned long long pages = directory->pages[buffer][chunk];
+    for (int row = 0; row < rows; row++)
+    {
+        if (!(pages & (1ULL << row)))
+            continue;
+        if (madvise(&origin[(size_t)row * directory->stride], row_bytes(directory), MADV_DONTNEED) != 0)
+        {
+            // A lapok maradnak (a tartalmuk nulla), a darab továbbra is lefoglaltnak számít
+            perror("Hiba a rácsdarab visszaadásakor");
+            return;
+        }
+    }
+    int page_count = __builtin_popcountll(pages);
+    directory->pages[buffer][chunk] = 0;
+    directory->touched[buffer][chunk] = 0;
+    directory->idle[buffer][chunk] = 0;
+    memory_release(MEMORY_GRIDS, (size_t)page_count * row_bytes(directory));
+    __atomic_sub_fetch(&directory->resident_pages[buffer], page_count, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&directory->resident_count[buffer], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&directory->released, 1, __ATOMIC_RELAXED);
+}
+
+void world_chunks_reclaim_next(World *world)
+{
+    ChunkDirectory *directory = world->chunks;
+    Cell *cells = world->next_grid[0];
+    const unsigned long long *pages = directory->pages[WORLD_CHUNKS_NEXT];
+    unsigned char *touched = directory->touched[WORLD_CHUNKS_NEXT];
+    unsigned char *idle = directory->idle[WORLD_CHUNKS_NEXT];
+#pragma omp parallel for schedule(dynamic, 64)
+    for (long long chunk = 0; chunk < directory->chunk_count; chunk++)
+    {
+        if (!pages[chunk])
+            continue;
+        if (touched[chunk])
+            idle[chunk] = 0;
+        else if (++idle[chunk] >= WORLD_CHUNK_IDLE_CYCLES)
+            release_chunk(directory, cells, WORLD_CHUNKS_NEXT, chunk); // A kiürítés óta üres: nincs mit megőrizni
+    }
+}
+
+void world_chunks_swap(ChunkDirectory *directory)
+{
+    if (!directory)
+        return;
+    unsigned char *touched = directory->touched[0];
+    directory->touched[0] = directory->touched[1];
+    directory->touched[1] = touched;
+    unsigned long long *pages = directory->pages[0];
+    directory->pages[0] = directory->pages[1];
+    directory->pages[1] = pages;
+    unsigned char *idle = directory->idle[0];
+    directory->idle[0] = directory->idle[1];
+    directory->idle[1] = idle;
+    long long *written = directory->written[0];
+    directory->written[0] = directory->written[1];
+    directory->written[1] = written;
+    long long count = directory->written_count[0];
+    directory->written_count[0] = directory->written_count[1];
+    directory->written_count[1] = count;
+    count = directory->resident_count[0];
+    directory->resident_count[0] = directory->resident_count[1];
+    directory->resident_count[1] = count;
+    count = directory->resident_pages[0];
+    directory->resident_pages[0] = directory->resident_pages[1];
+    directory->resident_pages[1] = count;
+}
+
+void world_chunks_release_all(World *world)
+{
+    ChunkDirectory *directory = world->chunks;
+    Cell *cells[2] = {world->grid[0], world->next_grid[0]};
+    for (int buffer = 0; buffer < 2; buffer++)
+    {
+        for (long long chunk = 0; chunk < directory->chunk_count; chunk++)
+            if (directory->pages[buffer][chunk])
+                release_chunk(directory, cells[buffer], buffer, chunk);
+        directory->written_count[buffer] = 0;
+    }
+}
+
+bool world_chunks_select_free_cell(const World *world, long long k, Coordinates *out_pos)
+{
+    const ChunkDirectory *directory = world->chunks;
+    int y, rank;
+    if (!free_cell_index_select_row(world->free_cells, k, &y, &rank))
+        return false;
+
+    // A sor darabjain balról jobbra: ahol a sor lapja nincs lefoglalva, ott minden cella üres
+    long long chunk = (long long)(y / directory->chunk_height) * directory->columns;
+    unsigned long long row = 1ULL << (y % directory->chunk_height);
+    for (int x0 = 0; x0 < world->width; x0 += directory->chunk_width, chunk++)
+    {
+        int x1 = x0 + directory->chunk_width < world->width ? x0 + directory->chunk_width : world->width;
+        if (!(directory->pages[WORLD_CHUNKS_CURRENT][chunk] & row))
+        {
+            if (rank < x1 - x0)
+            {
+                out_pos->x = x0 + rank;
+                out_pos->y = y;
+                return true;
+            }
+            rank -= x1 - x0;
+            continue;
+        }
+        for (int x = x0; x < x1; x++)
+        {
+            if (world->grid[y][x].entity != NULL)
+                continue;
+            if (rank-- == 0)
+            {
+                out_pos->x = x;
+                out_pos->y = y;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void world_chunks_report(const World *world, FILE *out)
+{
+    const ChunkDirectory *directory = world ? world->chunks : NULL;
+    if (!directory)
+        return;
+    double chunk_kb = (double)directory->chunk_height * row_bytes(directory) / 1024.0;
+    long long resident = directory->resident_count[0] + directory->resident_count[1];
+    long long pages = directory->resident_pages[0] + directory->resident_pages[1];
+    fprintf(out, "Ritka rács: %lld darab (%dx%d cella, %.0f KiB), lefoglalva most %lld darab %lld sora (%.1f MiB), "
+                 "csúcs %lld darab, visszaadva %lld; sűrű tárolással %.1f MiB lenne\n",
+            directory->chunk_count, directory->chunk_width, directory->chunk_height, chunk_kb, resident, pages,
+            pages * (double)row_bytes(directory) / (1024.0 * 1024.0), directory->peak_resident, directory->released,
+            2.0 * directory->chunk_count * chunk_kb / 1024.0);
+}
@@ -0,0 +1,114 @@
+#ifndef WORLD_CHUNKS_H
+#define WORLD_CHUNKS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "datatypes.h" // Szükséges a World, Cell, Coordinates típusokhoz
+
+// Darabolt (ritka) rácstárolás nagy, nagyrészt üres világokhoz. A két rács továbbra is
+// sorfolytonos (grid[y][x], a sorok távolsága a stride), de a cellatömbök leképezése lusta
+// (MAP_NORESERVE, first-touch nélkül): egy lap csak az első írásakor foglalódik le. A rács
+// chunk_width × chunk_height méretű darabokra oszlik; a darab egy sora egész számú lap, így egy
+// darab lapjai a többitől függetlenül visszaadhatók (madvise(MADV_DONTNEED)).
+//
+// A darabkönyvtár pufferenként (grid, next_grid) darabonként jelzi, hogy a legutóbbi kiürítés óta
+// írtak-e bele (touched), és hogy mely sorainak lapjai vannak lefoglalva (pages: soronként egy
+// bit, a darab 64 sora egy szó; a lefoglalt lapok elszámolása így pontos). Az írt cellák
+// eltolásai pufferenként egy naplóba is kerülnek, így a lépés eleji kiürítés csak ezeket a
+// cellákat nullázza (nem a teljes W*H rácsot, és nem is a darabok üres lapjait; ha a napló
+// betelt, az érintett darabok teljes kiürítése a tartalék). A lépés végén az a lefoglalt darab,
+// amelybe WORLD_CHUNK_IDLE_CYCLES egymás utáni ciklusban nem került entitás, visszaadja a lapjait.
+// A memória és a lépésenkénti rácsmunka így a lakott területtel arányos; a könyvtár bejárása
+// darabonként és pufferenként tíz bájt (egy darab 32768 cella).
+//
+// A fázisok eleve az entitáslistákon (a túlélőkön) iterálnak, nem a cellákon. A sűrű
+// növényréteg W*H méretű, ezért ritka tárolásnál nem kapcsolható be; a szabad cellák indexe
+// cellabittérkép nélkül, csak soronkénti számokkal él, a soron belüli keresés a könyvtár mentén.
+// A rácsba író helyeknek a world_chunks_note_write-ot kell hívniuk.
+
+#define WORLD_CHUNK_MIN_WIDTH 512  // Cellában; 4 KiB-os lapon egy lap (sizeof(Cell) == 8)
+#define WORLD_CHUNK_HEIGHT 64      // Sorban; a sorok bitmaszkja egy 64 bites szó
+#define WORLD_CHUNK_IDLE_CYCLES 4  // Ennyi üres ciklus (pufferenként) után a darab lapjai visszaadódnak
+
+#define WORLD_CHUNKS_CURRENT 0 // A grid pufferének indexe a könyvtárban
+#define WORLD_CHUNKS_NEXT 1    // A next_grid pufferéé
+
+struct ChunkDirectory
+{
+    int chunk_width;  // Cellában, a lapméret egész többszöröse
+    int chunk_height; // Sorban
+    int columns;      // Darabok vízszintesen
+    int rows;         // Darabok függőlegesen
+    int stride;       // A rácssorok távolsága cellában (columns * chunk_width)
+    int width;        // A világ mérete (a szélső darabok rövidebbek lehetnek)
+    int height;
+    long long chunk_count;
+    unsigned char *touched[2];  // [puffer][darab]: írtak bele a legutóbbi kiürítés óta
+    unsigned long long *pages[2]; // [puffer][darab]: a lefoglalt (és elszámolt) sorok bitmaszkja
+    unsigned char *idle[2];     // [puffer][darab]: egymás utáni üres ciklusok
+    long long *written[2];      // [puffer]: a kiürítés óta írt cellák eltolása (y * stride + x)
+    long long written_count[2]; // A naplóba kért bejegyzések (a kapacitás fölött a napló betelt)
+    long long written_capacity;
+    long long resident_count[2]; // Lefoglalt (legalább egy lapos) darabok
+    long long resident_pages[2];
+    long long peak_resident;    // A két puffer együttes csúcsa darabban
+    long long released;         // Visszaadott darabok összesen
+};
+
+// A rácssorok távolsága ritka tárolásnál (a szélesség a darabszélesség többszörösére kerekítve).
+int world_chunks_stride(int width);
+int world_chunks_width(void);
+
+// A könyvtár létrehozása és felszabadítása (a világ arénája hívja; a lefoglalt darabok
+// elszámolását a felszabadítás visszaveszi). Az írásnapló az entitáskapacitáshoz méretezett.
+ChunkDirectory *world_chunks_create(int width, int height, int entity_capacity);
+void world_chunks_free(ChunkDirectory *directory);
+
+// Egy darabsor lapjának lefoglalását rögzíti (elszámolás; first: a darab első lapja); a
+// world_chunks_note_write hívja.
+void world_chunks_note_page(ChunkDirectory *directory, int buffer, bool first);
+
+// Írás a rács egy cellájába (buffer: WORLD_CHUNKS_CURRENT vagy WORLD_CHUNKS_NEXT). Párhuzamos
+// régióból is hívható; sűrű tárolásnál (world->chunks == NULL) nem csinál semmit.
+static inline void world_chunks_note_write(World *world, int buffer, int x, int y)
+{
+    ChunkDirectory *directory = world->chunks;
+    if (!directory)
+        return;
+    long long chunk = (long long)(y / directory->chunk_height) * directory->columns + x / directory->chunk_width;
+    if (!__atomic_load_n(&directory->touched[buffer][chunk], __ATOMIC_RELAXED))
+        __atomic_store_n(&directory->touched[buffer][chunk], 1, __ATOMIC_RELAXED);
+    unsigned long long row = 1ULL << (y % directory->chunk_height);
+    if (!(__atomic_load_n(&directory->pages[buffer][chunk], __ATOMIC_RELAXED) & row))
+    {
+        unsigned long long old = __atomic_fetch_or(&directory->pages[buffer][chunk], row, __ATOMIC_RELAXED);
+        if (!(old & row))
+            world_chunks_note_page(directory, buffer, old == 0);
+    }
+    long long slot = __atomic_fetch_add(&directory->written_count[buffer], 1, __ATOMIC_RELAXED);
+    if (slot < directory->written_capacity)
+        directory->written[buffer][slot] = (long long)y * directory->stride + x;
+}
+
+// Igaz, ha a cella darabja a grid-ben le van foglalva (egyébként biztosan üres).
+bool world_chunks_resident(const World *world, int x, int y);
+
+// A lépés eleji kiürítés: a next_grid naplózott cellái (betelt naplónál az érintett darabjai).
+void world_chunks_clear_next(World *world);
+// A lépés végén (a csere előtt) a next_grid üresen maradt darabjainak öregítése és visszaadása.
+void world_chunks_reclaim_next(World *world);
+// A pufferek cseréje a grid és a next_grid cseréjével együtt.
+void world_chunks_swap(ChunkDirectory *directory);
+// Minden darab visszaadása (a világ újrahasznosításakor).
+void world_chunks_release_all(World *world);
+
+// A grid k. (0-tól számozott) üres cellája sorfolytonos sorrendben, a szabad cellák indexének
+// soronkénti számaiból (a sűrű free_cell_index_select megfelelője). Hamis, ha k túl nagy.
+bool world_chunks_select_free_cell(const World *world, long long k, Coordinates *out_pos);
+
+// Összegzés: darabok, lefoglalt darabok és memória, visszaadott darabok.
+void world_chunks_report(const World *world, FILE *out);
+
+#endif // WORLD_CHUNKS_H
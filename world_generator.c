@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <omp.h>
+
+#include "world_generator.h"
+#include "simulation_constants.h"
+#include "sim_random.h"
+#include "free_cell_index.h"
+#include "species.h"
+#include "memory_accounting.h"
+#include "world_chunks.h"
+
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15ULL // splitmix64 lépésköz
+
+// PGM fejléc következő számmezője (a '#' kezdetű megjegyzéseket átugorja)
+static bool read_pgm_field(FILE *file, int *out_value)
+{
+    int c = fgetc(file);
+    while (c != EOF && (isspace(c) || c == '#'))
+    {
+        if (c == '#')
+            while (c != EOF && c != '\n')
+                c = fgetc(file);
+        c = fgetc(file);
+    }
+    if (c == EOF || !isdigit(c))
+        return false;
+    int value = 0;
+    while (c != EOF && isdigit(c))
+    {
+        value = value * 10 + (c - '0');
+        c = fgetc(file);
+    }
+    *out_value = value;
+    return true; // A számot lezáró egyetlen szóközt a fgetc már elfogyasztotta
+}
+
+DensityMap *density_map_load_pgm(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        perror("Hiba a sűrűségtérkép megnyitásakor");
+        return NULL;
+    }
+    char magic[2];
+    int width = 0, height = 0, max_value = 0;
+    if (fread(magic, 1, 2, file) != 2 || magic[0] != 'P' || (magic[1] != '2' && magic[1] != '5') ||
+        !read_pgm_field(file, &width) || !read_pgm_field(file, &height) || !read_pgm_field(file, &max_value) ||
+        width <= 0 || height <= 0 || max_value <= 0 || max_value > 65535)
+    {
+        fprintf(stderr, "Hiba: a sűrűségtérkép nem érvényes PGM (P2/P5) kép: %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    DensityMap *map = (DensityMap *)memory_malloc(MEMORY_GENERATOR, sizeof(DensityMap));
+    float *values = (float *)memory_malloc(MEMORY_GENERATOR, (size_t)width * height * sizeof(float));
+    if (!map || !values)
+    {
+        perror("Hiba a sűrűségtérkép foglalásakor");
+        memory_free(MEMORY_GENERATOR, map);
+        memory_free(MEMORY_GENERATOR, values);
+        fclose(file);
+        return NULL;
+    }
+    map->width = width;
+    map->height = height;
+    map->values = values;
+
+    bool ok = true;
+    size_t cells = (size_t)width * height;
+    for (size_t i = 0; i < cells && ok; i++)
+    {
+        int value = 0;
+        if (magic[1] == '2')
+        {
+            ok = read_pgm_field(file, &value);
+        }
+        else
+        {
+            int high = fgetc(file);
+            int low = max_value > 255 ? fgetc(file) : 0;
+            ok = high != EOF && low != EOF;
+            value = max_value > 255 ? (high << 8) | low : high;
+        }
+        values[i] = (float)(value > max_value ? max_value : value) / (float)max_value;
+    }
+    fclose(file);
+    if (!ok)
+    {
+        fprintf(stderr, "Hiba: a sűrűségtérkép képadatai hiányosak: %s\n", path);
+        density_map_free(map);
+        return NULL;
+    }
+    return map;
+}
+
+void density_map_free(DensityMap *map)
+{
+    if (!map)
+        return;
+    memory_free(MEMORY_GENERATOR, map->values);
+    memory_free(MEMORY_GENERATOR, map);
+}
+
+// A térkép értéke a világ (x, y) cellájára, legközelebbi szomszéd skálázással
+static float density_at(const DensityMap *map, const World *world, int x, int y)
+{
+    int map_x = (int)((long long)x * map->width / world->width);
+    int map_y = (int)((long long)y * map->height / world->height);
+    return map->values[(size_t)map_y * map->width + map_x];
+}
+
+// Számláló alapú véletlen: a csempe kulcsa és a sorszám együtt határozza meg az értéket
+static unsigned long long tile_random(unsigned long long key, unsigned long long *counter)
+{
+    return sim_random_mix64(key + (++*counter) * GOLDEN_GAMMA);
+}
+
+static double tile_uniform(unsigned long long key, unsigned long long *counter)
+{
+    return (double)(tile_random(key, counter) >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+}
+
+typedef struct
+{
+    int tiles_x;
+    int tiles_y;
+    int tile_count;
+} TileGrid;
+
+static void tile_bounds(const World *world, const TileGrid *tiles, int tile, int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = (tile % tiles->tiles_x) * GENERATOR_TILE;
+    *y0 = (tile / tiles->tiles_x) * GENERATOR_TILE;
+    *x1 = *x0 + GENERATOR_TILE < world->width ? *x0 + GENERATOR_TILE : world->width;
+    *y1 = *y0 + GENERATOR_TILE < world->height ? *y0 + GENERATOR_TILE : world->height;
+}
+
+// Egy típus létszámának szétosztása a csempék között a súlyok arányában. A kumulatív
+// kerekítés (floor(N*S_i/S) különbségei) pontosan N-et ad össze, rendezés nélkül.
+static void distribute_count(const World *world, const TileGrid *tiles, const DensityMap *map, int count,
+                             double *weights, int *quota)
+{
+#pragma omp parallel for schedule(static)
+    for (int tile = 0; tile < tiles->tile_count; tile++)
+    {
+        int x0, y0, x1, y1;
+        tile_bounds(world, tiles, tile, &x0, &y0, &x1, &y1);
+        double weight = 0.0;
+        if (map)
+        {
+            for (int y = y0; y < y1; y++)
+                for (int x = x0; x < x1; x++)
+                    weight += density_at(map, world, x, y);
+        }
+        else
+        {
+            weight = (double)(x1 - x0) * (y1 - y0);
+        }
+        weights[tile] = weight;
+    }
+
+    double total = 0.0;
+    for (int tile = 0; tile < tiles->tile_count; tile++)
+        total += weights[tile];
+    if (total <= 0.0)
+    {
+        // Üres térkép: a típus nem kap helyet
+        for (int tile = 0; tile < tiles->tile_count; tile++)
+            quota[tile] = 0;
+        return;
+    }
+
+    double cumulative = 0.0;
+    long long previous = 0;
+    for (int tile = 0; tile < tiles->tile_count; tile++)
+    {
+        cumulative += weights[tile];
+        long long upto = tile == tiles->tile_count - 1 ? count : (long long)((double)count * cumulative / total);
+        if (upto > count)
+            upto = count;
+        quota[tile] = (int)(upto - previous);
+        previous = upto;
+    }
+}
+
+static void init_generated_entity(Entity *entity, int id, EntityType type, int x, int y)
+{
+    entity->id = id;
+    entity->type = type;
+    entity->position.x = x;
+    entity->position.y = y;
+    entity->age = 0;
+    entity->last_reproduction_step = -1;
+    entity->last_eating_step = -1;
+    entity->just_spawned_by_keypress = false;
+    entity->energy = species_table[type].initial_energy;
+    entity->sight_range = species_table[type].sight_range;
+}
+
+bool generate_world_bulk(World *world, const int counts[ENTITY_TYPE_COUNT],
+                         const DensityMap *const density[ENTITY_TYPE_COUNT], unsigned long long seed)
+{
+    if (!world || world->entity_count != 0)
+    {
+        fprintf(stderr, "Hiba: a tömeges generálás csak üres világot tud benépesíteni.\n");
+        return false;
+    }
+    long long requested = 0;
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+        requested += counts[type] > 0 ? counts[type] : 0;
+    if (requested > world->entity_capacity)
+    {
+        fprintf(stderr, "Hiba: a kért %lld entitás meghaladja a kapacitást (%d).\n", requested, world->entity_capacity);
+        return false;
+    }
+
+    TileGrid tiles;
+    tiles.tiles_x = (world->width + GENERATOR_TILE - 1) / GENERATOR_TILE;
+    tiles.tiles_y = (world->height + GENERATOR_TILE - 1) / GENERATOR_TILE;
+    tiles.tile_count = tiles.tiles_x * tiles.tiles_y;
+
+    // quota[tile * ENTITY_TYPE_COUNT + type]; offsets: a csempe első entitásának indexe
+    int *quota = (int *)memory_calloc(MEMORY_GENERATOR, (size_t)tiles.tile_count * ENTITY_TYPE_COUNT, sizeof(int));
+    int *type_quota = (int *)memory_malloc(MEMORY_GENERATOR, (size_t)tiles.tile_count * sizeof(int));
+    double *weights = (double *)memory_malloc(MEMORY_GENERATOR, (size_t)tiles.tile_count * sizeof(double));
+    int *offsets = (int *)memory_malloc(MEMORY_GENERATOR, ((size_t)tiles.tile_count + 1) * sizeof(int));
+    if (!quota || !type_quota || !weights || !offsets)
+    {
+        perror("Hiba a világgenerátor segédtömbjeinek foglalásakor");
+        memory_free(MEMORY_GENERATOR, quota);
+        memory_free(MEMORY_GENERATOR, type_quota);
+        memory_free(MEMORY_GENERATOR, weights);
+        memory_free(MEMORY_GENERATOR, offsets);
+        return false;
+    }
+
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+    {
+        if (counts[type] <= 0)
+            continue;
+        distribute_count(world, &tiles, density ? density[type] : NULL, counts[type], weights, type_quota);
+        for (int tile = 0; tile < tiles.tile_count; tile++)
+            quota[(size_t)tile * ENTITY_TYPE_COUNT + type] = type_quota[tile];
+    }
+
+    // Túltelt csempék levágása (növények, majd növényevők, majd ragadozók), és prefix összeg
+    offsets[0] = 0;
+    for (int tile = 0; tile < tiles.tile_count; tile++)
+    {
+        int x0, y0, x1, y1;
+        tile_bounds(world, &tiles, tile, &x0, &y0, &x1, &y1);
+        int cells = (x1 - x0) * (y1 - y0);
+        int *tile_quota = &quota[(size_t)tile * ENTITY_TYPE_COUNT];
+        int total = 0;
+        for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
+            total += tile_quota[type];
+        for (int type = PLANT; type < ENTITY_TYPE_COUNT && total > cells; type++)
+        {
+            int cut = total - cells < tile_quota[type] ? total - cells : tile_quota[type];
+            tile_quota[type] -= cut;
+            total -= cut;
+        }
+        offsets[tile + 1] = offsets[tile] + total;
+    }
+
+    // Csempénként független mintavétel és beírás a végleges helyre
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int tile = 0; tile < tiles.tile_count; tile++)
+    {
+        int x0, y0, x1, y1;
+        tile_bounds(world, &tiles, tile, &x0, &y0, &x1, &y1);
+        int type_left[ENTITY_TYPE_COUNT];
+        for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+            type_left[type] = quota[(size_t)tile * ENTITY_TYPE_COUNT + type];
+        int needed = offsets[tile + 1] - offsets[tile];
+        if (needed == 0)
+            continue;
+
+        unsigned long long key = sim_random_mix64(seed ^ sim_random_mix64((unsigned long long)tile + 1));
+        unsigned long long counter = 0;
+        int cells_left = (x1 - x0) * (y1 - y0);
+        int next = offsets[tile];
+        for (int y = y0; y < y1 && needed > 0; y++)
+        {
+            for (int x = x0; x < x1 && needed > 0; x++, cells_left--)
+            {
+                // S algoritmus: a cella needed/cells_left valószínűséggel kerül be
+                if ((double)cells_left * tile_uniform(key, &counter) >= (double)needed)
+                    continue;
+
+                // A típus a még kiosztandó címkék közül egyenletesen (a címkék véletlen permutációja)
+                int pick = (int)(tile_uniform(key, &counter) * needed);
+                EntityType type = PLANT;
+                while (pick >= type_left[type])
+                    pick -= type_left[type++];
+                type_left[type]--;
+                needed--;
+
+                Entity *entity = &world->entities[next];
+                init_generated_entity(entity, next, type, x, y);
+                world->grid[y][x].entity = entity;
+                world_chunks_note_write(world, WORLD_CHUNKS_CURRENT, x, y);
+                next++;
+            }
+        }
+    }
+
+    world->entity_count = offsets[tiles.tile_count];
+    if (world->entity_count < requested)
+    {
+        fprintf(stderr, "Figyelem: %lld entitás nem fért el a (sűrűség szerint) túltelt csempékben.\n",
+                requested - world->entity_count);
+    }
+    world->next_entity_id = world->entity_count;
+    free_cell_index_invalidate(world->free_cells);
+
+    memory_free(MEMORY_GENERATOR, quota);
+    memory_free(MEMORY_GENERATOR, type_quota);
+    memory_free(MEMORY_GENERATOR, weights);
+    memory_free(MEMORY_GENERATOR, offsets);
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef WORLD_GENERATOR_H
+#define WORLD_GENERATOR_H
+
+#include <stdbool.h>
+
+#include "datatypes.h"        // Szükséges a World típushoz
+#include "lifecycle_kernel.h" // ENTITY_TYPE_COUNT
+
+// Párhuzamos, reprodukálható tömeges világgenerálás nagy (10^6-10^7 entitásos) világokhoz.
+// A világot GENERATOR_TILE × GENERATOR_TILE méretű csempékre osztjuk. Minden típus létszámát
+// a csempék súlya (sűrűségtérkép nélkül a cellaszám) arányában, kumulatív kerekítéssel osztjuk
+// szét, így az összeg pontos. A csempéken belül a szálak egymástól függetlenül, visszatevés
+// nélküli szekvenciális kiválasztással (Knuth S algoritmus) húzzák a cellákat, számláló alapú
+// véletlennel (seed, csempe, sorszám). Az entitások a csempék prefix összegéből kapják a helyüket
+// és az ID-jukat, így az eredmény a szálak számától független.
+#define GENERATOR_TILE 32
+
+// Sűrűségtérkép: relatív súlyok (0..1) egy tetszőleges felbontású rácson; a világ celláira
+// legközelebbi szomszéd alapon skálázzuk. A csempén belül az eloszlás egyenletes.
+typedef struct
+{
+    int width;
+    int height;
+    float *values;
+} DensityMap;
+
+// PGM (P2 szöveges vagy P5 bináris, 8/16 bites) kép betöltése sűrűségtérképként. Hiba esetén NULL.
+DensityMap *density_map_load_pgm(const char *path);
+void density_map_free(DensityMap *map);
+
+// Üres világ benépesítése: counts[PLANT/HERBIVORE/CARNIVORE] darab entitás, típusonként
+// opcionális sűrűségtérképpel (NULL: egyenletes). Hamis, ha a világ nem üres, vagy a kért
+// létszám meghaladja az entitáskapacitást. Ha egy csempe túltelne, a többlet elmarad
+// (elsőként a növényekből); az elhelyezett darabszám a world->entity_count.
+bool generate_world_bulk(World *world, const int counts[ENTITY_TYPE_COUNT],
+                         const DensityMap *const density[ENTITY_TYPE_COUNT], unsigned long long seed);
+
+#endif // WORLD_GENERATOR_H
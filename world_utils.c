@@ -4,104 +4,86 @@
 
 #include "world_utils.h"
 #include "simulation_constants.h"
+#include "sim_random.h"
+#include "deterministic_step.h"
+#include "lifecycle_kernel.h"
+#include "plant_layer.h"
+#include "population_stats.h"
+#include "world_arena.h"
+#include "free_cell_index.h"
+#include "species.h"
+#include "task_graph.h"
+#include "phase_tuner.h"
+#include "topology.h"
+#include "world_chunks.h"
 
 // Létrehozza és inicializálja a szimulációs világot a megadott méretekkel.
-// Lefoglalja a memóriát a világ struktúrának, a két rácsnak (grid és next_grid)
-// és a két listának (entities és next_entities).
+// A világ struktúrája, a két rács (grid és next_grid), a két lista (entities és next_entities)
+// és az életciklus segédtömbjei egyetlen arénában (leképezésben) kapnak helyet (lásd world_arena.h).
 World *create_world(int width, int height)
 {
-    World *world = (World *)malloc(sizeof(World));
+    return create_world_in_arena(width, height, false);
+}
+
+World *create_world_in_arena(int width, int height, bool huge_pages)
+{
+    // Egy cellában legfeljebb egy entitás lehet, így kis világban a cellaszám a kapacitás
+    long long cells = (long long)width * height;
+    return create_world_with_capacity(width, height, cells < MAX_TOTAL_ENTITIES ? (int)cells : MAX_TOTAL_ENTITIES, huge_pages, false);
+}
+
+World *create_world_with_capacity(int width, int height, int entity_capacity, bool huge_pages, bool chunked)
+{
+    World *world = world_arena_create(width, height, entity_capacity, huge_pages, chunked);
     if (!world)
-    {
-        perror("Hiba a világ struktúra memória foglalásakor");
         return NULL;
-    }
 
-    world->width = width;
-    world->height = height;
     world->entity_count = 0;
     world->next_entity_count = 0;
     world->next_entity_id = 0;
-    world->entity_capacity = MAX_TOTAL_ENTITIES;
-    world->next_entity_capacity = MAX_TOTAL_ENTITIES;
-
-    world->entities = (Entity *)malloc(MAX_TOTAL_ENTITIES * sizeof(Entity));
-    if (!world->entities)
+    for (int type = 0; type < ENTITY_TYPE_COUNT; type++)
+        world->population_cap[type] = species_table[type].max_population;
+    world->deterministic = false;
+    world->seed = 0;
+    world->det_scratch = NULL;
+    world->plants = NULL;
+    world->stats = NULL;
+    world->metrics = NULL;
+    world->latency = NULL;
+    world->task_graph = NULL;
+    world->publisher = NULL;
+    world->events = NULL;
+    world->tuner = NULL;
+    world->topology = topology_create(width, height);
+    if (!world->topology)
     {
-        perror("Hiba az aktuális entitások tömbjének memória foglalásakor");
-        free(world);
+        world_arena_destroy(world);
         return NULL;
     }
 
-    world->next_entities = (Entity *)malloc(MAX_TOTAL_ENTITIES * sizeof(Entity));
-    if (!world->next_entities)
-    {
-        perror("Hiba a következő entitások tömbjének memória foglalásakor");
-        free(world->entities);
-        free(world);
-        return NULL;
-    }
+    srand(time(NULL));
+    world->seed = (unsigned long long)time(NULL); // A cellánkénti (hash alapú) véletlenek alapja
+    return world;
+}
 
-    world->grid = (Cell **)malloc(height * sizeof(Cell *));
-    if (!world->grid)
-    {
-        perror("Hiba az aktuális rács sorainak memória foglalásakor");
-        free(world->next_entities);
-        free(world->entities);
-        free(world);
-        return NULL;
-    }
-    for (int i = 0; i < height; i++)
-    {
-        world->grid[i] = (Cell *)malloc(width * sizeof(Cell));
-        if (!world->grid[i])
-        {
-            perror("Hiba az aktuális rács celláinak memória foglalásakor");
-            for (int j = 0; j < i; j++)
-                free(world->grid[j]);
-            free(world->grid);
-            free(world->next_entities);
-            free(world->entities);
-            free(world);
-            return NULL;
-        }
-        for (int j = 0; j < width; j++)
-            world->grid[i][j].entity = NULL;
-    }
+// A világ újrahasznosítása azonos méretben, az aréna leképezésének megtartásával:
+// kiüríti a rácsokat és az entitáslistákat, és eldobja a növényréteget.
+// A determinisztikus mód, a statisztika és a mérési hivatkozások megmaradnak.
+void reset_world(World *world)
+{
+    if (!world)
+        return;
 
-    world->next_grid = (Cell **)malloc(height * sizeof(Cell *));
-    if (!world->next_grid)
-    {
-        perror("Hiba a következő rács sorainak memória foglalásakor");
-        for (int i = 0; i < height; i++)
-            free(world->grid[i]);
-        free(world->grid);
-        free(world->next_entities);
-        free(world->entities);
-        free(world);
-        return NULL;
-    }
-    for (int i = 0; i < height; i++)
-    {
-        world->next_grid[i] = (Cell *)malloc(width * sizeof(Cell));
-        if (!world->next_grid[i])
-        {
-            perror("Hiba a következő rács celláinak memória foglalásakor");
-            for (int j = 0; j < i; j++)
-                free(world->next_grid[j]);
-            free(world->next_grid);
-            for (int k = 0; k < height; k++)
-                free(world->grid[k]);
-            free(world->grid);
-            free(world->next_entities);
-            free(world->entities);
-            free(world);
-            return NULL;
-        }
-    }
+    plant_layer_free(world->plants);
+    world->plants = NULL;
+
+    world_arena_clear(world);
+    world->entity_count = 0;
+    world->next_entity_count = 0;
+    world->next_entity_id = 0;
 
     srand(time(NULL));
-    return world;
+    world->seed = (unsigned long long)time(NULL);
 }
 
 // Hozzáad egy új entitást a világhoz a szimuláció kezdeti feltöltése során.
@@ -121,9 +103,9 @@ Entity *add_entity_to_world_initial(World *world, EntityType type, Coordinates p
         return NULL; // Cella foglalt
     }
 
-    if (world->entity_count >= MAX_TOTAL_ENTITIES)
+    if (world->entity_count >= world->entity_capacity)
     {
-        fprintf(stderr, "Hiba: Elérte a maximális entitás számot (%d), nem lehet új entitást hozzáadni (kezdeti).\n", MAX_TOTAL_ENTITIES);
+        fprintf(stderr, "Hiba: Elérte a maximális entitás számot (%d), nem lehet új entitást hozzáadni (kezdeti).\n", world->entity_capacity);
         return NULL; // Nincs több hely
     }
 
@@ -139,6 +121,7 @@ Entity *add_entity_to_world_initial(World *world, EntityType type, Coordinates p
     new_entity->just_spawned_by_keypress = false; // Alapértelmezetten hamis
 
     world->grid[pos.y][pos.x].entity = new_entity;
+    world_chunks_note_write(world, WORLD_CHUNKS_CURRENT, pos.x, pos.y);
     world->entity_count++;
     return new_entity;
 }
@@ -151,99 +134,55 @@ void initialize_world(World *world, int num_plants, int num_herbivores, int num_
     if (!world)
         return;
 
-    int placed_count;
     Coordinates pos;
     int initial_age = 0;
 
-    // Növények
-    placed_count = 0;
-    for (int i = 0; i < num_plants; i++)
+    // Növények, növényevők, ragadozók: egyenletes eloszlású üres cellákra, a szabad cellák indexéből
+    const int counts[ENTITY_TYPE_COUNT] = {[PLANT] = num_plants, [HERBIVORE] = num_herbivores, [CARNIVORE] = num_carnivores};
+    for (int type = PLANT; type < ENTITY_TYPE_COUNT; type++)
     {
-        int attempts = 0;
-        do
-        {
-            pos.x = rand() % world->width;
-            pos.y = rand() % world->height;
-            attempts++;
-        } while (world->grid[pos.y][pos.x].entity != NULL && attempts < world->width * world->height * 2);
-        if (world->grid[pos.y][pos.x].entity == NULL)
-        {
-            add_entity_to_world_initial(world, PLANT, pos, PLANT_MAX_ENERGY / 2, initial_age, 0);
-            placed_count++;
-        }
+        const SpeciesInfo *species = species_info((EntityType)type);
+        for (int i = 0; i < counts[type] && take_random_free_cell(world, &pos); i++)
+            add_entity_to_world_initial(world, (EntityType)type, pos, species->initial_energy, initial_age, species->sight_range);
     }
-    // printf("%d/%d növény elhelyezve.\n", placed_count, num_plants); // Ezt a main logolhatja
-
-    // Növényevők
-    placed_count = 0;
-    for (int i = 0; i < num_herbivores; i++)
-    {
-        int attempts = 0;
-        do
-        {
-            pos.x = rand() % world->width;
-            pos.y = rand() % world->height;
-            attempts++;
-        } while (world->grid[pos.y][pos.x].entity != NULL && attempts < world->width * world->height * 2);
-        if (world->grid[pos.y][pos.x].entity == NULL)
-        {
-            add_entity_to_world_initial(world, HERBIVORE, pos, HERBIVORE_INITIAL_ENERGY, initial_age, HERBIVORE_SIGHT_RANGE);
-            placed_count++;
-        }
-    }
-    // printf("%d/%d növényevő elhelyezve.\n", placed_count, num_herbivores);
+}
 
-    // Ragadozók
-    placed_count = 0;
-    for (int i = 0; i < num_carnivores; i++)
-    {
-        int attempts = 0;
-        do
-        {
-            pos.x = rand() % world->width;
-            pos.y = rand() % world->height;
-            attempts++;
-        } while (world->grid[pos.y][pos.x].entity != NULL && attempts < world->width * world->height * 2);
-        if (world->grid[pos.y][pos.x].entity == NULL)
-        {
-            add_entity_to_world_initial(world, CARNIVORE, pos, CARNIVORE_INITIAL_ENERGY, initial_age, CARNIVORE_SIGHT_RANGE);
-            placed_count++;
-        }
-    }
-    // printf("%d/%d ragadozó elhelyezve.\n", placed_count, num_carnivores);
+// Egyenletes eloszlású üres cella választása és lefoglalása a szabad cellák indexében.
+// Hamis, ha a világ megtelt (ezt azonnal, próbálkozások nélkül jelzi). Ritka tárolásnál az index
+// csak a sort adja, a soron belül a darabkönyvtár keres; a rand() hívások és a kiválasztott cella
+// ugyanazok, mint sűrű tárolásnál.
+bool take_random_free_cell(World *world, Coordinates *out_pos)
+{
+    FreeCellIndex *index = world->free_cells;
+    if (!index->valid)
+        free_cell_index_rebuild(index, world);
+    if (index->free_total <= 0)
+        return false;
+
+    // Két rand() hívás a RAND_MAX-nál nagyobb világokhoz
+    unsigned long long random = ((unsigned long long)rand() << 31) ^ (unsigned long long)rand();
+    long long k = (long long)(random % (unsigned long long)index->free_total);
+    if (world->chunks ? !world_chunks_select_free_cell(world, k, out_pos) : !free_cell_index_select(index, k, out_pos))
+        return false;
+    free_cell_index_mark_occupied(index, out_pos->x, out_pos->y);
+    return true;
 }
 
-// Felszabadítja a World objektum és annak minden dinamikusan foglalt erőforrását.
-// rácsok sorai és maguk a rácso
-// az entitáslisták (entities, next_entities).
+// Felszabadítja a World objektum és annak minden dinamikusan foglalt erőforrását:
+// a kiegészítő rétegeket, majd az arénát (rácsok, entitáslisták, maga a World struktúra).
 void free_world(World *world)
 {
     if (!world)
         return;
 
-    if (world->grid)
-    {
-        for (int i = 0; i < world->height; i++)
-        {
-            if (world->grid[i])
-                free(world->grid[i]);
-        }
-        free(world->grid);
-    }
-    if (world->next_grid)
-    {
-        for (int i = 0; i < world->height; i++)
-        {
-            if (world->next_grid[i])
-                free(world->next_grid[i]);
-        }
-        free(world->next_grid);
-    }
-    if (world->entities)
-        free(world->entities);
-    if (world->next_entities)
-        free(world->next_entities);
-    free(world);
+    deterministic_mode_disable(world);
+    lifecycle_buffers_free(world->lifecycle);
+    plant_layer_free(world->plants);
+    population_stats_free(world->stats);
+    task_graph_free(world->task_graph);
+    phase_tuner_free(world->tuner);
+    topology_free(world->topology);
+    world_arena_destroy(world);
 }
 
 // Ellenőrzi, hogy egy adott (x, y) pozíció érvényes-e, azaz a világ határain belül esik-e.
@@ -253,62 +192,63 @@ int is_valid_pos(const World *world, int x, int y)
     return world && x >= 0 && x < world->width && y >= 0 && y < world->height;
 }
 
-Coordinates get_random_adjacent_empty_cell(World *world, Coordinates pos)
+// Igaz, ha a cellában nincs sem entitás, sem (növényréteg esetén) növény.
+bool is_cell_free(const World *world, int x, int y)
 {
-    Coordinates adjacent_cells[8];
-    int count = 0;
+    return world->grid[y][x].entity == NULL && !(world->plants && plant_layer_occupied(world->plants, x, y));
+}
 
-    // Szomszédos cellák (8 irány)
-    int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
-    int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+// Szomszédos cellák (8 irány); a szabad-szomszéd maszk i. bitje a (dx[i], dy[i]) eltolásé
+static const int neighbour_dx[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+static const int neighbour_dy[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
 
+// A topológia tábláiból: a szomszéd koordinátái körbefutva vagy a szélre szorítva, a
+// világon kívüli irányokat pedig a topológia iránymaszkja zárja ki. Nincs határ-elágazás.
+unsigned char free_neighbour_mask(const World *world, Coordinates pos)
+{
+    const Topology *topology = world->topology;
+    const int columns[3] = {topology->column[pos.x - 1], pos.x, topology->column[pos.x + 1]};
+    const int rows[3] = {topology->row[pos.y - 1], pos.y, topology->row[pos.y + 1]};
+    unsigned char mask = 0;
     for (int i = 0; i < 8; ++i)
     {
-        int nx = pos.x + dx[i];
-        int ny = pos.y + dy[i];
-
-        if (is_valid_pos(world, nx, ny) && world->grid[ny][nx].entity == NULL) // Az aktuális grid-et nézzük
-        {
-            adjacent_cells[count].x = nx;
-            adjacent_cells[count].y = ny;
-            count++;
-        }
+        int nx = columns[neighbour_dx[i] + 1];
+        int ny = rows[neighbour_dy[i] + 1];
+        mask |= (unsigned char)(is_cell_free(world, nx, ny) << i); // Az aktuális grid-et nézzük
     }
+    return mask & topology->column_mask[pos.x] & topology->row_mask[pos.y];
+}
 
-    if (count > 0)
-    {
-        return adjacent_cells[rand() % count];
-    }
-    else
-    {
+Coordinates pick_random_free_neighbour(const World *world, Coordinates pos, unsigned char mask)
+{
+    int count = __builtin_popcount(mask);
+    if (count == 0)
         return pos; // Nincs üres szomszédos cella
-    }
+
+    // A választott sorszámú szabad szomszéd (az irányok sorrendjében)
+    int pick = sim_rand() % count;
+    unsigned int bits = mask;
+    for (; pick > 0; pick--)
+        bits &= bits - 1;
+    int direction = __builtin_ctz(bits);
+    const Topology *topology = world->topology;
+    Coordinates next = {topology->column[pos.x + neighbour_dx[direction]], topology->row[pos.y + neighbour_dy[direction]]};
+    return next;
 }
 
-// Kiszámítja a következő lépés koordinátáit `current_pos`-ból `target_pos` felé.
-// A cél az, hogy egy lépéssel közelebb kerüljön a célponthoz a Manhattan-távolság csökkentésével.
-// Először megpróbál az X tengely mentén közeledni, majd az Y tengely mentén, vagy fordítva,
-// attól függően, melyik irányban nagyobb a távolság. Priorizálja azokat a lépéseket,
-// amelyek mindkét tengelyen csökkentik a távolságot (átlós lépés), ha lehetséges.
-// A függvény nem ellenőrzi, hogy a célcella (a lépés utáni pozíció) üres-e vagy érvényes-e.
-// Ezt a hívó félnek kell kezelnie, ha szükséges.
-// Ha a `current_pos` már megegyezik `target_pos`-szal, vagy nem tud közelebb lépni,
-// akkor `current_pos`-t adja vissza.
-Coordinates get_step_towards_target(World *world, Coordinates current_pos, Coordinates target_pos)
+Coordinates step_towards_target_masked(const World *world, Coordinates current_pos, Coordinates target_pos, unsigned char mask)
 {
+    const Topology *topology = world->topology;
     Coordinates best_step = current_pos;
-    int min_dist_sq = (target_pos.x - current_pos.x) * (target_pos.x - current_pos.x) +
-                      (target_pos.y - current_pos.y) * (target_pos.y - current_pos.y);
-
-    // 8 irány
-    int dx[] = {-1, 0, 1, -1, 1, -1, 0, 1};
-    int dy[] = {-1, -1, -1, 0, 0, 1, 1, 1};
+    int dx = topology_axis_distance(target_pos.x, current_pos.x, topology->span_x);
+    int dy = topology_axis_distance(target_pos.y, current_pos.y, topology->span_y);
+    int min_dist_sq = dx * dx + dy * dy;
 
     // random nézzük az iráynokat
     int order[] = {0, 1, 2, 3, 4, 5, 6, 7};
     for (int i = 0; i < 8; ++i)
     {
-        int r = i + (rand() % (8 - i));
+        int r = i + (sim_rand() % (8 - i));
         int temp = order[i];
         order[i] = order[r];
         order[r] = temp;
@@ -317,24 +257,42 @@ Coordinates get_step_towards_target(World *world, Coordinates current_pos, Coord
     for (int i = 0; i < 8; ++i)
     {
         int idx = order[i];
-        int next_x = current_pos.x + dx[idx];
-        int next_y = current_pos.y + dy[idx];
-
-        if (is_valid_pos(world, next_x, next_y) && world->grid[next_y][next_x].entity == NULL)
+        if (!(mask & (1u << idx)))
+            continue;
+        int next_x = topology->column[current_pos.x + neighbour_dx[idx]];
+        int next_y = topology->row[current_pos.y + neighbour_dy[idx]];
+        dx = topology_axis_distance(target_pos.x, next_x, topology->span_x);
+        dy = topology_axis_distance(target_pos.y, next_y, topology->span_y);
+        int dist_sq = dx * dx + dy * dy;
+        if (dist_sq < min_dist_sq)
         {
-            int dist_sq = (target_pos.x - next_x) * (target_pos.x - next_x) +
-                          (target_pos.y - next_y) * (target_pos.y - next_y);
-            if (dist_sq < min_dist_sq)
-            {
-                min_dist_sq = dist_sq;
-                best_step.x = next_x;
-                best_step.y = next_y;
-            }
+            min_dist_sq = dist_sq;
+            best_step.x = next_x;
+            best_step.y = next_y;
         }
     }
     return best_step;
 }
 
+Coordinates get_random_adjacent_empty_cell(World *world, Coordinates pos)
+{
+    return pick_random_free_neighbour(world, pos, free_neighbour_mask(world, pos));
+}
+
+// Kiszámítja a következő lépés koordinátáit `current_pos`-ból `target_pos` felé.
+// A cél az, hogy egy lépéssel közelebb kerüljön a célponthoz a Manhattan-távolság csökkentésével.
+// Először megpróbál az X tengely mentén közeledni, majd az Y tengely mentén, vagy fordítva,
+// attól függően, melyik irányban nagyobb a távolság. Priorizálja azokat a lépéseket,
+// amelyek mindkét tengelyen csökkentik a távolságot (átlós lépés), ha lehetséges.
+// A függvény nem ellenőrzi, hogy a célcella (a lépés utáni pozíció) üres-e vagy érvényes-e.
+// Ezt a hívó félnek kell kezelnie, ha szükséges.
+// Ha a `current_pos` már megegyezik `target_pos`-szal, vagy nem tud közelebb lépni,
+// akkor `current_pos`-t adja vissza.
+Coordinates get_step_towards_target(World *world, Coordinates current_pos, Coordinates target_pos)
+{
+    return step_towards_target_masked(world, current_pos, target_pos, free_neighbour_mask(world, current_pos));
+}
+
 // Megszámolja az adott `type` típusú entitásokat a `world->entities` listában.
 int count_entities_by_type(const World *world, EntityType type)
 {
@@ -342,6 +300,10 @@ int count_entities_by_type(const World *world, EntityType type)
         return 0;
 
     int count = 0;
+    if (type == PLANT && world->plants)
+    {
+        count += plant_layer_count(world->plants);
+    }
     for (int i = 0; i < world->entity_count; ++i)
     {
         if (world->entities[i].id >= 0 && world->entities[i].energy > 0 && world->entities[i].type == type)
@@ -350,4 +312,84 @@ int count_entities_by_type(const World *world, EntityType type)
         }
     }
     return count;
-}
\ No newline at end of file
+}
+
+// A világ állapotának 64 bites lenyomata (FNV-1a) regressziós összehasonlításokhoz.
+// Tartalmazza az entitások mezőit a tömb sorrendjében, az ID-számlálót és a rács foglaltságát
+// (cellánként a tulajdonos ID-ját). Determinisztikus módban különböző szálszámokkal futtatva
+// azonos lenyomatot kell adnia.
+unsigned long long world_state_hash(const World *world)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    if (!world)
+        return hash;
+
+#define HASH_INT(value)                                   \
+    do                                                    \
+    {                                                     \
+        unsigned int v_ = (unsigned int)(value);          \
+        for (int b_ = 0; b_ < 4; b_++)                    \
+        {                                                 \
+            hash ^= (v_ >> (8 * b_)) & 0xffu;             \
+            hash *= 0x100000001b3ULL;                     \
+        }                                                 \
+    } while (0)
+
+    HASH_INT(world->width);
+    HASH_INT(world->height);
+    HASH_INT(world->entity_count);
+    HASH_INT(world->next_entity_id);
+
+    for (int i = 0; i < world->entity_count; i++)
+    {
+        const Entity *e = &world->entities[i];
+        HASH_INT(e->id);
+        HASH_INT(e->type);
+        HASH_INT(e->position.x);
+        HASH_INT(e->position.y);
+        HASH_INT(e->energy);
+        HASH_INT(e->age);
+        HASH_INT(e->last_reproduction_step);
+        HASH_INT(e->last_eating_step);
+    }
+
+    // Csak a foglalt cellák, sorfolytonos sorrendben: így a lenyomat sűrű és ritka tárolásnál azonos,
+    // ritkánál pedig a le nem foglalt darabok kimaradnak (a lakott területtel arányos munka)
+    int chunk_width = world->chunks ? world->chunks->chunk_width : world->width;
+    for (int y = 0; y < world->height; y++)
+    {
+        for (int x0 = 0; x0 < world->width; x0 += chunk_width)
+        {
+            if (!world_chunks_resident(world, x0, y))
+                continue;
+            int x1 = x0 + chunk_width < world->width ? x0 + chunk_width : world->width;
+            for (int x = x0; x < x1; x++)
+            {
+                const Entity *e = world->grid[y][x].entity;
+                if (!e)
+                    continue;
+                HASH_INT(y);
+                HASH_INT(x);
+                HASH_INT(e->id);
+            }
+        }
+    }
+
+    if (world->plants)
+    {
+        const PlantLayer *layer = world->plants;
+        for (int i = 0; i < world->width * world->height; i++)
+        {
+            if (layer->energy[i])
+            {
+                HASH_INT(i);
+                HASH_INT(layer->energy[i]);
+                HASH_INT(layer->age[i]);
+                HASH_INT(layer->since_reproduction[i]);
+            }
+        }
+    }
+
+#undef HASH_INT
+    return hash;
+}
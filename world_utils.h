@@ -5,16 +5,35 @@
 
 // Világ létrehozása, inicializálása és felszabadítása
 World *create_world(int width, int height);
+// Mint a create_world, de nagy lapokat (huge pages) kér az aréna leképezéséhez.
+World *create_world_in_arena(int width, int height, bool huge_pages);
+// Mint a create_world_in_arena, de a MAX_TOTAL_ENTITIES helyett megadott entitáskapacitással;
+// chunked: ritka (darabolt) rácstárolás nagy, nagyrészt üres világokhoz (lásd world_chunks.h).
+World *create_world_with_capacity(int width, int height, int entity_capacity, bool huge_pages, bool chunked);
+// Újrahasznosítás azonos méretben, újraleképezés nélkül.
+void reset_world(World *world);
 void free_world(World *world);
 void initialize_world(World *world, int num_plants, int num_herbivores, int num_carnivores);
 Entity *add_entity_to_world_initial(World *world, EntityType type, Coordinates pos, int energy, int age, int sight_range);
+// Egyenletes eloszlású üres cella kiválasztása és lefoglalása (O(log H + W/64)). Hamis, ha a világ megtelt.
+bool take_random_free_cell(World *world, Coordinates *out_pos);
 
 // Pozíció és segédfüggvények
 int is_valid_pos(const World *world, int x, int y);
+bool is_cell_free(const World *world, int x, int y);
 Coordinates get_random_adjacent_empty_cell(World *world, Coordinates pos);
 Coordinates get_step_towards_target(World *world, Coordinates current_pos, Coordinates target_pos);
+// Ugyanezek egy előre kiszámolt szabad-szomszéd maszkkal (bit i: a 8 irány közül az i. szabad és érvényes).
+// A véletlenszám-fogyasztásuk megegyezik a fenti változatokéval.
+unsigned char free_neighbour_mask(const World *world, Coordinates pos);
+// Tóruszon a lépés körbefut, a távolság a rövidebb irány szerint számít (lásd topology.h).
+Coordinates pick_random_free_neighbour(const World *world, Coordinates pos, unsigned char mask);
+Coordinates step_towards_target_masked(const World *world, Coordinates current_pos, Coordinates target_pos, unsigned char mask);
 
 // Az információs sávhoz
 int count_entities_by_type(const World *world, EntityType type);
 
+// Állapot-lenyomat a szálszámok közötti regressziós ellenőrzéshez
+unsigned long long world_state_hash(const World *world);
+
 #endif // WORLD_UTILS_H
\ No newline at end of file